@@ -0,0 +1,53 @@
+// 由 server/gen_action_hash.py 根据 SYSTEM_PROMPT 自动生成，请勿手动修改
+#ifndef ACTION_HASH_H
+#define ACTION_HASH_H
+
+// 大模型可能输出的全部命令
+enum ActionId {
+    ACTION_FAN_ON,
+    ACTION_FAN_OFF,
+    ACTION_LIGHT_ON,
+    ACTION_LIGHT_OFF,
+    ACTION_FAN_SPEED_UP,
+    ACTION_FAN_SPEED_DOWN,
+    ACTION_FAN_HIGH,
+    ACTION_AC_ON,
+    ACTION_AC_OFF,
+    ACTION_GET_TEMPERATURE,
+    ACTION_GET_HUMIDITY,
+    ACTION_WINDOW_OPEN,
+    ACTION_WINDOW_CLOSE,
+    ACTION_STATUS,
+    ACTION_COUNT
+};
+
+static const char *const action_names[ACTION_COUNT] = {
+    "fan_on",
+    "fan_off",
+    "light_on",
+    "light_off",
+    "fan_speed_up",
+    "fan_speed_down",
+    "fan_high",
+    "ac_on",
+    "ac_off",
+    "get_temperature",
+    "get_humidity",
+    "window_open",
+    "window_close",
+    "status",
+};
+
+#define ACTION_HASH_SEED 28u
+#define ACTION_HASH_BITS 5
+#define ACTION_HASH_SIZE (1 << ACTION_HASH_BITS)
+
+// 槽位 -> 命令编号，-1 表示空槽
+static const signed char action_hash_slots[ACTION_HASH_SIZE] = {
+    10, -1, -1, -1, 12,  6, -1, 13,
+     8, -1,  2, -1, -1, -1, -1,  1,
+     0,  4,  9,  3, -1, 11, -1, -1,
+    -1, -1, -1, -1, -1,  5,  7, -1,
+};
+
+#endif // ACTION_HASH_H
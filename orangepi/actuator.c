@@ -0,0 +1,307 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <wiringPi.h>
+#include <softPwm.h>
+#include "actuator.h"
+#include "dht11.h"
+#include "sensor_history.h"
+#include "trace.h"
+
+struct ActionEntry;
+typedef int (*action_fn)(const struct ActionEntry *entry);
+
+// 动作表中的一项：处理函数 + 引脚 + 参数 + 对应的设备状态
+struct ActionEntry {
+    action_fn run;
+    int pin;
+    int arg;
+    int *state;
+    const char *desc;
+};
+
+// 设备状态只在执行线程中读写
+static int light_state = 0;
+static int fan_speed = 0;
+static int ac_state = 0;
+static int window_state = 0;   // 1 打开，0 关闭
+
+static int gpio_set(const struct ActionEntry *e) {
+    digitalWrite(e->pin, e->arg);
+    *e->state = e->arg;
+    return 0;
+}
+
+// 逐步调整风扇 PWM 到目标转速
+static void fan_ramp_to(int target) {
+    if (target < 0) {
+        target = 0;
+    } else if (target > FAN_PWM_RANGE) {
+        target = FAN_PWM_RANGE;
+    }
+    while (fan_speed != target) {
+        fan_speed += fan_speed < target ? 1 : -1;
+        softPwmWrite(ACTUATOR_PIN_FAN, fan_speed);
+        delay(FAN_RAMP_STEP_MS);
+    }
+}
+
+static int fan_set(const struct ActionEntry *e) {
+    fan_ramp_to(e->arg);
+    return 0;
+}
+
+static int fan_step(const struct ActionEntry *e) {
+    if (fan_speed == 0 && e->arg < 0) {
+        return 0;  // 风扇没开，调低无效
+    }
+    fan_ramp_to(fan_speed + e->arg);
+    return 0;
+}
+
+// 窗户电机：先断开反向引脚，再驱动固定时长
+static int window_move(const struct ActionEntry *e) {
+    int other = e->pin == ACTUATOR_PIN_WINDOW_OPEN ? ACTUATOR_PIN_WINDOW_CLOSE
+                                                   : ACTUATOR_PIN_WINDOW_OPEN;
+    digitalWrite(other, LOW);
+    digitalWrite(e->pin, HIGH);
+    delay(WINDOW_MOTOR_MS);
+    digitalWrite(e->pin, LOW);
+    *e->state = e->arg;
+    return 0;
+}
+
+// 读数由 DHT11 采样线程在后台更新，这里只取最新值，不会阻塞在传感器时序上
+static int sensor_read(const struct ActionEntry *e) {
+    (void)e;
+    struct Dht11Reading r;
+    if (dht11_latest(&r) != 0) {
+        printf("温湿度传感器暂无有效读数\n");
+        return -1;
+    }
+    printf("温度 %d.%d℃，湿度 %d.%d%%（%llu ms 前测量）\n",
+           r.temperature_x10 / 10, r.temperature_x10 % 10,
+           r.humidity_x10 / 10, r.humidity_x10 % 10, (unsigned long long)r.age_ms);
+    return 0;
+}
+
+static int report_status(const struct ActionEntry *e) {
+    (void)e;
+    printf("设备状态：灯%s，风扇%d%%，空调%s，窗户%s\n",
+           light_state ? "开" : "关", fan_speed,
+           ac_state ? "开" : "关", window_state ? "开" : "关");
+    char history[256];
+    if (sensor_history_describe(24, history, sizeof(history)) == 0) {
+        printf("%s\n", history);
+    }
+    return sensor_read(e);
+}
+
+// 命令 -> 动作，顺序与 action_hash.h 中的 ActionId 对应
+static const struct ActionEntry action_table[ACTION_COUNT] = {
+    [ACTION_FAN_ON]          = { fan_set,       ACTUATOR_PIN_FAN, FAN_SPEED_DEFAULT, &fan_speed, "打开风扇" },
+    [ACTION_FAN_OFF]         = { fan_set,       ACTUATOR_PIN_FAN, 0, &fan_speed, "关闭风扇" },
+    [ACTION_FAN_SPEED_UP]    = { fan_step,      ACTUATOR_PIN_FAN, FAN_SPEED_STEP, &fan_speed, "风扇加速" },
+    [ACTION_FAN_SPEED_DOWN]  = { fan_step,      ACTUATOR_PIN_FAN, -FAN_SPEED_STEP, &fan_speed, "风扇减速" },
+    [ACTION_FAN_HIGH]        = { fan_set,       ACTUATOR_PIN_FAN, FAN_PWM_RANGE, &fan_speed, "风扇最高档" },
+    [ACTION_LIGHT_ON]        = { gpio_set,      ACTUATOR_PIN_LIGHT, HIGH, &light_state, "开灯" },
+    [ACTION_LIGHT_OFF]       = { gpio_set,      ACTUATOR_PIN_LIGHT, LOW, &light_state, "关灯" },
+    [ACTION_AC_ON]           = { gpio_set,      ACTUATOR_PIN_AC, HIGH, &ac_state, "打开空调" },
+    [ACTION_AC_OFF]          = { gpio_set,      ACTUATOR_PIN_AC, LOW, &ac_state, "关闭空调" },
+    [ACTION_GET_TEMPERATURE] = { sensor_read,   -1, 0, NULL, "读取温度" },
+    [ACTION_GET_HUMIDITY]    = { sensor_read,   -1, 0, NULL, "读取湿度" },
+    [ACTION_WINDOW_OPEN]     = { window_move,   ACTUATOR_PIN_WINDOW_OPEN, 1, &window_state, "打开窗户" },
+    [ACTION_WINDOW_CLOSE]    = { window_move,   ACTUATOR_PIN_WINDOW_CLOSE, 0, &window_state, "关闭窗户" },
+    [ACTION_STATUS]          = { report_status, -1, 0, NULL, "查询状态" },
+};
+
+// 待执行动作
+struct ActionRequest {
+    int id;
+    uint64_t enqueue_ns;
+};
+
+static struct ActionRequest queue[ACTUATOR_QUEUE_SIZE];
+static size_t queue_head = 0;
+static size_t queue_count = 0;
+static int running = 0;
+static pthread_t worker_tid;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ActionStats stats[ACTION_COUNT];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// 与 server/gen_action_hash.py 中的 slot_of() 保持一致
+static uint32_t action_hash(const char *cmd) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)cmd; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return ((h ^ ACTION_HASH_SEED) * 0x9E3779B1u) >> (32 - ACTION_HASH_BITS);
+}
+
+int actuator_lookup(const char *cmd) {
+    int id = action_hash_slots[action_hash(cmd)];
+    if (id < 0 || strcmp(action_names[id], cmd) != 0) {
+        return -1;
+    }
+    return id;
+}
+
+// 执行线程：依次取出动作执行，慢动作（风扇渐变、窗户电机）不会阻塞语音流水线
+static void *actuator_thread_func(void *arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&queue_lock);
+        while (queue_count == 0 && running) {
+            pthread_cond_wait(&queue_cond, &queue_lock);
+        }
+        if (queue_count == 0) {
+            pthread_mutex_unlock(&queue_lock);
+            break;
+        }
+        struct ActionRequest req = queue[queue_head];
+        queue_head = (queue_head + 1) % ACTUATOR_QUEUE_SIZE;
+        queue_count--;
+        pthread_mutex_unlock(&queue_lock);
+
+        const struct ActionEntry *e = &action_table[req.id];
+        uint64_t start = now_ns();
+        int rc = e->run(e);
+        uint64_t end = now_ns();
+        printf("动作 %s（%s）%s，耗时 %.1f ms\n", action_names[req.id], e->desc,
+               rc == 0 ? "完成" : "失败", (end - start) / 1e6);
+        trace_record_span(SPAN_GPIO, end - req.enqueue_ns);  // 排队加执行
+
+        pthread_mutex_lock(&stats_lock);
+        struct ActionStats *s = &stats[req.id];
+        s->count++;
+        if (rc != 0) {
+            s->failed++;
+        }
+        s->wait_ns += start - req.enqueue_ns;
+        s->run_ns += end - start;
+        if (end - start > s->max_run_ns) {
+            s->max_run_ns = end - start;
+        }
+        pthread_mutex_unlock(&stats_lock);
+    }
+    return NULL;
+}
+
+int actuator_init(void) {
+    for (int i = 0; i < ACTION_COUNT; i++) {
+        if (!action_table[i].run) {
+            fprintf(stderr, "动作表缺少命令 %s 的处理函数\n", action_names[i]);
+            return -1;
+        }
+    }
+
+    pinMode(ACTUATOR_PIN_LIGHT, OUTPUT);
+    pinMode(ACTUATOR_PIN_AC, OUTPUT);
+    pinMode(ACTUATOR_PIN_WINDOW_OPEN, OUTPUT);
+    pinMode(ACTUATOR_PIN_WINDOW_CLOSE, OUTPUT);
+    digitalWrite(ACTUATOR_PIN_LIGHT, LOW);
+    digitalWrite(ACTUATOR_PIN_AC, LOW);
+    digitalWrite(ACTUATOR_PIN_WINDOW_OPEN, LOW);
+    digitalWrite(ACTUATOR_PIN_WINDOW_CLOSE, LOW);
+    if (softPwmCreate(ACTUATOR_PIN_FAN, 0, FAN_PWM_RANGE) != 0) {
+        fprintf(stderr, "创建风扇 PWM 失败\n");
+        return -1;
+    }
+
+    running = 1;
+    if (pthread_create(&worker_tid, NULL, actuator_thread_func, NULL) != 0) {
+        fprintf(stderr, "创建执行线程失败\n");
+        running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void actuator_shutdown(void) {
+    pthread_mutex_lock(&queue_lock);
+    if (!running) {
+        pthread_mutex_unlock(&queue_lock);
+        return;
+    }
+    running = 0;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+    pthread_join(worker_tid, NULL);
+}
+
+int actuator_submit(const char *cmd) {
+    int id = actuator_lookup(cmd);
+    if (id < 0) {
+        printf("未识别动作：%s\n", cmd);
+        return -1;
+    }
+
+    pthread_mutex_lock(&queue_lock);
+    if (!running || queue_count == ACTUATOR_QUEUE_SIZE) {
+        pthread_mutex_unlock(&queue_lock);
+        pthread_mutex_lock(&stats_lock);
+        stats[id].dropped++;
+        pthread_mutex_unlock(&stats_lock);
+        printf("动作队列已满，丢弃：%s\n", cmd);
+        return -1;
+    }
+    struct ActionRequest *req = &queue[(queue_head + queue_count) % ACTUATOR_QUEUE_SIZE];
+    req->id = id;
+    req->enqueue_ns = now_ns();
+    queue_count++;
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+    return 0;
+}
+
+int actuator_sensor_reply(const char *cmd, char *msg, size_t size) {
+    int id = actuator_lookup(cmd);
+    if (id != ACTION_GET_TEMPERATURE && id != ACTION_GET_HUMIDITY) {
+        return -1;
+    }
+
+    struct Dht11Reading r;
+    if (dht11_latest(&r) != 0) {
+        snprintf(msg, size, "抱歉，温湿度传感器暂时没有读数。");
+        return 0;
+    }
+    int value = id == ACTION_GET_TEMPERATURE ? r.temperature_x10 : r.humidity_x10;
+    const char *age = r.age_ms < 60000 ? "" : "（读数已超过一分钟）";
+    if (id == ACTION_GET_TEMPERATURE) {
+        snprintf(msg, size, "当前室内温度是%d.%d摄氏度。%s", value / 10, value % 10, age);
+    } else {
+        snprintf(msg, size, "当前室内湿度为%d.%d%%。%s", value / 10, value % 10, age);
+    }
+    return 0;
+}
+
+void actuator_report(FILE *out) {
+    struct ActionStats snapshot[ACTION_COUNT];
+    pthread_mutex_lock(&stats_lock);
+    memcpy(snapshot, stats, sizeof(snapshot));
+    pthread_mutex_unlock(&stats_lock);
+
+    fprintf(out, "---- 动作统计 ----\n");
+    for (int i = 0; i < ACTION_COUNT; i++) {
+        const struct ActionStats *s = &snapshot[i];
+        if (s->count == 0 && s->dropped == 0) {
+            continue;
+        }
+        fprintf(out, "%-16s 执行 %lu 次（失败 %lu，丢弃 %lu），平均排队 %.1f ms，平均执行 %.1f ms，最长 %.1f ms\n",
+                action_names[i], s->count, s->failed, s->dropped,
+                s->count ? s->wait_ns / 1e6 / s->count : 0.0,
+                s->count ? s->run_ns / 1e6 / s->count : 0.0,
+                s->max_run_ns / 1e6);
+    }
+}
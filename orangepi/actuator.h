@@ -0,0 +1,51 @@
+#ifndef ACTUATOR_H
+#define ACTUATOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "action_hash.h"
+
+// 执行器引脚（wiringPi 编号）。GPIO 6 已被 DHT11 占用（见 dht11.c 的 pinNumber）
+#define ACTUATOR_PIN_LIGHT 7          // 灯继电器
+#define ACTUATOR_PIN_FAN 1            // 风扇调速（软件 PWM）
+#define ACTUATOR_PIN_AC 10            // 空调继电器
+#define ACTUATOR_PIN_WINDOW_OPEN 3    // 窗户电机正转
+#define ACTUATOR_PIN_WINDOW_CLOSE 4   // 窗户电机反转
+
+#define FAN_PWM_RANGE 100             // 风扇 PWM 满量程
+#define FAN_SPEED_DEFAULT 50          // 打开风扇时的默认转速
+#define FAN_SPEED_STEP 25             // 调速档位间隔
+#define FAN_RAMP_STEP_MS 20           // 风扇转速每变化 1 的间隔，避免电流冲击
+#define WINDOW_MOTOR_MS 3000          // 窗户电机单次运行时长
+
+#define ACTUATOR_QUEUE_SIZE 16        // 待执行动作队列长度，满了直接丢弃
+
+// 单个动作的执行统计（只由执行线程更新，报告时加锁读取）
+struct ActionStats {
+    unsigned long count;       // 执行次数
+    unsigned long failed;      // 执行失败次数
+    unsigned long dropped;     // 队列已满被丢弃的次数
+    uint64_t wait_ns;          // 累计排队时间
+    uint64_t run_ns;           // 累计执行时间
+    uint64_t max_run_ns;       // 单次最长执行时间
+};
+
+// 初始化执行器引脚并启动执行线程（需在 wiringPiSetup 之后调用）
+int actuator_init(void);
+
+// 等待队列中的动作执行完并停止执行线程
+void actuator_shutdown(void);
+
+// 通过完美哈希查找命令编号，未知命令返回 -1
+int actuator_lookup(const char *cmd);
+
+// 把命令放入执行队列后立即返回，不等待动作完成；未知命令或队列已满返回 -1
+int actuator_submit(const char *cmd);
+
+// 温湿度查询命令：用传感器最新读数生成回答（替换训练数据中的固定数值），其他命令返回 -1
+int actuator_sensor_reply(const char *cmd, char *msg, size_t size);
+
+// 输出各动作的执行次数和耗时
+void actuator_report(FILE *out);
+
+#endif // ACTUATOR_H
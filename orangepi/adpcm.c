@@ -0,0 +1,97 @@
+#include "adpcm.h"
+
+// IMA/DVI ADPCM 标准表
+static const int index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static const int step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+void adpcm_init(struct AdpcmState *state) {
+    state->predictor = 0;
+    state->index = 0;
+}
+
+static inline int clamp_sample(int value) {
+    return value > 32767 ? 32767 : value < -32768 ? -32768 : value;
+}
+
+static inline int clamp_index(int index) {
+    return index < 0 ? 0 : index > 88 ? 88 : index;
+}
+
+// 编码一个采样，返回 4 位码字并更新状态（解码端按同样的方式重建预测值）
+static inline int encode_sample(struct AdpcmState *state, int sample) {
+    int step = step_table[state->index];
+    int diff = sample - state->predictor;
+    int code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    int vpdiff = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        vpdiff += step;
+    }
+
+    state->predictor = clamp_sample(code & 8 ? state->predictor - vpdiff : state->predictor + vpdiff);
+    state->index = clamp_index(state->index + index_table[code]);
+    return code;
+}
+
+static inline int decode_sample(struct AdpcmState *state, int code) {
+    int step = step_table[state->index];
+    int vpdiff = step >> 3;
+    if (code & 4) vpdiff += step;
+    if (code & 2) vpdiff += step >> 1;
+    if (code & 1) vpdiff += step >> 2;
+
+    state->predictor = clamp_sample(code & 8 ? state->predictor - vpdiff : state->predictor + vpdiff);
+    state->index = clamp_index(state->index + index_table[code]);
+    return state->predictor;
+}
+
+size_t adpcm_encode(struct AdpcmState *state, const short *pcm, size_t samples, unsigned char *out) {
+    size_t i;
+    for (i = 0; i + 1 < samples; i += 2) {
+        int hi = encode_sample(state, pcm[i]);
+        int lo = encode_sample(state, pcm[i + 1]);
+        *out++ = (unsigned char)((hi << 4) | lo);
+    }
+    if (i < samples) {
+        *out = (unsigned char)(encode_sample(state, pcm[i]) << 4);
+    }
+    return ADPCM_ENCODED_SIZE(samples);
+}
+
+void adpcm_decode(struct AdpcmState *state, const unsigned char *in, size_t bytes, short *pcm) {
+    for (size_t i = 0; i < bytes; i++) {
+        *pcm++ = (short)decode_sample(state, in[i] >> 4);
+        *pcm++ = (short)decode_sample(state, in[i] & 0x0f);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <stddef.h>
+
+// 上传前用 IMA-ADPCM 把 16 位 PCM 压缩为每采样 4 位（4:1），设为 0 时发送原始 PCM
+#ifndef STT_ADPCM
+#define STT_ADPCM 1
+#endif
+
+// 与服务器约定的内容类型：单声道、无文件头，编码器初始状态为 0，每字节高 4 位是前一个采样
+// （与 Python audioop.lin2adpcm 的格式一致）
+#define ADPCM_CONTENT_TYPE "audio/x-ima-adpcm"
+
+// samples 个采样编码后的字节数
+#define ADPCM_ENCODED_SIZE(samples) (((samples) + 1) / 2)
+
+// 编解码器状态，同一段音频的连续分块共用一个状态
+struct AdpcmState {
+    int predictor;  // 上一个采样的预测值
+    int index;      // 步长表下标
+};
+
+void adpcm_init(struct AdpcmState *state);
+
+// 编码 samples 个采样到 out，返回写入的字节数；采样数为奇数时最后一个字节低 4 位补 0
+size_t adpcm_encode(struct AdpcmState *state, const short *pcm, size_t samples, unsigned char *out);
+
+// 把 bytes 字节解码为 2 * bytes 个采样
+void adpcm_decode(struct AdpcmState *state, const unsigned char *in, size_t bytes, short *pcm);
+
+#endif // ADPCM_H
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "arena.h"
+
+#define ARENA_ALIGN 16
+
+int arena_init(struct Arena *arena, size_t capacity) {
+    arena->base = malloc(capacity);
+    if (!arena->base) {
+        fprintf(stderr, "arena 分配失败（%zu 字节）\n", capacity);
+        return -1;
+    }
+    arena->capacity = capacity;
+    arena->used = 0;
+    arena->high_water = 0;
+    return 0;
+}
+
+void arena_free(struct Arena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+void *arena_alloc(struct Arena *arena, size_t size) {
+    size_t offset = (arena->used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (offset > arena->capacity || size > arena->capacity - offset) {
+        fprintf(stderr, "arena 容量不足：需要 %zu 字节，剩余 %zu 字节\n",
+                size, arena->capacity - arena->used);
+        return NULL;
+    }
+    arena->used = offset + size;
+    if (arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+    }
+    return arena->base + offset;
+}
+
+void arena_reset(struct Arena *arena) {
+    arena->used = 0;
+}
+
+int memory_init(struct Memory *mem, struct Arena *arena, size_t capacity) {
+    mem->data = arena_alloc(arena, capacity);
+    if (!mem->data) {
+        mem->capacity = 0;
+        return -1;
+    }
+    mem->capacity = capacity;
+    mem->size = 0;
+    mem->data[0] = '\0';
+    return 0;
+}
+
+size_t memory_write_callback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsz = size * nmemb;
+    struct Memory *mem = (struct Memory *)userp;
+
+    if (mem->capacity == 0) {
+        // 未预先分配时按需扩容
+        char *ptr = realloc(mem->data, mem->size + realsz + 1);
+        if (!ptr) {
+            fprintf(stderr, "内存分配失败\n");
+            return 0;
+        }
+        mem->data = ptr;
+    } else if (mem->size + realsz + 1 > mem->capacity) {
+        fprintf(stderr, "响应超过缓冲区容量 %zu 字节\n", mem->capacity);
+        return 0;  // cURL 以 CURLE_WRITE_ERROR 结束请求
+    }
+
+    memcpy(mem->data + mem->size, contents, realsz);
+    mem->size += realsz;
+    mem->data[mem->size] = '\0';
+    return realsz;
+}
+
+#ifdef USE_DEBUG
+static atomic_ulong alloc_counter = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    atomic_fetch_add_explicit(&alloc_counter, 1, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+    atomic_fetch_add_explicit(&alloc_counter, 1, memory_order_relaxed);
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    atomic_fetch_add_explicit(&alloc_counter, 1, memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+
+unsigned long alloc_count(void) {
+    return atomic_load_explicit(&alloc_counter, memory_order_relaxed);
+}
+#else
+unsigned long alloc_count(void) {
+    return 0;
+}
+#endif
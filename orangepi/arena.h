@@ -0,0 +1,41 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// 线性分配器：启动时一次性申请整块内存，按需切分，整体复位后重复使用
+// 每条语音持有一个 arena，录音开始时复位，稳态下不再向堆申请内存
+struct Arena {
+    unsigned char *base;
+    size_t capacity;
+    size_t used;
+    size_t high_water;  // 历史最高用量，便于调整容量
+};
+
+// 定长响应缓冲区（cURL 写回调的目标），容量用尽时请求失败而不是扩容
+struct Memory {
+    char *data;
+    size_t size;
+    size_t capacity;    // 0 表示按需 realloc 扩容（兼容旧用法）
+};
+
+int arena_init(struct Arena *arena, size_t capacity);
+void arena_free(struct Arena *arena);
+
+// 分配 16 字节对齐的内存，容量不足返回 NULL
+void *arena_alloc(struct Arena *arena, size_t size);
+
+// 释放 arena 上的全部分配
+void arena_reset(struct Arena *arena);
+
+// 从 arena 中切出定长响应缓冲区
+int memory_init(struct Memory *mem, struct Arena *arena, size_t capacity);
+
+// cURL 写回调：把响应追加到 struct Memory，始终以 '\0' 结尾
+size_t memory_write_callback(void *contents, size_t size, size_t nmemb, void *userp);
+
+// 调试计数：USE_DEBUG 构建下链接时包装 malloc/calloc/realloc（见 Makefile），
+// 返回本程序代码累计调用次数（不含 libcurl、json-c 等库内部的分配）；非调试构建恒为 0
+unsigned long alloc_count(void);
+
+#endif // ARENA_H
@@ -1,18 +1,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <alsa/asoundlib.h>
 #include <curl/curl.h>
 #include <json-c/json.h>
 #include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <fvad.h>
 
+#include "ring_buffer.h"
+#include "vad_endpoint.h"
+#include "audio_recognition.h"
+#include "http_client.h"
+#include "server_health.h"
+#include "frontend.h"
+#include "capture_source.h"
+
 // 定义常量
-#define PCM_DEVICE "plughw:3,0"     // 使用 plughw 接口，使 ALSA 自动转换采样率
-#define RATE 16000                  // 目标采样率：16kHz
-#define DESIRED_PERIOD 320          // 每个 period 320 帧（约 20ms 数据）
-#define API_URL "http://192.168.2.118:8000/stt/"  // 根据实际修改API地址
+#define RATE AUDIO_RATE             // 目标采样率：16kHz
 #define WAV_HEADER_SIZE 44         // 新增：WAV文件头大小
+#define CAPTURE_RING_SLOTS 512      // 采集环形缓冲区槽位数（512 个 period，约 10 秒）
 
 // WAV 文件头结构（新增）
 #pragma pack(push, 1)
@@ -34,93 +42,153 @@ typedef struct {
 #pragma pack(pop)
 
 // 全局变量
-snd_pcm_t* pcm_handle = NULL;
-snd_pcm_uframes_t period_size_glob = 0; // 实际的 period size
+size_t period_size_glob = 0; // 实际的 period size
 Fvad* fvad_instance = NULL;
 
-/* 初始化音频设备和 libfvad */
-int init_audio_device() {
-    int rc;
-    snd_pcm_hw_params_t *params;
-    unsigned int rate = RATE;
-    snd_pcm_uframes_t desired_period = DESIRED_PERIOD;
-    
-    // 打开 PCM 设备（使用 plughw 自动转换采样率）
-    rc = snd_pcm_open(&pcm_handle, PCM_DEVICE, SND_PCM_STREAM_CAPTURE, 0);
-    if (rc < 0) {
-        fprintf(stderr, "无法打开 PCM 设备 %s: %s\n", PCM_DEVICE, snd_strerror(rc));
-        return -1;
-    }
-    
-    snd_pcm_hw_params_alloca(&params);
-    rc = snd_pcm_hw_params_any(pcm_handle, params);
-    if (rc < 0) {
-        fprintf(stderr, "无法获取硬件参数: %s\n", snd_strerror(rc));
-        return -1;
-    }
+// 端点检测：参数可在 init_audio_device 之前通过 set_vad_config 修改
+static struct VadConfig vad_config = {
+    .frame_ms = 0,  // 0 表示按实际 period size 计算
+    .pre_roll_ms = VAD_DEFAULT_PRE_ROLL_MS,
+    .onset_ms = VAD_DEFAULT_ONSET_MS,
+    .hangover_ms = VAD_DEFAULT_HANGOVER_MS,
+    .max_utterance_ms = VAD_DEFAULT_MAX_UTTERANCE_MS,
+};
+static struct VadEndpoint vad_endpoint;
 
-    // === 关键修改1：设置交错模式 ===
-    rc = snd_pcm_hw_params_set_access(pcm_handle, params, SND_PCM_ACCESS_RW_INTERLEAVED);
-    if (rc < 0) {
-        fprintf(stderr, "无法设置访问模式: %s\n", snd_strerror(rc));
-        return -1;
+// 采集与 VAD 之间的前端：去直流、自动增益、能量门限（只在录音线程中使用）
+static struct FrontendConfig frontend_config = {
+    .gate_dbfs = FRONTEND_DEFAULT_GATE_DBFS,
+    .target_dbfs = FRONTEND_DEFAULT_TARGET_DBFS,
+    .max_gain = FRONTEND_DEFAULT_MAX_GAIN,
+};
+static struct Frontend frontend;
+static short *conditioned_frame = NULL;  // 前端处理后的一帧
+// 前端状态只在录音线程中修改，其它线程通过 get_input_levels 读取加锁保存的快照
+static pthread_mutex_t levels_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct FrontendLevels last_levels;
+static unsigned long levels_frames, levels_gated;
+
+void set_vad_config(const struct VadConfig *config) {
+    vad_config = *config;
+}
+
+void set_frontend_config(const struct FrontendConfig *config) {
+    frontend_config = *config;
+}
+
+void get_input_levels(struct FrontendLevels *levels, unsigned long *frames, unsigned long *gated) {
+    pthread_mutex_lock(&levels_lock);
+    if (levels) *levels = last_levels;
+    if (frames) *frames = levels_frames;
+    if (gated) *gated = levels_gated;
+    pthread_mutex_unlock(&levels_lock);
+}
+
+// 采集线程：持续从采集源读取数据写入环形缓冲区，不受网络和磁盘阻塞影响
+// 采集源默认为 ALSA 设备，也可以在 init_audio_device 之前通过 set_capture_source 换成 WAV 回放
+// ALSA 参数可在 init_audio_device 之前通过 set_capture_config 修改
+static struct CaptureSource alsa_source;
+static struct AlsaCaptureConfig alsa_config = {
+    .device = CAPTURE_ALSA_DEVICE,
+    .rate = AUDIO_RATE,
+    .period = AUDIO_PERIOD,
+    .buffer_periods = CAPTURE_ALSA_BUFFER_PERIODS,
+    .mmap = 1,
+};
+static struct CaptureSource *capture_source = NULL;
+static struct ring_buffer capture_ring;
+static pthread_t capture_tid;
+static atomic_int capture_running = 0;
+static atomic_ulong capture_dropped = 0;  // 环形缓冲区满（或事件循环没有空闲语音槽位）而丢弃的 period 数
+
+void set_capture_source(struct CaptureSource *src) {
+    capture_source = src;
+}
+
+void set_capture_config(const struct AlsaCaptureConfig *config) {
+    alsa_config = *config;
+}
+
+static void *capture_thread_func(void *arg) {
+    (void)arg;
+    // 环形缓冲区满时仍需读走设备数据，避免 ALSA 溢出
+    short *scratch = malloc(period_size_glob * sizeof(short));
+    if (!scratch) {
+        fprintf(stderr, "采集线程内存分配失败\n");
+        atomic_store(&capture_running, 0);
+        ring_buffer_wakeup(&capture_ring);
+        return NULL;
     }
 
-    // 设置采样率
-    rc = snd_pcm_hw_params_set_rate_near(pcm_handle, params, &rate, 0);
-    if (rc < 0) {
-        fprintf(stderr, "无法设置采样率: %s\n", snd_strerror(rc));
-        return -1;
+    while (atomic_load(&capture_running)) {
+        short *slot = ring_buffer_write_slot(&capture_ring);
+        short *dst = slot ? slot : scratch;
+
+        int rc = capture_source->read(capture_source, dst);
+        if (rc <= 0) {
+            if (rc == 0) {
+                printf("采集源 %s 已读完\n", capture_source->name);
+            }
+            atomic_store(&capture_running, 0);
+            break;
+        }
+
+        if (slot) {
+            ring_buffer_commit(&capture_ring);
+        } else {
+            atomic_fetch_add(&capture_dropped, 1);
+        }
     }
-    
-    // 设置音频格式（16位小端）
-    rc = snd_pcm_hw_params_set_format(pcm_handle, params, SND_PCM_FORMAT_S16_LE);
-    if (rc < 0) {
-        fprintf(stderr, "无法设置音频格式: %s\n", snd_strerror(rc));
+
+    free(scratch);
+    ring_buffer_wakeup(&capture_ring);  // 唤醒可能阻塞的消费者
+    return NULL;
+}
+
+/* 启动采集线程 */
+static int start_capture_thread() {
+    if (ring_buffer_init(&capture_ring, CAPTURE_RING_SLOTS, period_size_glob) != 0) {
         return -1;
     }
-    
-    // 设置为单声道
-    rc = snd_pcm_hw_params_set_channels(pcm_handle, params, 1);
-    if (rc < 0) {
-        fprintf(stderr, "无法设置通道数: %s\n", snd_strerror(rc));
+    atomic_store(&capture_running, 1);
+    if (pthread_create(&capture_tid, NULL, capture_thread_func, NULL) != 0) {
+        fprintf(stderr, "无法创建采集线程\n");
+        atomic_store(&capture_running, 0);
+        ring_buffer_free(&capture_ring);
         return -1;
     }
-    
-    // 设置期望 period size 为 DESIRED_PERIOD（320帧）
-    rc = snd_pcm_hw_params_set_period_size_near(pcm_handle, params, &desired_period, 0);
-    if (rc < 0) {
-        fprintf(stderr, "无法设置 period size: %s\n", snd_strerror(rc));
-        return -1;
-    }
-    
-    // === 关键修改2：获取实际设置的period size ===
-    snd_pcm_hw_params_get_period_size(params, &period_size_glob, 0);
-    printf("实际period size: %lu 帧\n", (unsigned long)period_size_glob);
-    
-    // 设置缓冲区大小，例如为 period 的 4 倍
-    snd_pcm_uframes_t buffer_size = period_size_glob * 4;
-    rc = snd_pcm_hw_params_set_buffer_size_near(pcm_handle, params, &buffer_size);
-    if (rc < 0) {
-        fprintf(stderr, "无法设置缓冲区大小: %s\n", snd_strerror(rc));
-        return -1;
+    return 0;
+}
+
+/* 获取采集统计：ALSA 溢出次数和因缓冲区满而丢弃的 period 数 */
+void get_capture_stats(unsigned long *xruns, unsigned long *dropped) {
+    if (xruns) *xruns = capture_source ? atomic_load(&capture_source->xruns) : 0;
+    if (dropped) *dropped = atomic_load(&capture_dropped);
+}
+
+/* 初始化采集源（未指定时打开 ALSA 设备）、libfvad、端点检测和音频前端 */
+static int open_audio_device() {
+    if (!capture_source) {
+        if (capture_source_open_alsa(&alsa_source, &alsa_config) != 0) {
+            return -1;
+        }
+        capture_source = &alsa_source;
     }
-    
-    rc = snd_pcm_hw_params(pcm_handle, params);
-    if (rc < 0) {
-        fprintf(stderr, "无法设置硬件参数: %s\n", snd_strerror(rc));
+    if (capture_source->rate != RATE) {
+        fprintf(stderr, "采集源采样率为 %uHz，需要 %dHz\n", capture_source->rate, RATE);
         return -1;
     }
-    
-    printf("设备采样率：%d Hz, period size：%lu, 缓冲区大小：%lu\n",
-           RATE, (unsigned long)period_size_glob, (unsigned long)buffer_size);
-    
-    rc = snd_pcm_prepare(pcm_handle);
-    if (rc < 0) {
-        fprintf(stderr, "无法准备 PCM 设备: %s\n", snd_strerror(rc));
+    period_size_glob = capture_source->period;
+    // libfvad 只接受 10/20/30ms 的帧，设备调整后的 period 必须仍是其中之一
+    if (period_size_glob * 1000 % RATE != 0 ||
+        (period_size_glob * 1000 / RATE != 10 && period_size_glob * 1000 / RATE != 20 &&
+         period_size_glob * 1000 / RATE != 30)) {
+        fprintf(stderr, "period 为 %zu 帧（%.1f ms），VAD 只支持 10/20/30 ms\n",
+                period_size_glob, period_size_glob * 1000.0 / RATE);
         return -1;
     }
-    
+    printf("采集源：%s\n", capture_source->name);
+
     // 初始化 libfvad 实例
     fvad_instance = fvad_new();
     if (!fvad_instance) {
@@ -135,147 +203,320 @@ int init_audio_device() {
         fprintf(stderr, "无法设置 VAD 采样率为 %dHz\n", RATE);
         return -1;
     }
-    
-    return 0;
-}
-
-/* 写入 WAV 文件头（新增函数） */
-void write_wav_header(FILE *file, uint32_t data_size) {
-    WAVHeader header = {0};
-    memcpy(header.riff, "RIFF", 4);
-    header.overall_size = data_size + WAV_HEADER_SIZE - 8;
-    memcpy(header.wave, "WAVE", 4);
-    memcpy(header.fmt_chunk_marker, "fmt ", 4);
-    header.length_of_fmt = 16;
-    header.format_type = 1;
-    header.channels = 1;
-    header.sample_rate = RATE;
-    header.byterate = RATE * 2;        // 16000 * 1 * 2
-    header.block_align = 2;
-    header.bits_per_sample = 16;
-    memcpy(header.data_chunk_header, "data", 4);
-    header.data_size = data_size;
 
-    fwrite(&header, sizeof(WAVHeader), 1, file);
-}
+    // 初始化端点检测状态机，帧长与实际 period 一致
+    vad_config.frame_ms = period_size_glob * 1000 / RATE;
+    if (vad_endpoint_init(&vad_endpoint, fvad_instance, &vad_config, period_size_glob) != 0) {
+        return -1;
+    }
+    printf("端点检测：预录 %d ms，起点 %d ms，尾音 %d ms，最长 %d ms\n",
+           vad_config.pre_roll_ms, vad_config.onset_ms, vad_config.hangover_ms, vad_config.max_utterance_ms);
 
-/* 从 PCM 设备读取音频数据：先检测 0.5s 语音，再持续录制至人声停止 */
-int record_audio_to_file(const char *file_path) {
-    remove(file_path);
-    short *buffer = malloc(period_size_glob * sizeof(short));
-    if (!buffer) {
-        fprintf(stderr, "内存分配失败\n");
+    frontend_init(&frontend, &frontend_config);
+    conditioned_frame = malloc(period_size_glob * sizeof(short));
+    if (!conditioned_frame) {
+        fprintf(stderr, "前端缓冲区分配失败\n");
         return -1;
     }
+    printf("音频前端：静音门限 %.0f dBFS，目标电平 %.0f dBFS，最大增益 %.0f 倍\n",
+           frontend_config.gate_dbfs, frontend_config.target_dbfs, frontend_config.max_gain);
 
-    short *detect_buffer = malloc(25 * period_size_glob * sizeof(short));  // 用于0.5秒的检测
-    if (!detect_buffer) {
-        fprintf(stderr, "检测缓存分配失败\n");
-        free(buffer);
+    return 0;
+}
+
+int init_audio_device() {
+    if (open_audio_device() != 0) {
         return -1;
     }
+    // 启动常驻采集线程
+    return start_capture_thread();
+}
+
+int init_audio_device_polled() {
+    return open_audio_device();
+}
+
+struct CaptureSource *get_capture_source(void) {
+    return capture_source;
+}
+
+void audio_drop_frame(void) {
+    atomic_fetch_add(&capture_dropped, 1);
+}
 
-    // printf("开始 0.5 秒语音检测...\n");
-    int voice_found = 0;
-    size_t detect_frames = 0;
+/* 在内存中填写 WAV 文件头 */
+static void fill_wav_header(WAVHeader *header, uint32_t data_size) {
+    memset(header, 0, sizeof(WAVHeader));
+    memcpy(header->riff, "RIFF", 4);
+    header->overall_size = data_size + WAV_HEADER_SIZE - 8;
+    memcpy(header->wave, "WAVE", 4);
+    memcpy(header->fmt_chunk_marker, "fmt ", 4);
+    header->length_of_fmt = 16;
+    header->format_type = 1;
+    header->channels = 1;
+    header->sample_rate = RATE;
+    header->byterate = RATE * 2;        // 16000 * 1 * 2
+    header->block_align = 2;
+    header->bits_per_sample = 16;
+    memcpy(header->data_chunk_header, "data", 4);
+    header->data_size = data_size;
+}
 
-    // 检测阶段：采集 0.5 秒用于 VAD 检测
-    for (size_t i = 0; i < 25; ++i) {
-        int rc = snd_pcm_readi(pcm_handle, buffer, period_size_glob);
-        if (rc < 0) {
-            if (rc == -EPIPE) { snd_pcm_prepare(pcm_handle); --i; continue; }
-            if (rc == -EAGAIN) { usleep(1000); --i; continue; }
-            fprintf(stderr, "读取错误(检测阶段): %s\n", snd_strerror(rc));
-            free(buffer);
-            free(detect_buffer);
+/* 单条语音的最大字节数（含 WAV 文件头）：预录 + 起点 + 最长语音时长，需在 init_audio_device 之后调用 */
+size_t audio_buffer_max_bytes(void) {
+    return WAV_HEADER_SIZE + (vad_endpoint.pre_roll_frames +
+           (size_t)(vad_config.max_utterance_ms + vad_config.frame_ms - 1) / vad_config.frame_ms) *
+           period_size_glob * sizeof(short);
+}
+
+void audio_buffer_attach(struct AudioBuffer *buf, void *mem, size_t capacity) {
+    buf->data = mem;
+    buf->capacity = capacity;
+    buf->size = 0;
+    buf->fixed = 1;
+}
+
+/* 清空音频缓冲区并预留 WAV 文件头的位置，未分配时按最长语音一次性分配 */
+static int audio_buffer_reset(struct AudioBuffer *buf) {
+    if (!buf->data) {
+        buf->capacity = audio_buffer_max_bytes();
+        buf->fixed = 0;
+        buf->data = malloc(buf->capacity);
+        if (!buf->data) {
+            fprintf(stderr, "音频缓冲区分配失败\n");
+            buf->capacity = 0;
+            return -1;
+        }
+    }
+    buf->size = WAV_HEADER_SIZE;
+    return 0;
+}
+
+/* 向音频缓冲区追加 PCM 数据；自行分配的缓冲区容量不足时倍增，外部提供的定长缓冲区不扩容 */
+static int audio_buffer_append(struct AudioBuffer *buf, const short *pcm, size_t samples) {
+    size_t bytes = samples * sizeof(short);
+    if (buf->size + bytes > buf->capacity) {
+        if (buf->fixed) {
+            fprintf(stderr, "音频缓冲区已满（%zu 字节）\n", buf->capacity);
             return -1;
         }
-        if (fvad_process(fvad_instance, buffer, rc) == 1) {
-            voice_found = 1;
+        size_t new_capacity = buf->capacity * 2;
+        while (buf->size + bytes > new_capacity) {
+            new_capacity *= 2;
+        }
+        unsigned char *ptr = realloc(buf->data, new_capacity);
+        if (!ptr) {
+            fprintf(stderr, "音频缓冲区扩容失败\n");
+            return -1;
         }
-        memcpy(detect_buffer + detect_frames, buffer, rc * sizeof(short));
-        detect_frames += rc;
+        buf->data = ptr;
+        buf->capacity = new_capacity;
     }
+    memcpy(buf->data + buf->size, pcm, bytes);
+    buf->size += bytes;
+    return 0;
+}
 
-    // 如果没有检测到人声，则重新开始录制
-    if (!voice_found) {
-        free(detect_buffer);
-        free(buffer);
-        return record_audio_to_file(file_path);  // 重新开始录制
+void audio_buffer_free(struct AudioBuffer *buf) {
+    if (!buf->fixed) {
+        free(buf->data);
     }
+    buf->data = NULL;
+    buf->size = 0;
+    buf->capacity = 0;
+}
+
+const short *audio_buffer_pcm(const struct AudioBuffer *buf, size_t *samples) {
+    *samples = buf->size > WAV_HEADER_SIZE ? (buf->size - WAV_HEADER_SIZE) / sizeof(short) : 0;
+    return (const short *)(buf->data + WAV_HEADER_SIZE);
+}
 
-    // 打开文件以追加内容
-    FILE *file = fopen(file_path, "a+b");  // 使用追加模式
+/* 调试用：把内存中的 WAV 数据保存为文件 */
+int save_audio_buffer(const struct AudioBuffer *buf, const char *file_path) {
+    FILE *file = fopen(file_path, "wb");
     if (!file) {
         fprintf(stderr, "无法打开文件写入: %s\n", file_path);
-        free(buffer);
-        free(detect_buffer);
         return -1;
     }
+    size_t written = fwrite(buf->data, 1, buf->size, file);
+    fclose(file);
+    return written == buf->size ? 0 : -1;
+}
 
-    // 写入 WAV 文件头（空头）
-    write_wav_header(file, 0);
-    uint32_t total_data_size = 0;
-    fwrite(detect_buffer, sizeof(short), detect_frames, file);
-    total_data_size += detect_frames * sizeof(short);
+/* 读取 WAV 文件（文件头原样保留，不检查格式） */
+int load_audio_buffer(struct AudioBuffer *buf, const char *file_path) {
+    FILE *file = fopen(file_path, "rb");
+    if (!file) {
+        fprintf(stderr, "无法打开文件: %s\n", file_path);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < WAV_HEADER_SIZE) {
+        fprintf(stderr, "不是有效的 WAV 文件: %s\n", file_path);
+        fclose(file);
+        return -1;
+    }
+    if ((size_t)size > buf->capacity) {
+        unsigned char *ptr = buf->fixed ? NULL : realloc(buf->data, size);
+        if (!ptr) {
+            fprintf(stderr, "音频缓冲区放不下 %s（%ld 字节）\n", file_path, size);
+            fclose(file);
+            return -1;
+        }
+        buf->data = ptr;
+        buf->capacity = size;
+    }
+    buf->size = fread(buf->data, 1, size, file);
+    fclose(file);
+    return buf->size == (size_t)size ? 0 : -1;
+}
 
-    free(detect_buffer);
-    printf("检测到人声，开始持续录制，直到人声停止...\n");
+static int stt_stream_start(struct SttStream *stream, struct AudioBuffer *buf, struct Memory *response,
+                            struct Trace *trace);
+static void stt_stream_finish(struct SttStream *stream);
+
+/* 追加录音数据；流式上传时加锁（缓冲区可能扩容）并唤醒上传线程 */
+static int record_append(struct AudioBuffer *buf, struct SttStream *stream,
+                         const short *pcm, size_t samples) {
+    if (!stream) {
+        return audio_buffer_append(buf, pcm, samples);
+    }
+    pthread_mutex_lock(&stream->lock);
+    int rc = audio_buffer_append(buf, pcm, samples);
+    pthread_cond_signal(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+    return rc;
+}
+
+// 端点检测输出回调的上下文
+struct record_ctx {
+    struct AudioBuffer *buf;
+    struct SttStream *stream;
+};
+
+static int record_emit(const short *pcm, size_t samples, void *userp) {
+    struct record_ctx *ctx = (struct record_ctx *)userp;
+    return record_append(ctx->buf, ctx->stream, pcm, samples);
+}
+
+static float utterance_peak_dbfs;  // 本段语音的输入峰值（只在录音线程或事件循环中访问）
+
+/* 开始录制一段语音：清空缓冲区并复位端点检测 */
+static int record_begin(struct AudioBuffer *buf) {
+    if (audio_buffer_reset(buf) != 0) {
+        return -1;
+    }
+    vad_endpoint_reset(&vad_endpoint);
+    utterance_peak_dbfs = -96.0f;
+    return 0;
+}
+
+/* 处理一帧：前端处理后再做端点检测，录音和上传的也是处理后的音频
+ * 返回端点检测事件，说话起止时记录时间点 */
+static int record_frame(const short *frame, struct record_ctx *ctx, struct Trace *trace) {
+    struct FrontendLevels levels;
+    frontend_process(&frontend, frame, conditioned_frame, period_size_glob, &levels);
+    pthread_mutex_lock(&levels_lock);
+    last_levels = levels;
+    levels_frames = frontend.frames;
+    levels_gated = frontend.gated;
+    pthread_mutex_unlock(&levels_lock);
+
+    int event = vad_endpoint_process_gated(&vad_endpoint, conditioned_frame, levels.gated,
+                                           record_emit, ctx);
+    if (vad_endpoint.state == VAD_STATE_SPEECH && levels.peak_dbfs > utterance_peak_dbfs) {
+        utterance_peak_dbfs = levels.peak_dbfs;
+    }
+    if (event == VAD_EVENT_START) {
+        trace_mark(trace, TRACE_SPEECH_ONSET);
+        printf("检测到人声，开始持续录制，直到人声停止...\n");
+    } else if (event == VAD_EVENT_END) {
+        trace_mark(trace, TRACE_SPEECH_END);
+    }
+    return event;
+}
+
+/* 录音结束：就地更新 WAV 文件头中的数据大小并输出统计 */
+static void record_end(struct AudioBuffer *buf) {
+    uint32_t total_data_size = buf->size - WAV_HEADER_SIZE;
+    fill_wav_header((WAVHeader *)buf->data, total_data_size);
+
+    unsigned long xruns, dropped;
+    get_capture_stats(&xruns, &dropped);
+    printf("录制完成，共 %.2f 秒音频（溢出 %lu 次，丢弃 %lu 个 period）\n",
+           total_data_size / (float)(RATE * 2), xruns, dropped);
+    printf("输入峰值 %.1f dBFS，当前增益 %.1f dB\n", utterance_peak_dbfs,
+           20.0f * log10f(frontend.gain));
+}
+
+/* 从采集环形缓冲区逐帧读取音频，由端点检测状态机判断语音起止
+ * 录音直接写入内存缓冲区，WAV 文件头在缓冲区开头就地生成
+ * stream 不为 NULL 时，确认人声后立即开始流式上传，录音结束即上传结束 */
+static int record_utterance(struct AudioBuffer *buf, struct SttStream *stream, struct Memory *response,
+                            struct Trace *trace) {
+    if (record_begin(buf) != 0) {
+        return -1;
+    }
+
+    struct record_ctx ctx = { buf, stream };
+    int rc = 0;
 
-    // 继续录制直到没有人声
-    int silence_counter = 0;  // 连续无声周期计数器
-    int max_silence_counter = 5;  // 设置最大无声周期（6个周期，即3秒）
-    
     while (1) {
-        int rc = snd_pcm_readi(pcm_handle, buffer, period_size_glob);
-        if (rc < 0) {
-            if (rc == -EPIPE) { snd_pcm_prepare(pcm_handle); continue; }
-            if (rc == -EAGAIN) { usleep(1000); continue; }
-            fprintf(stderr, "读取错误(录制阶段): %s\n", snd_strerror(rc));
+        const short *frame = ring_buffer_read_slot(&capture_ring);
+        if (!frame) {
+            fprintf(stderr, "采集线程已停止\n");
+            rc = -1;
             break;
         }
-    
-        // 判断是否有人声
-        if (fvad_process(fvad_instance, buffer, rc) == 1) {
-            // 有人声，继续录制
-            fwrite(buffer, sizeof(short), rc, file);
-            total_data_size += rc * sizeof(short);
-            silence_counter = 0;  // 重置无声计数器
-        } else {
-            // 无人声，增加无声计数器
-            silence_counter++;
-            if (silence_counter >= max_silence_counter) {  // 连续3秒无声后停止
-                break;
+        int event = record_frame(frame, &ctx, trace);
+        ring_buffer_release(&capture_ring);
+
+        if (event < 0) {
+            rc = -1;
+            break;
+        }
+        if (event == VAD_EVENT_START) {
+            // 已确认人声，开始流式上传（预录音频会最先发出）
+            if (stream && stt_stream_start(stream, buf, response, trace) != 0) {
+                return -1;
             }
-            usleep(500000);  // 延时0.5秒继续检测
+        } else if (event == VAD_EVENT_END) {
+            break;
         }
     }
 
-    // 更新 WAV 文件头中的数据大小
-    fseek(file, 0, SEEK_SET);
-    write_wav_header(file, total_data_size);
-    fclose(file);
-    free(buffer);
-
-    printf("录制完成，共 %.2f 秒音频，保存到 %s\n", total_data_size / (float)(RATE * 2), file_path);
+    // 结束流式上传：上传线程发送完剩余数据后结束 chunked 请求体
+    if (stream) {
+        stt_stream_finish(stream);
+    }
+    if (rc != 0) {
+        return rc;
+    }
+    record_end(buf);
     return 0;
 }
 
-/* 以下函数为 API 示例部分（可根据实际需求调整） */
-
-size_t write_callback(void *ptr, size_t size, size_t nmemb, void *userdata) {
-    // 计算收到的数据大小
-    size_t real_size = size * nmemb;
-
-    // 将响应数据追加到 response_data
-    strncat((char*)userdata, (char*)ptr, real_size);
+int audio_listen_start(struct AudioBuffer *buf) {
+    return record_begin(buf);
+}
 
-    // 打印接收到的响应数据（调试时可以检查）
-    printf("Received response: %s\n", (char*)userdata);
+int audio_feed_frame(struct AudioBuffer *buf, const short *frame, struct Trace *trace) {
+    struct record_ctx ctx = { buf, NULL };
+    int event = record_frame(frame, &ctx, trace);
+    if (event == VAD_EVENT_END) {
+        record_end(buf);
+    }
+    return event;
+}
 
-    return real_size;
+int record_audio(struct AudioBuffer *buf, struct Trace *trace) {
+    return record_utterance(buf, NULL, NULL, trace);
 }
 
+/* 以下函数为 API 示例部分（可根据实际需求调整） */
+
 int handle_api_response(const char *response, char *recognized_text) {
     printf("语音转文字API响应: %s\n", response);  // 打印原始的 API 响应
 
@@ -284,103 +525,537 @@ int handle_api_response(const char *response, char *recognized_text) {
 
     // 解析 JSON 响应
     parsed_json = json_tokener_parse(response);
-    if (json_object_object_get_ex(parsed_json, "text", &text)) {
+    if (parsed_json && json_object_object_get_ex(parsed_json, "text", &text)) {
         snprintf(recognized_text, 1024, "%s", json_object_get_string(text));
+        json_object_put(parsed_json);
         return 0;
     } else {
         printf("API响应中未找到 'text' 字段: %s\n", response);  // 提示找不到 "text" 字段
+        if (parsed_json) {
+            json_object_put(parsed_json);
+        }
         return -1;
     }
 }
 
 
-// 上传文件进行识别
-int upload_audio_to_api(const char *audio_file_path, char *response_data) {
-    CURL *curl;
+// 上传时从内存缓冲区读取数据的游标
+struct upload_cursor {
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+    struct Trace *trace;      // 数据全部读出时记录 TRACE_UPLOAD_END
+#if STT_ADPCM
+    struct AdpcmState adpcm;  // data/size/offset 指向 PCM 部分，边读边编码
+#endif
+};
+
+#if STT_ADPCM
+// cURL mime 读取回调：从录音缓冲区取 PCM，直接编码到 cURL 的发送缓冲区
+static size_t upload_read_callback(char *dest, size_t size, size_t nitems, void *userp) {
+    struct upload_cursor *cursor = (struct upload_cursor *)userp;
+    size_t room_samples = size * nitems * 2;
+    size_t left_samples = (cursor->size - cursor->offset) / 2;
+    size_t samples = left_samples < room_samples ? left_samples : room_samples;
+    size_t n = adpcm_encode(&cursor->adpcm, (const short *)(cursor->data + cursor->offset),
+                            samples, (unsigned char *)dest);
+    cursor->offset += samples * 2;
+    if (cursor->offset >= cursor->size) {
+        trace_mark(cursor->trace, TRACE_UPLOAD_END);
+    }
+    return n;
+}
+
+// 编码器有状态，重发请求时只能从头开始
+static int upload_seek_callback(void *userp, curl_off_t offset, int origin) {
+    struct upload_cursor *cursor = (struct upload_cursor *)userp;
+    if (origin != SEEK_SET || offset != 0) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    cursor->offset = 0;
+    adpcm_init(&cursor->adpcm);
+    return CURL_SEEKFUNC_OK;
+}
+#else
+// cURL mime 读取回调：直接从录音缓冲区拷贝到 cURL 的发送缓冲区，不产生额外副本
+static size_t upload_read_callback(char *dest, size_t size, size_t nitems, void *userp) {
+    struct upload_cursor *cursor = (struct upload_cursor *)userp;
+    size_t room = size * nitems;
+    size_t left = cursor->size - cursor->offset;
+    size_t n = left < room ? left : room;
+    memcpy(dest, cursor->data + cursor->offset, n);
+    cursor->offset += n;
+    if (cursor->offset == cursor->size) {
+        trace_mark(cursor->trace, TRACE_UPLOAD_END);
+    }
+    return n;
+}
+
+// cURL 重发请求时（如重定向、认证）回到缓冲区开头
+static int upload_seek_callback(void *userp, curl_off_t offset, int origin) {
+    struct upload_cursor *cursor = (struct upload_cursor *)userp;
+    if (origin != SEEK_SET || offset < 0 || (size_t)offset > cursor->size) {
+        return CURL_SEEKFUNC_FAIL;
+    }
+    cursor->offset = (size_t)offset;
+    return CURL_SEEKFUNC_OK;
+}
+#endif
+
+// 上传内存中的 WAV 数据进行识别（使用 http_client 中长期复用的 /stt/ 连接）
+int upload_audio_to_api(const struct AudioBuffer *buf, struct Memory *response, struct Trace *trace) {
+    CURL *curl = http_client_handle(HTTP_ENDPOINT_STT);
     CURLcode res;
-    FILE *file = fopen(audio_file_path, "rb");
-    if (!file) {
-        fprintf(stderr, "无法打开文件: %s\n", audio_file_path);
+    struct HttpTiming timing;
+#if STT_ADPCM
+    struct upload_cursor cursor = { .data = buf->data + WAV_HEADER_SIZE,
+                                    .size = buf->size - WAV_HEADER_SIZE, .trace = trace };
+    adpcm_init(&cursor.adpcm);
+    curl_off_t part_size = ADPCM_ENCODED_SIZE(cursor.size / 2);
+#else
+    struct upload_cursor cursor = { buf->data, buf->size, 0, trace };
+    curl_off_t part_size = (curl_off_t)buf->size;
+#endif
+
+    if (!curl) {
+        fprintf(stderr, "CURL 未初始化\n");
         return -1;
     }
 
-    // 获取文件大小
-    fseek(file, 0, SEEK_END);
-    fseek(file, 0, SEEK_SET);  // 将文件指针重新指向文件开头
+    // 构建 multipart/form-data 请求，数据通过回调从内存读取
+    curl_mime *mime = curl_mime_init(curl);
+    curl_mimepart *part = curl_mime_addpart(mime);
+    curl_mime_name(part, "audio");  // 对应 FastAPI 中的参数名 "audio"
+#if STT_ADPCM
+    curl_mime_filename(part, "recorded_audio.adpcm");
+    curl_mime_type(part, ADPCM_CONTENT_TYPE);  // 服务器按内容类型选择解码方式
+#else
+    curl_mime_filename(part, "recorded_audio.wav");
+    curl_mime_type(part, "audio/wav");  // 设置正确的内容类型
+#endif
+    curl_mime_data_cb(part, part_size,
+                      upload_read_callback, upload_seek_callback, NULL, &cursor);
 
-    // 初始化 cURL
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl = curl_easy_init();
+    // 设置 HTTP POST 表单数据（URL、超时和请求头已在 http_client_init 中预设）
+    curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
 
-    if (curl) {
-        struct curl_httppost *post = NULL;  // 用于构建 multipart/form-data 请求
-        struct curl_httppost *last = NULL;
+    // 设置响应回调函数，将响应数据写入定长缓冲区 response
+    response->size = 0;
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, memory_write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
 
-        // 添加文件数据到 multipart/form-data 请求
-        curl_formadd(&post, &last,
-                     CURLFORM_COPYNAME, "audio",  // 对应 FastAPI 中的参数名 "audio"
-                     CURLFORM_FILE, audio_file_path, // 上传文件路径
-                     CURLFORM_CONTENTTYPE, "audio/wav", // 设置正确的内容类型
-                     CURLFORM_END);
+    // 执行请求
+    trace_mark(trace, TRACE_UPLOAD_START);
+    res = http_client_perform(HTTP_ENDPOINT_STT, trace ? trace->id : NULL, &timing);
+    trace_mark(trace, TRACE_STT_REPLY);
+    curl_easy_setopt(curl, CURLOPT_MIMEPOST, NULL);  // mime 即将释放，解除引用
+    curl_mime_free(mime);
 
-        // 设置 API URL
-        curl_easy_setopt(curl, CURLOPT_URL, API_URL);
+    if (res != CURLE_OK) {
+        fprintf(stderr, "上传失败: %s\n", curl_easy_strerror(res));
+        return -1;
+    }
 
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10); // 设置最大超时为10秒
+    printf("音频上传成功，耗时 %.1f ms（连接 %.1f ms，传输 %.1f ms，新建连接 %ld）\n",
+           timing.total_ms, timing.connect_ms, timing.transfer_ms, timing.new_connections);
+    return 0;
+}
 
-        // 设置 HTTP POST 表单数据
-        curl_easy_setopt(curl, CURLOPT_HTTPPOST, post);
 
-        // 设置响应回调函数，将响应数据写入 response_data
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, response_data);
+// 流式上传是否有数据可发（或录音已结束，可以结束请求体）
+static int stream_ready(const struct AudioBuffer *buf, size_t offset, int finished) {
+#if STT_ADPCM
+    return finished || buf->size - offset >= 4;  // 录音结束前只编码成对的采样
+#else
+    return finished || offset < buf->size;
+#endif
+}
 
-        // 执行请求
-        res = curl_easy_perform(curl);
-        
-        if (res != CURLE_OK) {
-            fprintf(stderr, "上传失败: %s\n", curl_easy_strerror(res));
-            curl_easy_cleanup(curl);
-            fclose(file);
-            curl_global_cleanup();
-            return -1;
-        } else {
-            printf("音频上传成功\n");
+// 从 offset 处取出最多 room 字节的上传数据（STT_ADPCM 时每字节编码两个采样），返回 0 表示已发完
+static size_t stream_take(const struct AudioBuffer *buf, size_t *offset, int finished,
+                          struct AdpcmState *adpcm, char *dest, size_t room) {
+#if STT_ADPCM
+    size_t left_samples = (buf->size - *offset) / 2;
+    if (!finished) {
+        left_samples &= ~(size_t)1;
+    }
+    size_t samples = left_samples < room * 2 ? left_samples : room * 2;
+    size_t n = adpcm_encode(adpcm, (const short *)(buf->data + *offset), samples, (unsigned char *)dest);
+    *offset += samples * 2;
+    return n;
+#else
+    (void)finished; (void)adpcm;
+    size_t left = buf->size - *offset;
+    size_t n = left < room ? left : room;
+    memcpy(dest, buf->data + *offset, n);
+    *offset += n;
+    return n;
+#endif
+}
+
+// 流式上传的读取回调：没有新数据时等待录音线程追加，录音结束且数据发完时返回 0 结束请求体
+static size_t stream_read_callback(char *dest, size_t size, size_t nitems, void *userp) {
+    struct SttStream *stream = (struct SttStream *)userp;
+
+    pthread_mutex_lock(&stream->lock);
+    while (!stream->aborted && !stream_ready(stream->buf, stream->offset, stream->finished)) {
+        pthread_cond_wait(&stream->cond, &stream->lock);
+    }
+    if (stream->aborted) {
+        pthread_mutex_unlock(&stream->lock);
+        return CURL_READFUNC_ABORT;
+    }
+    size_t n = stream_take(stream->buf, &stream->offset, stream->finished, &stream->adpcm, dest, size * nitems);
+    if (n == 0) {
+        trace_mark(stream->trace, TRACE_UPLOAD_END);  // 录音已结束且数据已发完
+    }
+    pthread_mutex_unlock(&stream->lock);
+    return n;
+}
+
+// 进度回调：请求体发完后在等待识别结果期间也会被调用，取消时返回非 0 中止传输
+static int stream_progress_callback(void *userp, curl_off_t dltotal, curl_off_t dlnow,
+                                    curl_off_t ultotal, curl_off_t ulnow) {
+    struct SttStream *stream = (struct SttStream *)userp;
+    (void)dltotal; (void)dlnow; (void)ultotal; (void)ulnow;
+    pthread_mutex_lock(&stream->lock);
+    int aborted = stream->aborted;
+    pthread_mutex_unlock(&stream->lock);
+    return aborted;
+}
+
+static void *stt_stream_thread(void *arg) {
+    struct SttStream *stream = (struct SttStream *)arg;
+    CURL *curl = stream->curl;
+
+    // 请求体长度未知，cURL 使用 chunked 传输编码
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, -1L);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, stream_read_callback);
+    curl_easy_setopt(curl, CURLOPT_READDATA, stream);
+    if (stream->parser) {
+        chat_stream_attach(curl, stream->parser);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, memory_write_callback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, stream->response);
+    }
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, stream_progress_callback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, stream);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+
+    struct HttpTiming timing;
+    stream->result = http_client_perform_handle(curl, stream->trace ? stream->trace->id : NULL, &timing);
+    if (stream->parser) {
+        // 识别结果的时间点已由解析器记录，失败时由 stt_stream_wait 输出错误
+        if (stream->result == CURLE_OK &&
+            chat_stream_complete(curl, stream->parser, stream->result, stream->trace) != 0) {
+            stream->result = CURLE_PARTIAL_FILE;  // 没有结束行，按上传失败处理
         }
+        return NULL;
+    }
+    if (stream->result != CURLE_ABORTED_BY_CALLBACK) {
+        trace_mark(stream->trace, TRACE_STT_REPLY);  // 被取消时没有识别结果
+    }
+    if (stream->result == CURLE_OK) {
+        printf("流式上传完成，耗时 %.1f ms（连接 %.1f ms，新建连接 %ld）\n",
+               timing.total_ms, timing.connect_ms, timing.new_connections);
+    }
+    return NULL;
+}
 
-        // 清理资源
-        curl_easy_cleanup(curl);
-        curl_formfree(post);
+void stt_stream_init(struct SttStream *stream) {
+    memset(stream, 0, sizeof(*stream));
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->cond, NULL);
+}
+
+void stt_stream_destroy(struct SttStream *stream) {
+    stt_stream_wait(stream);
+    if (stream->curl) {
+        curl_easy_cleanup(stream->curl);
+        stream->curl = NULL;
     }
+    pthread_cond_destroy(&stream->cond);
+    pthread_mutex_destroy(&stream->lock);
+}
 
-    fclose(file);
-    curl_global_cleanup();
+// 复制本流（或本条语音）独占的句柄，接口与上次不同时重新复制
+static CURL *own_handle(CURL **curl, enum HttpEndpoint *current, enum HttpEndpoint endpoint) {
+    if (*curl && *current != endpoint) {
+        curl_easy_cleanup(*curl);
+        *curl = NULL;
+    }
+    if (!*curl) {
+        *curl = http_client_dup_handle(endpoint);
+        *current = endpoint;
+        if (!*curl) {
+            fprintf(stderr, "CURL 未初始化\n");
+        }
+    }
+    return *curl;
+}
+
+/* 启动上传线程，PCM 数据从 WAV 文件头之后开始发送（stream->parser 由调用方设置） */
+static int stt_stream_start(struct SttStream *stream, struct AudioBuffer *buf, struct Memory *response,
+                            struct Trace *trace) {
+    // 每个流使用独立句柄，前一段语音还在等待识别结果时也能开始上传下一段
+    // 句柄复制自 /stt/stream/（或 /converse/）模板，共享 DNS 缓存，连接在本流的前后语音之间复用
+    enum HttpEndpoint endpoint = stream->parser ? HTTP_ENDPOINT_CONVERSE : HTTP_ENDPOINT_STT_STREAM;
+    if (!own_handle(&stream->curl, &stream->endpoint, endpoint)) {
+        return -1;
+    }
+    stream->buf = buf;
+    stream->offset = WAV_HEADER_SIZE;
+    stream->finished = 0;
+    stream->aborted = 0;
+    adpcm_init(&stream->adpcm);
+    stream->response = response;
+    if (response) {
+        response->size = 0;
+    }
+    stream->result = CURLE_OK;
+    stream->trace = trace;
+    trace_mark(trace, TRACE_UPLOAD_START);
+    if (pthread_create(&stream->tid, NULL, stt_stream_thread, stream) != 0) {
+        fprintf(stderr, "无法创建上传线程\n");
+        return -1;
+    }
+    stream->started = 1;
+    return 0;
+}
+
+/* 标记录音结束，上传线程发完剩余数据后结束请求体 */
+static void stt_stream_finish(struct SttStream *stream) {
+    pthread_mutex_lock(&stream->lock);
+    stream->finished = 1;
+    pthread_cond_signal(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+}
+
+int stt_stream_wait(struct SttStream *stream) {
+    if (!stream->started) {
+        return -1;
+    }
+    pthread_join(stream->tid, NULL);
+    stream->started = 0;
+    if (stream->aborted) {
+        return -1;  // 主动取消，不是错误
+    }
+    if (stream->result != CURLE_OK) {
+        fprintf(stderr, "流式上传失败: %s\n", curl_easy_strerror(stream->result));
+        return -1;
+    }
+    return 0;
+}
+
+void stt_stream_abort(struct SttStream *stream) {
+    pthread_mutex_lock(&stream->lock);
+    stream->aborted = 1;
+    pthread_cond_signal(&stream->cond);
+    pthread_mutex_unlock(&stream->lock);
+}
+
+int record_audio_streaming(struct AudioBuffer *buf, struct SttStream *stream, struct Memory *response,
+                           struct Trace *trace) {
+    stream->parser = NULL;
+    if (record_utterance(buf, stream, response, trace) != 0) {
+        // 上传可能已经开始，等待线程退出后再返回
+        stt_stream_wait(stream);
+        return -1;
+    }
+    return 0;
+}
+
+int record_audio_converse(struct AudioBuffer *buf, struct SttStream *stream, struct ChatStreamParser *parser,
+                          struct Trace *trace) {
+    stream->parser = parser;
+    if (record_utterance(buf, stream, NULL, trace) != 0) {
+        stt_stream_wait(stream);
+        return -1;
+    }
+    return 0;
+}
+
+// 事件循环中的读取回调：没有新数据时暂停传输，不阻塞线程
+static size_t upload_pause_callback(char *dest, size_t size, size_t nitems, void *userp) {
+    struct SttUpload *up = (struct SttUpload *)userp;
+    if (!stream_ready(up->buf, up->offset, up->finished)) {
+        up->paused = 1;
+        return CURL_READFUNC_PAUSE;
+    }
+    size_t n = stream_take(up->buf, &up->offset, up->finished, &up->adpcm, dest, size * nitems);
+    if (n == 0) {
+        trace_mark(up->trace, TRACE_UPLOAD_END);
+    }
+    return n;
+}
+
+int stt_upload_prepare(struct SttUpload *up, struct AudioBuffer *buf, struct Memory *response,
+                       struct ChatStreamParser *parser, struct Trace *trace) {
+    CURL *curl = own_handle(&up->curl, &up->endpoint, parser ? HTTP_ENDPOINT_CONVERSE : HTTP_ENDPOINT_STT_STREAM);
+    if (!curl) {
+        return -1;
+    }
+    up->buf = buf;
+    up->offset = WAV_HEADER_SIZE;
+    up->finished = 0;
+    up->paused = 0;
+    adpcm_init(&up->adpcm);
+    up->response = response;
+    up->parser = parser;
+    up->trace = trace;
+
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, -1L);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, upload_pause_callback);
+    curl_easy_setopt(curl, CURLOPT_READDATA, up);
+    if (parser) {
+        chat_stream_attach(curl, parser);
+    } else {
+        response->size = 0;
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, memory_write_callback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    }
+    http_client_set_trace(curl, &up->trace_header, trace ? trace->id : NULL);
+    trace_mark(trace, TRACE_UPLOAD_START);
+    return 0;
+}
+
+int stt_upload_recorded(struct SttUpload *up, struct AudioBuffer *buf, struct Memory *response,
+                        struct ChatStreamParser *parser, struct Trace *trace) {
+    if (stt_upload_prepare(up, buf, response, parser, trace) != 0) {
+        return -1;
+    }
+    up->finished = 1;  // 数据已全部就绪，读取回调不会暂停
+    return stt_upload_complete(up, curl_easy_perform(up->curl));
+}
+
+void stt_upload_resume(struct SttUpload *up, int finished) {
+    if (finished) {
+        up->finished = 1;
+    }
+    if (up->paused && stream_ready(up->buf, up->offset, up->finished)) {
+        up->paused = 0;
+        curl_easy_pause(up->curl, CURLPAUSE_CONT);
+    }
+}
+
+int stt_upload_complete(struct SttUpload *up, CURLcode result) {
+    server_health_report(up->curl, result);
+    if (up->trace) {
+        http_client_clear_trace(up->curl);
+    }
+    if (up->parser) {
+        // /converse/：识别结果的时间点已由解析器记录
+        return chat_stream_complete(up->curl, up->parser, result, up->trace);
+    }
+    trace_mark(up->trace, TRACE_STT_REPLY);
+    if (result != CURLE_OK) {
+        fprintf(stderr, "流式上传失败: %s\n", curl_easy_strerror(result));
+        return -1;
+    }
+    struct HttpTiming timing;
+    http_client_get_timing(up->curl, &timing);
+    printf("流式上传完成，耗时 %.1f ms（连接 %.1f ms，新建连接 %ld）\n",
+           timing.total_ms, timing.connect_ms, timing.new_connections);
     return 0;
 }
 
+// 录音的同时以 chunked 方式把 PCM 数据流式上传到 /stt/stream/
+int stream_audio_to_api(struct AudioBuffer *buf, struct Memory *response) {
+    static struct SttStream stream;
+    static int initialized = 0;
+
+    if (!initialized) {
+        stt_stream_init(&stream);
+        initialized = 1;
+    }
+    if (record_audio_streaming(buf, &stream, response, NULL) != 0) {
+        printf("录音失败\n");
+        return -1;
+    }
+    return stt_stream_wait(&stream);
+}
+
+// debug_file_path 不为 NULL 时额外把录音保存为文件（调试用）
+int start_realtime_recognition(const char *debug_file_path, char *recognized_text) {
+    static struct AudioBuffer audio = {0};  // 跨次复用的录音缓冲区
+    static char response_data[STT_RESPONSE_SIZE];
+    struct Memory response = { response_data, 0, sizeof(response_data) };  // 用来存储 API 返回的响应
 
-int start_realtime_recognition(const char *file_path, char *recognized_text) {
-    char response_data[2048] = {0};  // 用来存储 API 返回的响应
+#if STT_STREAMING
+    // 边录边传，人声结束时请求也基本完成
+    if (stream_audio_to_api(&audio, &response) != 0) {
+        printf("音频上传失败\n");
+        return -1;
+    }
 
-    if (record_audio_to_file(file_path) != 0) {
+    if (debug_file_path && save_audio_buffer(&audio, debug_file_path) == 0) {
+        printf("调试录音已保存到 %s\n", debug_file_path);
+    }
+#else
+    if (record_audio(&audio, NULL) != 0) {
         printf("录音失败\n");
         return -1;
     }
+
+    if (debug_file_path && save_audio_buffer(&audio, debug_file_path) == 0) {
+        printf("调试录音已保存到 %s\n", debug_file_path);
+    }
     
-    if (upload_audio_to_api(file_path, response_data) != 0) {
+    if (upload_audio_to_api(&audio, &response, NULL) != 0) {
         printf("音频上传失败\n");
         return -1;
     }
+#endif
 
     // 调用 handle_api_response 解析返回的响应
-    return handle_api_response(response_data, recognized_text);
+    return handle_api_response(response.data, recognized_text);
+}
+
+int start_realtime_conversation(const char *debug_file_path, char *recognized_text, struct AIResponse *response,
+                                chat_command_fn on_command, void *userdata) {
+    static struct AudioBuffer audio = {0};  // 跨次复用的录音缓冲区
+    static struct SttStream stream;
+    static int initialized = 0;
+    struct ChatStreamParser parser;
+
+    if (!initialized) {
+        stt_stream_init(&stream);
+        initialized = 1;
+    }
+    chat_stream_parser_init(&parser, response, on_command, userdata);
+    chat_stream_parser_expect_text(&parser, recognized_text, 1024, NULL, NULL);
+    if (record_audio_converse(&audio, &stream, &parser, NULL) != 0) {
+        printf("录音失败\n");
+        return -1;
+    }
+    if (debug_file_path && save_audio_buffer(&audio, debug_file_path) == 0) {
+        printf("调试录音已保存到 %s\n", debug_file_path);
+    }
+    if (stt_stream_wait(&stream) != 0) {
+        printf("音频上传失败\n");
+        return -1;
+    }
+    if (!parser.has_text) {
+        printf("响应中没有识别结果\n");
+        return -1;
+    }
+    return 0;
 }
 
 void cleanup() {
-    if (pcm_handle) {
-        snd_pcm_drain(pcm_handle);
-        snd_pcm_close(pcm_handle);
+    if (atomic_exchange(&capture_running, 0)) {
+        pthread_join(capture_tid, NULL);
+        ring_buffer_free(&capture_ring);
+    }
+    if (capture_source) {
+        capture_source->close(capture_source);
+        capture_source = NULL;
     }
+    vad_endpoint_free(&vad_endpoint);
+    free(conditioned_frame);
+    conditioned_frame = NULL;
     if (fvad_instance) {
         fvad_free(fvad_instance);
     }
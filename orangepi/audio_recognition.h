@@ -2,23 +2,192 @@
 #define AUDIO_RECOGNITION_H
 
 #include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <curl/curl.h>
+#include "vad_endpoint.h"
+#include "arena.h"
+#include "adpcm.h"
+#include "frontend.h"
+#include "capture_source.h"
+#include "trace.h"
+#include "http_client.h"
+#include "chat.h"
+
+#define AUDIO_RATE   16000       // 采样率
+#define AUDIO_PERIOD 320         // 每帧采样数（20ms），实际值以采集源为准
+#define STT_RESPONSE_SIZE 4096  // /stt/ 响应缓冲区大小
+
+#ifndef STT_STREAMING
+#define STT_STREAMING 1  // 1：确认人声后边录边以 chunked 方式上传；0：录完后整段上传
+#endif
+
+#ifndef STT_CONVERSE
+#define STT_CONVERSE STT_STREAMING  // 1：音频流式上传到 /converse/，识别和回答一次返回；0：/stt/ 与 /chat/ 分两次请求
+#endif
+#if STT_CONVERSE && !STT_STREAMING
+#error "STT_CONVERSE 需要 STT_STREAMING"
+#endif
+
+// 内存中的录音数据，开头 44 字节为就地生成的 WAV 文件头
+struct AudioBuffer {
+    unsigned char *data;
+    size_t size;      // 已使用字节数（含 WAV 文件头）
+    size_t capacity;  // 已分配字节数
+    int fixed;        // 外部提供的定长缓冲区（不扩容、不释放）
+};
+
+// 流式上传状态：录音线程追加数据，上传线程通过 cURL 读取回调边录边发
+struct SttStream {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct AudioBuffer *buf;
+    size_t offset;          // 已交给 cURL 发送的位置
+    int finished;           // 录音已结束
+    int aborted;            // 已取消（本地已识别出命令），读取回调和进度回调据此中止传输
+    int started;            // 上传线程已启动且尚未回收
+    pthread_t tid;
+    CURL *curl;             // 本流独占的 cURL 句柄
+    enum HttpEndpoint endpoint;  // curl 复制自哪个接口
+    struct Memory *response;
+    struct ChatStreamParser *parser;  // 不为 NULL 时上传到 /converse/，响应交给该解析器
+    CURLcode result;
+    struct AdpcmState adpcm;  // STT_ADPCM 时的编码器状态，跨分块连续
+    struct Trace *trace;      // 本条语音的追踪记录，可为 NULL
+};
+
+// 事件循环中的流式上传：没有新数据时暂停传输（CURL_READFUNC_PAUSE），
+// 录音追加数据后由 stt_upload_resume 恢复，不需要上传线程，也不加锁
+struct SttUpload {
+    CURL *curl;             // 本条语音独占的 cURL 句柄，首次使用时复制
+    enum HttpEndpoint endpoint;
+    struct AudioBuffer *buf;
+    size_t offset;          // 已交给 cURL 发送的位置
+    int finished;           // 录音已结束
+    int paused;             // 读取回调已暂停传输
+    struct Memory *response;
+    struct ChatStreamParser *parser;  // 不为 NULL 时上传到 /converse/
+    struct AdpcmState adpcm;
+    struct Trace *trace;
+    struct HttpTraceHeader trace_header;
+};
 
 // 函数声明
 
-// 初始化音频设备
+// 设置端点检测参数（预录、起点、尾音、最长时长），需在 init_audio_device 之前调用
+// config->frame_ms 会在初始化时按实际 period size 重新计算
+void set_vad_config(const struct VadConfig *config);
+
+// 设置音频前端参数（静音门限、目标电平、最大增益），需在 init_audio_device 之前调用
+void set_frontend_config(const struct FrontendConfig *config);
+
+// 获取最近一帧的电平指标，以及前端处理的总帧数和被静音门限跳过 fvad 的帧数
+void get_input_levels(struct FrontendLevels *levels, unsigned long *frames, unsigned long *gated);
+
+// 使用已打开的采集源（如 WAV 回放）代替 ALSA 设备，需在 init_audio_device 之前调用
+// 采样率必须为 16kHz，采集源由 cleanup() 关闭
+void set_capture_source(struct CaptureSource *src);
+
+// 设置 ALSA 采集参数（设备、采样率、period、缓冲区、访问方式），需在 init_audio_device 之前调用
+// 采样率必须为 AUDIO_RATE，period 必须为 10/20/30ms；未调用时使用 CAPTURE_ALSA_DEVICE 和 AUDIO_PERIOD
+void set_capture_config(const struct AlsaCaptureConfig *config);
+
+// 初始化音频设备（未设置采集源时打开 ALSA 设备），并启动常驻采集线程
 int init_audio_device();
 
-// 获取音频数据并保存为文件
-int record_audio_to_file(const char *file_path);
+// 事件循环模式：与 init_audio_device 相同但不启动采集线程，由调用方在采集源就绪时读取帧，
+// 交给 audio_listen_start/audio_feed_frame 处理
+int init_audio_device_polled();
+
+// 当前使用的采集源
+struct CaptureSource *get_capture_source(void);
+
+// 开始录制新的一段语音（清空缓冲区并复位端点检测）
+int audio_listen_start(struct AudioBuffer *buf);
+
+// 处理一帧采集数据：前端处理、端点检测，语音数据追加到 buf
+// 返回 VAD_EVENT_*（VAD_EVENT_END 时 WAV 文件头已填好），出错返回 -1
+int audio_feed_frame(struct AudioBuffer *buf, const short *frame, struct Trace *trace);
+
+// 事件循环没有空闲的语音槽位而丢弃一帧，计入采集统计
+void audio_drop_frame(void);
+
+// 获取采集统计：ALSA 溢出次数和因缓冲区满而丢弃的 period 数
+void get_capture_stats(unsigned long *xruns, unsigned long *dropped);
 
-// 上传音频文件到 Whisper API
-int upload_audio_to_api(const char *audio_file_path);
+// 录制一段语音到内存缓冲区（含 WAV 文件头），trace 不为 NULL 时记录说话起止时间点
+int record_audio(struct AudioBuffer *buf, struct Trace *trace);
+
+// 调试用：把录音缓冲区保存为 WAV 文件
+int save_audio_buffer(const struct AudioBuffer *buf, const char *file_path);
+
+// 读取 save_audio_buffer 保存的 WAV 文件；自行分配的缓冲区按需扩容，定长缓冲区放不下时返回 -1
+int load_audio_buffer(struct AudioBuffer *buf, const char *file_path);
+
+// 释放录音缓冲区
+void audio_buffer_free(struct AudioBuffer *buf);
+
+// 录音缓冲区中 WAV 文件头之后的 PCM 数据和采样数
+const short *audio_buffer_pcm(const struct AudioBuffer *buf, size_t *samples);
+
+// 单条语音（含 WAV 文件头）的最大字节数，由端点检测参数决定，需在 init_audio_device 之后调用
+size_t audio_buffer_max_bytes(void);
+
+// 使用外部提供的定长内存作为录音缓冲区（如 arena 中切出的内存），录音时不再申请内存
+void audio_buffer_attach(struct AudioBuffer *buf, void *mem, size_t capacity);
+
+// 上传内存中的音频到 Whisper API
+int upload_audio_to_api(const struct AudioBuffer *buf, struct Memory *response, struct Trace *trace);
+
+// 初始化/销毁流式上传状态
+void stt_stream_init(struct SttStream *stream);
+void stt_stream_destroy(struct SttStream *stream);
+
+// 录音并在确认人声后开始流式上传，录音结束即返回，不等待识别结果
+// trace 不为 NULL 时记录说话起止、上传和识别结果的时间点，并把追踪 ID 发给服务端
+int record_audio_streaming(struct AudioBuffer *buf, struct SttStream *stream, struct Memory *response,
+                           struct Trace *trace);
+
+// 与 record_audio_streaming 相同，但上传到 /converse/：识别结果和回答都由 parser 解析
+// （需先调用 chat_stream_parser_expect_text），命令在回答生成过程中即通过解析器回调
+int record_audio_converse(struct AudioBuffer *buf, struct SttStream *stream, struct ChatStreamParser *parser,
+                          struct Trace *trace);
+
+// 等待流式上传完成，成功后 response 中为识别结果（/converse/ 时识别结果和回答已由解析器填写）
+int stt_stream_wait(struct SttStream *stream);
+
+// 取消流式上传（不再需要识别结果），之后仍需调用 stt_stream_wait 回收上传线程
+void stt_stream_abort(struct SttStream *stream);
+
+// 设置 /stt/stream/ 上传选项（句柄交给事件循环之前调用），录音确认人声后调用
+// parser 不为 NULL 时改为上传到 /converse/，响应交给解析器，response 不使用
+int stt_upload_prepare(struct SttUpload *up, struct AudioBuffer *buf, struct Memory *response,
+                       struct ChatStreamParser *parser, struct Trace *trace);
+
+// 同步上传已经录完的整段语音（录音时没有上传，如服务器当时不可用），结束后已调用 stt_upload_complete
+// parser 不为 NULL 时上传到 /converse/；成功返回 0
+int stt_upload_recorded(struct SttUpload *up, struct AudioBuffer *buf, struct Memory *response,
+                        struct ChatStreamParser *parser, struct Trace *trace);
+
+// 录音追加了数据（finished 为 1 时录音已结束），传输暂停中则恢复
+void stt_upload_resume(struct SttUpload *up, int finished);
+
+// 传输结束后调用：记录时间点、恢复请求头并输出耗时，成功返回 0
+int stt_upload_complete(struct SttUpload *up, CURLcode result);
+
+// 边录音边以 chunked 方式流式上传 PCM 数据，录音结束后 response 即为识别结果
+int stream_audio_to_api(struct AudioBuffer *buf, struct Memory *response);
 
 // 处理 API 响应并输出识别结果
 int handle_api_response(const char *response, char *recognized_text);
 
-// 启动实时语音识别
-int start_realtime_recognition(const char *file_path, char *recognized_text);
+// 启动实时语音识别，debug_file_path 不为 NULL 时额外保存录音文件
+int start_realtime_recognition(const char *debug_file_path, char *recognized_text);
+
+// 录一段语音并通过 /converse/ 一次拿到识别结果和回答，代替 start_realtime_recognition + get_ai_response
+// recognized_text 至少 1024 字节；on_command 不为 NULL 时命令在回答生成过程中即回调
+int start_realtime_conversation(const char *debug_file_path, char *recognized_text, struct AIResponse *response,
+                                chat_command_fn on_command, void *userdata);
 
 // 清理资源
 void cleanup();
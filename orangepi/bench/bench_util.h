@@ -0,0 +1,13 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <time.h>
+
+// 基准程序共用的计时：clock 为 CLOCK_MONOTONIC（墙上耗时）或 CLOCK_PROCESS_CPUTIME_ID（CPU 时间），单位毫秒
+static inline double bench_now_ms(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+#endif // BENCH_UTIL_H
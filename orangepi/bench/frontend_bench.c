@@ -0,0 +1,115 @@
+// 音频前端基准：NEON 与标量实现的每帧耗时对比，并校验两者输出一致
+// 用法：output/frontend_bench [16kHz 单声道 S16LE WAV 文件]，不指定文件时使用合成信号（静音与语音交替）
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../frontend.h"
+
+#define RATE 16000
+#define FRAME_SAMPLES 320       // 与 DESIRED_PERIOD 一致（20ms）
+#define WAV_HEADER_SIZE 44
+#define SYNTH_SECONDS 20
+#define ROUNDS 20
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 合成信号：每 2 秒中 1 秒是带直流偏置的底噪，1 秒是音量偏小的类语音信号
+static short *synth_input(size_t samples) {
+    short *pcm = malloc(samples * sizeof(short));
+    unsigned int seed = 1;
+    double phase = 0;
+    for (size_t i = 0; i < samples; i++) {
+        double t = (double)i / RATE;
+        seed = seed * 1103515245 + 12345;
+        double noise = ((seed >> 16) & 0x7fff) / 32768.0 - 0.5;
+        double v = 200 + 20 * noise;  // 麦克风直流偏置 + 底噪
+        if ((long)t % 2 == 1) {
+            phase += 2 * M_PI * (150 + 30 * sin(2 * M_PI * 0.5 * t)) / RATE;
+            for (int h = 1; h <= 8; h++) {
+                v += 800 * sin(h * phase) / h * (0.5 + 0.5 * sin(2 * M_PI * 4 * t));
+            }
+        }
+        pcm[i] = (short)v;
+    }
+    return pcm;
+}
+
+static short *load_wav(const char *path, size_t *samples) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        perror("打开 WAV 文件失败");
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp) - WAV_HEADER_SIZE;
+    fseek(fp, WAV_HEADER_SIZE, SEEK_SET);
+    if (size <= 0) {
+        fclose(fp);
+        return NULL;
+    }
+    short *pcm = malloc(size);
+    *samples = fread(pcm, sizeof(short), size / sizeof(short), fp);
+    fclose(fp);
+    return pcm;
+}
+
+typedef void (*process_fn)(struct Frontend *, const short *, short *, size_t, struct FrontendLevels *);
+
+// 返回每帧平均耗时（纳秒），gated 为被静音门限跳过的帧数
+static double run(process_fn fn, const short *pcm, short *out, size_t frames, unsigned long *gated) {
+    struct FrontendConfig config;
+    struct Frontend fe;
+    frontend_config_default(&config);
+    double start = now_seconds();
+    for (int r = 0; r < ROUNDS; r++) {
+        frontend_init(&fe, &config);
+        for (size_t f = 0; f < frames; f++) {
+            fn(&fe, pcm + f * FRAME_SAMPLES, out + f * FRAME_SAMPLES, FRAME_SAMPLES, NULL);
+        }
+    }
+    *gated = fe.gated;
+    return (now_seconds() - start) * 1e9 / ROUNDS / frames;
+}
+
+int main(int argc, char **argv) {
+    size_t samples = (size_t)SYNTH_SECONDS * RATE;
+    short *pcm = argc > 1 ? load_wav(argv[1], &samples) : synth_input(samples);
+    if (!pcm) {
+        return 1;
+    }
+    size_t frames = samples / FRAME_SAMPLES;
+    if (frames == 0) {
+        return 1;
+    }
+    short *out_fast = malloc(frames * FRAME_SAMPLES * sizeof(short));
+    short *out_scalar = malloc(frames * FRAME_SAMPLES * sizeof(short));
+
+    unsigned long gated_fast, gated_scalar;
+    double scalar_ns = run(frontend_process_scalar, pcm, out_scalar, frames, &gated_scalar);
+    double fast_ns = run(frontend_process, pcm, out_fast, frames, &gated_fast);
+    int same = gated_fast == gated_scalar &&
+               memcmp(out_fast, out_scalar, frames * FRAME_SAMPLES * sizeof(short)) == 0;
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    const char *impl = "NEON";
+#else
+    const char *impl = "标量（本平台无 NEON）";
+#endif
+    printf("音频：%zu 帧 × %d 采样（%s）\n", frames, FRAME_SAMPLES, argc > 1 ? argv[1] : "合成信号");
+    printf("标量：%8.1f ns/帧，占 CPU %.3f%%\n", scalar_ns, scalar_ns / 20e6 * 100);
+    printf("%s：%8.1f ns/帧，占 CPU %.3f%%，加速 %.2f 倍\n", impl, fast_ns, fast_ns / 20e6 * 100,
+           scalar_ns / fast_ns);
+    printf("输出%s，静音门限跳过 fvad %lu/%zu 帧（%.1f%%）\n", same ? "一致" : "不一致！",
+           gated_fast, frames, 100.0 * gated_fast / frames);
+
+    free(out_scalar);
+    free(out_fast);
+    free(pcm);
+    return same ? 0 : 1;
+}
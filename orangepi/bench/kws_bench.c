@@ -0,0 +1,310 @@
+// 本地关键词识别基准：每条语音的检测延迟（说话结束到出结果，即 MFCC + DTW 耗时）和 CPU 时间，
+// 以及测试集上的准确率；同时对比 MFCC 的 NEON 与标量实现
+// 用法：output/kws_bench [模板目录 测试集目录]（16kHz 单声道 S16LE WAV）
+//   模板目录与设备上的 kws/ 相同（<命令>.wav 或 <命令>_<序号>.wav）；测试集文件名以命令名加 '_' 开头时
+//   视为该命令，其它文件视为非命令语音（应交给 /stt/）。不指定时生成合成语料
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include "../kws.h"
+#include "bench_util.h"
+
+#define RATE 16000
+#define MAX_TESTS 4096
+#define SYNTH_TEMPLATES 3      // 合成语料：每个命令的模板数
+#define SYNTH_TESTS 10         // 每个命令的测试条数
+#define SYNTH_OTHERS 40        // 非命令语音条数
+#define MFCC_ROUNDS 5
+
+struct TestCase {
+    char name[128];
+    char label[64];        // 期望的命令，非命令为空
+    short *pcm;
+    size_t samples;
+};
+
+struct TestResult {
+    struct KwsResult kws;
+    double cpu_ms;
+};
+
+/* ---- 合成语料：每个命令是固定的音节序列（共振峰组合），每次发音随机改变语速、音高、音量和噪声 ---- */
+
+static const char *synth_commands[] = {
+    "light_on", "light_off", "fan_on", "fan_off", "ac_on", "ac_off", "window_open", "window_close",
+};
+#define SYNTH_COMMANDS (sizeof(synth_commands) / sizeof(synth_commands[0]))
+
+// 元音的前两个共振峰（Hz）
+static const float vowels[][2] = {
+    {800, 1200}, {400, 2200}, {300, 900}, {500, 1700}, {650, 1000}, {350, 2600}, {450, 1300}, {700, 1800},
+};
+#define VOWELS (sizeof(vowels) / sizeof(vowels[0]))
+
+static unsigned int seed = 1;
+
+static float random_uniform(float lo, float hi) {
+    seed = seed * 1103515245 + 12345;
+    return lo + (hi - lo) * ((seed >> 8) & 0xffff) / 65536.0f;
+}
+
+// 按音节序列合成一次发音，前后各留 300ms 静音
+static short *synth_word(const int *syllables, int count, size_t *samples) {
+    float speed = random_uniform(0.8f, 1.25f);
+    float f0 = random_uniform(100, 220);
+    float gain = random_uniform(1500, 6000);
+    size_t pad = RATE * 3 / 10;
+    size_t total = pad * 2;
+    size_t lengths[8];
+    for (int s = 0; s < count; s++) {
+        lengths[s] = (size_t)(RATE * 0.18f * speed * random_uniform(0.85f, 1.15f));
+        total += lengths[s];
+    }
+    short *pcm = calloc(total, sizeof(short));
+    size_t pos = pad;
+    double phase = 0;
+    for (int s = 0; s < count; s++) {
+        const float *formant = vowels[syllables[s]];
+        for (size_t i = 0; i < lengths[s]; i++, pos++) {
+            float env = sinf((float)M_PI * i / lengths[s]);
+            float pitch = f0 * (1.0f + 0.1f * sinf(2 * (float)M_PI * pos / RATE));
+            phase += 2 * M_PI * pitch / RATE;
+            float v = 0;
+            for (int h = 1; h * pitch < 4000; h++) {
+                float hz = h * pitch;
+                float a = expf(-powf((hz - formant[0]) / 120, 2)) + 0.6f * expf(-powf((hz - formant[1]) / 180, 2));
+                v += a * sinf(h * phase);
+            }
+            pcm[pos] = (short)(gain * env * v);
+        }
+    }
+    for (size_t i = 0; i < total; i++) {
+        pcm[i] += (short)random_uniform(-30, 30);
+    }
+    *samples = total;
+    return pcm;
+}
+
+static void command_syllables(int cmd, int *syllables) {
+    // 每个命令固定 3 个音节，相邻命令至少有一个音节不同
+    syllables[0] = cmd % VOWELS;
+    syllables[1] = (cmd * 3 + 1) % VOWELS;
+    syllables[2] = (cmd * 5 + 2) % VOWELS;
+}
+
+static int synth_corpus(struct Kws *kws, struct TestCase *tests) {
+    int n = 0;
+    int syllables[8];
+    for (size_t c = 0; c < SYNTH_COMMANDS; c++) {
+        command_syllables(c, syllables);
+        for (int t = 0; t < SYNTH_TEMPLATES + SYNTH_TESTS; t++) {
+            size_t samples;
+            short *pcm = synth_word(syllables, 3, &samples);
+            if (t < SYNTH_TEMPLATES) {
+                kws_enroll(kws, synth_commands[c], pcm, samples);
+                free(pcm);
+                continue;
+            }
+            snprintf(tests[n].name, sizeof(tests[n].name), "%s_%d", synth_commands[c], t);
+            snprintf(tests[n].label, sizeof(tests[n].label), "%s", synth_commands[c]);
+            tests[n].pcm = pcm;
+            tests[n].samples = samples;
+            n++;
+        }
+    }
+    // 非命令：2~5 个随机音节
+    for (int t = 0; t < SYNTH_OTHERS; t++) {
+        int count = 2 + t % 4;
+        for (int s = 0; s < count; s++) {
+            syllables[s] = (int)random_uniform(0, VOWELS);
+        }
+        snprintf(tests[n].name, sizeof(tests[n].name), "other_%d", t);
+        tests[n].label[0] = '\0';
+        tests[n].pcm = synth_word(syllables, count, &tests[n].samples);
+        n++;
+    }
+    return n;
+}
+
+// 测试集文件名以某个已登记命令加 '_' 或 '.' 开头时以该命令为标签（取最长的命令名）
+static void label_for(const struct Kws *kws, const char *name, char *label, size_t size) {
+    size_t best = 0;
+    label[0] = '\0';
+    for (int i = 0; i < kws->count; i++) {
+        size_t len = strlen(kws->templates[i].cmd);
+        if (len > best && strncmp(name, kws->templates[i].cmd, len) == 0 &&
+            (name[len] == '_' || name[len] == '.')) {
+            best = len;
+            snprintf(label, size, "%s", kws->templates[i].cmd);
+        }
+    }
+}
+
+static int load_tests(const struct Kws *kws, const char *dir, struct TestCase *tests) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        perror("打开测试集目录失败");
+        return -1;
+    }
+    int n = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) && n < MAX_TESTS) {
+        size_t len = strlen(entry->d_name);
+        if (len <= 4 || strcasecmp(entry->d_name + len - 4, ".wav") != 0) {
+            continue;
+        }
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        tests[n].pcm = kws_load_wav(path, &tests[n].samples);
+        if (!tests[n].pcm) {
+            continue;
+        }
+        snprintf(tests[n].name, sizeof(tests[n].name), "%s", entry->d_name);
+        label_for(kws, entry->d_name, tests[n].label, sizeof(tests[n].label));
+        n++;
+    }
+    closedir(d);
+    return n;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// 按给定阈值重新判定（边际比例不变），统计命令的正确接受、错误接受，以及非命令被接受的条数
+static void score(const struct TestCase *tests, const struct TestResult *results, int n, float threshold,
+                  float margin, int *correct, int *wrong, int *false_accept) {
+    *correct = *wrong = *false_accept = 0;
+    for (int i = 0; i < n; i++) {
+        const struct KwsResult *r = &results[i].kws;
+        int accept = r->cmd[0] && r->distance < threshold && r->distance < margin * r->runner_up;
+        if (!accept) {
+            continue;
+        }
+        if (!tests[i].label[0]) {
+            (*false_accept)++;
+        } else if (strcmp(r->cmd, tests[i].label) == 0) {
+            (*correct)++;
+        } else {
+            (*wrong)++;
+        }
+    }
+}
+
+// MFCC 的 NEON 与标量实现对比：返回两者每秒语音的耗时（毫秒）和最大差值
+static void compare_mfcc(const struct Kws *kws, const struct TestCase *tests, int n,
+                         double *fast_ms, double *scalar_ms, float *max_diff) {
+    float *a = malloc(KWS_MAX_FRAMES * MFCC_STRIDE * sizeof(float));
+    float *b = malloc(KWS_MAX_FRAMES * MFCC_STRIDE * sizeof(float));
+    double seconds = 0, fast = 0, scalar = 0;
+    *max_diff = 0;
+    for (int i = 0; i < n; i++) {
+        size_t frames = 0;
+        double t0 = bench_now_ms(CLOCK_MONOTONIC);
+        for (int r = 0; r < MFCC_ROUNDS; r++) {
+            frames = mfcc_compute(&kws->mfcc, tests[i].pcm, tests[i].samples, a, KWS_MAX_FRAMES);
+        }
+        double t1 = bench_now_ms(CLOCK_MONOTONIC);
+        for (int r = 0; r < MFCC_ROUNDS; r++) {
+            mfcc_compute_scalar(&kws->mfcc, tests[i].pcm, tests[i].samples, b, KWS_MAX_FRAMES);
+        }
+        double t2 = bench_now_ms(CLOCK_MONOTONIC);
+        fast += t1 - t0;
+        scalar += t2 - t1;
+        seconds += (double)(frames * MFCC_HOP) / RATE * MFCC_ROUNDS;
+        for (size_t k = 0; k < frames * MFCC_STRIDE; k++) {
+            float d = fabsf(a[k] - b[k]);
+            if (d > *max_diff) {
+                *max_diff = d;
+            }
+        }
+    }
+    *fast_ms = seconds > 0 ? fast / seconds : 0;
+    *scalar_ms = seconds > 0 ? scalar / seconds : 0;
+    free(a);
+    free(b);
+}
+
+int main(int argc, char **argv) {
+    static struct Kws kws;
+    static struct TestCase tests[MAX_TESTS];
+    static struct TestResult results[MAX_TESTS];
+    if (kws_init(&kws) != 0) {
+        return 1;
+    }
+
+    int n;
+    if (argc > 2) {
+        if (kws_load_dir(&kws, argv[1]) <= 0) {
+            fprintf(stderr, "模板目录 %s 中没有可用的模板\n", argv[1]);
+            return 1;
+        }
+        n = load_tests(&kws, argv[2], tests);
+    } else {
+        n = synth_corpus(&kws, tests);
+    }
+    if (n <= 0) {
+        fprintf(stderr, "测试集为空\n");
+        return 1;
+    }
+
+    double latency[MAX_TESTS];
+    double latency_total = 0, cpu_total = 0, audio_seconds = 0;
+    int commands = 0;
+    for (int i = 0; i < n; i++) {
+        double cpu = bench_now_ms(CLOCK_PROCESS_CPUTIME_ID);
+        kws_spot(&kws, tests[i].pcm, tests[i].samples, &results[i].kws);
+        results[i].cpu_ms = bench_now_ms(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+        latency[i] = results[i].kws.ms;
+        latency_total += latency[i];
+        cpu_total += results[i].cpu_ms;
+        audio_seconds += (double)tests[i].samples / RATE;
+        commands += tests[i].label[0] != '\0';
+    }
+    qsort(latency, n, sizeof(double), compare_double);
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+    const char *impl = "NEON";
+#else
+    const char *impl = "标量（本平台无 NEON）";
+#endif
+    printf("语料：%s，模板 %d 个，测试 %d 条（命令 %d，非命令 %d），共 %.1f 秒\n",
+           argc > 2 ? argv[2] : "合成", kws.count, n, commands, n - commands, audio_seconds);
+    printf("检测延迟（说话结束到出结果）：平均 %.2f ms，p50 %.2f ms，p95 %.2f ms，最大 %.2f ms\n",
+           latency_total / n,
+           latency[n / 2], latency[n * 95 / 100], latency[n - 1]);
+    printf("CPU：每条 %.2f ms，每秒语音 %.2f ms（%s）\n", cpu_total / n, cpu_total / audio_seconds, impl);
+
+    double fast_ms, scalar_ms;
+    float max_diff;
+    compare_mfcc(&kws, tests, n, &fast_ms, &scalar_ms, &max_diff);
+    printf("MFCC：%s %.2f ms/秒语音，标量 %.2f ms/秒语音，加速 %.2f 倍，最大差值 %.2e\n",
+           impl, fast_ms, scalar_ms, fast_ms > 0 ? scalar_ms / fast_ms : 0, max_diff);
+
+    // 当前阈值下的结果，以及阈值和边际分别变化时的取舍，供设置 QYAI_KWS_THRESHOLD 参考
+    int correct, wrong, false_accept;
+    score(tests, results, n, kws.threshold, kws.margin, &correct, &wrong, &false_accept);
+    printf("阈值 %.1f：命令本地执行 %d/%d（%.1f%%），认错 %d，非命令误接受 %d/%d，其余交给 /stt/\n",
+           kws.threshold, correct, commands, commands ? 100.0 * correct / commands : 0.0,
+           wrong, false_accept, n - commands);
+    printf("阈值  边际  本地执行  认错  误接受\n");
+    for (float t = 3.0f; t <= 8.01f; t += 0.5f) {
+        score(tests, results, n, t, kws.margin, &correct, &wrong, &false_accept);
+        printf("%4.1f  %4.2f  %8d  %4d  %6d\n", t, kws.margin, correct, wrong, false_accept);
+    }
+    for (float m = 0.55f; m <= 0.951f; m += 0.05f) {
+        score(tests, results, n, kws.threshold, m, &correct, &wrong, &false_accept);
+        printf("%4.1f  %4.2f  %8d  %4d  %6d\n", kws.threshold, m, correct, wrong, false_accept);
+    }
+
+    for (int i = 0; i < n; i++) {
+        free(tests[i].pcm);
+    }
+    kws_free(&kws);
+    return 0;
+}
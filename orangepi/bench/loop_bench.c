@@ -0,0 +1,178 @@
+// 端到端基准：用 WAV 回放代替麦克风，按实时速度走完 录音 -> 识别 -> 对话 的完整客户端流程
+// 服务端可以是真实服务器，也可以是 server/stub_server.py（固定回答、可配置延迟），开发机上即可运行
+// 用法：QYAI_SERVER=http://127.0.0.1:8765 output/loop_bench <WAV 文件> [轮数]
+// 文件会循环回放，每轮处理一条语音；时间均从端点检测判定说话结束（录音返回）开始计算
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../audio_recognition.h"
+#include "../http_client.h"
+#include "../chat.h"
+#include "bench_util.h"
+
+#define DEFAULT_ROUNDS 10
+
+struct RoundTiming {
+    double record_ms;    // 从开始等待到说话结束（含等待人声和说话时长）
+    double stt_ms;       // 说话结束到拿到识别结果
+    double command_ms;   // 说话结束到解析出第一个命令（没有命令时为 -1）
+    double reply_ms;     // 说话结束到回答接收完毕
+};
+
+struct command_ctx {
+    double speech_end;
+    double *command_ms;
+    struct Trace *trace;
+};
+
+static void on_command(const char *cmd, void *userdata) {
+    struct command_ctx *ctx = (struct command_ctx *)userdata;
+    if (*ctx->command_ms < 0) {
+        *ctx->command_ms = bench_now_ms(CLOCK_MONOTONIC) - ctx->speech_end;
+        trace_mark(ctx->trace, TRACE_ACTION);
+        printf("命令：%s\n", cmd);
+    }
+}
+
+static int run_round(struct Arena *arena, struct SttStream *stream, struct RoundTiming *timing) {
+    struct Trace trace;
+    struct AudioBuffer audio;
+    struct Memory stt_response, chat_response;
+    char text[1024];
+
+    arena_reset(arena);
+    size_t audio_bytes = audio_buffer_max_bytes();
+    void *audio_mem = arena_alloc(arena, audio_bytes);
+    if (!audio_mem ||
+        memory_init(&stt_response, arena, STT_RESPONSE_SIZE) != 0 ||
+        memory_init(&chat_response, arena, CHAT_RESPONSE_SIZE) != 0) {
+        return -1;
+    }
+    audio_buffer_attach(&audio, audio_mem, audio_bytes);
+
+    double start = bench_now_ms(CLOCK_MONOTONIC);
+    trace_begin(&trace);
+#if STT_STREAMING
+    if (record_audio_streaming(&audio, stream, &stt_response, &trace) != 0) {
+        return -1;
+    }
+    double speech_end = bench_now_ms(CLOCK_MONOTONIC);
+    if (stt_stream_wait(stream) != 0) {
+        return -1;
+    }
+#else
+    (void)stream;
+    if (record_audio(&audio, &trace) != 0) {
+        return -1;
+    }
+    double speech_end = bench_now_ms(CLOCK_MONOTONIC);
+    if (upload_audio_to_api(&audio, &stt_response, &trace) != 0) {
+        return -1;
+    }
+#endif
+    timing->record_ms = speech_end - start;
+    if (handle_api_response(stt_response.data, text) != 0) {
+        return -1;
+    }
+    timing->stt_ms = bench_now_ms(CLOCK_MONOTONIC) - speech_end;
+
+    struct AIResponse response;
+    struct command_ctx ctx = { speech_end, &timing->command_ms, &trace };
+    timing->command_ms = -1;
+#if CHAT_STREAMING
+    struct ChatStreamParser parser;
+    chat_stream_parser_init(&parser, &response, on_command, &ctx);
+    if (get_ai_response_stream(text, &parser, &trace) != 0) {
+        return -1;
+    }
+#else
+    if (get_ai_response(text, &chat_response, &trace) != 0 || parse_ai_response(&chat_response, &response) != 0) {
+        return -1;
+    }
+    if (response.cmd[0]) {
+        on_command(response.cmd, &ctx);
+    }
+#endif
+    timing->reply_ms = bench_now_ms(CLOCK_MONOTONIC) - speech_end;
+    printf("回答：%s\n", response.msg);
+    trace_finish(&trace, stdout);
+    return 0;
+}
+
+static void print_column(const char *label, const struct RoundTiming *timings, int n, size_t offset) {
+    double sum = 0, max = 0;
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        double v = *(const double *)((const char *)&timings[i] + offset);
+        if (v < 0) {
+            continue;
+        }
+        sum += v;
+        max = v > max ? v : max;
+        count++;
+    }
+    if (count == 0) {
+        printf("%s：无数据\n", label);
+        return;
+    }
+    printf("%s：平均 %7.1f ms，最大 %7.1f ms（%d 轮）\n", label, sum / count, max, count);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "用法：%s <16kHz 单声道 WAV 文件> [轮数]\n", argv[0]);
+        return 1;
+    }
+    int rounds = argc > 2 ? atoi(argv[2]) : DEFAULT_ROUNDS;
+
+    if (http_client_init() != 0) {
+        return 1;
+    }
+    static struct CaptureSource source;
+    struct CaptureWavOptions options = { .realtime = 1, .loop = 1, .pad_ms = CAPTURE_WAV_PAD_MS };
+    if (capture_source_open_wav(&source, argv[1], AUDIO_RATE, AUDIO_PERIOD, &options) != 0) {
+        return 1;
+    }
+    set_capture_source(&source);
+    if (init_audio_device() != 0) {
+        return 1;
+    }
+
+    struct Arena arena;
+    struct SttStream stream;
+    if (arena_init(&arena, audio_buffer_max_bytes() + STT_RESPONSE_SIZE + CHAT_RESPONSE_SIZE + 64) != 0) {
+        return 1;
+    }
+    stt_stream_init(&stream);
+
+    struct RoundTiming *timings = calloc(rounds, sizeof(*timings));
+    int done = 0, failed = 0;
+    for (int i = 0; i < rounds; i++) {
+        if (run_round(&arena, &stream, &timings[done]) != 0) {
+            printf("第 %d 轮失败\n", i + 1);
+            failed++;
+            continue;
+        }
+        printf("[%d] 录音 %.0f ms，识别 %.1f ms，命令 %.1f ms，回答 %.1f ms\n", i + 1,
+               timings[done].record_ms, timings[done].stt_ms, timings[done].command_ms, timings[done].reply_ms);
+        done++;
+    }
+
+    unsigned long xruns, dropped;
+    get_capture_stats(&xruns, &dropped);
+    printf("\n完成 %d 轮，失败 %d 轮，采集丢弃 %lu 个 period\n", done, failed, dropped);
+    printf("以下时间从说话结束开始计算：\n");
+    print_column("识别结果", timings, done, offsetof(struct RoundTiming, stt_ms));
+    print_column("第一个命令", timings, done, offsetof(struct RoundTiming, command_ms));
+    print_column("回答完毕", timings, done, offsetof(struct RoundTiming, reply_ms));
+    printf("\n");
+    trace_report(stdout);
+
+    free(timings);
+    stt_stream_destroy(&stream);
+    arena_free(&arena);
+    cleanup();
+    http_client_cleanup();
+    return failed == 0 ? 0 : 1;
+}
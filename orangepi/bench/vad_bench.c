@@ -0,0 +1,337 @@
+// 录音/端点检测基准：把录好的语音经 WAV 回放源尽快送入前端、fvad 和端点检测状态机
+// 统计起点/终点检测延迟、每帧 CPU 时间和每秒可处理的语音条数，不需要麦克风
+// 用法：output/vad_bench [WAV 文件或目录 ...]（16kHz 单声道 S16LE），不指定时生成合成语音
+//
+// 参考起止点按能量估计：文件中 RMS 高于 max(峰值帧 - REF_RANGE_DB, REF_FLOOR_DBFS) 的第一帧和最后一帧
+// 起点延迟 = 检测到人声的时刻 - 参考起点；终点延迟 = 判定说话结束的时刻 - 参考终点（主要是尾音时长）
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fvad.h>
+#include "../capture_source.h"
+#include "../frontend.h"
+#include "../vad_endpoint.h"
+
+#define RATE 16000
+#define FRAME_SAMPLES 320        // 与 AUDIO_PERIOD 一致（20ms）
+#define FRAME_MS 20
+#define MAX_FILES 4096
+#define REF_RANGE_DB 25.0        // 参考起止点：比最响的帧低 25dB 以内
+#define REF_FLOOR_DBFS -50.0     // 且不低于 -50 dBFS
+#define SYNTH_UTTERANCES 50
+
+// 单个文件的结果（时间均为毫秒，相对回放时间轴起点）
+struct FileResult {
+    int utterances;         // 检测到的语音条数（大于 1 说明一句话被切开了）
+    double onset_latency;   // 第一次检测到人声相对参考起点的延迟
+    double end_latency;     // 最后一次说话结束相对参考终点的延迟
+    int clipped;            // 输出的音频（含预录）没有覆盖参考起点，首字会被截掉
+    size_t frames;
+};
+
+// 端点检测输出回调：统计本帧输出的采样数，用于推算输出音频的起点
+static int count_emit(const short *pcm, size_t samples, void *ctx) {
+    (void)pcm;
+    *(size_t *)ctx += samples;
+    return 0;
+}
+
+static double now_seconds(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double frame_dbfs(const short *frame) {
+    double sum = 0;
+    for (int i = 0; i < FRAME_SAMPLES; i++) {
+        sum += (double)frame[i] * frame[i];
+    }
+    double rms = sqrt(sum / FRAME_SAMPLES);
+    return rms < 1.0 ? -96.0 : 20.0 * log10(rms / 32768.0);
+}
+
+// 按能量估计参考起止点（采样位置，相对文件开头），找不到语音返回 -1
+static int reference_bounds(const char *path, size_t *begin, size_t *end) {
+    struct CaptureSource src;
+    struct CaptureWavOptions options = { .realtime = 0, .loop = 0, .pad_ms = 0 };
+    if (capture_source_open_wav(&src, path, RATE, FRAME_SAMPLES, &options) != 0) {
+        return -1;
+    }
+    short frame[FRAME_SAMPLES];
+    size_t capacity = 1024, count = 0;
+    double *levels = malloc(capacity * sizeof(double));
+    double peak = -96.0;
+    while (src.read(&src, frame) > 0) {
+        if (count == capacity) {
+            capacity *= 2;
+            levels = realloc(levels, capacity * sizeof(double));
+        }
+        levels[count] = frame_dbfs(frame);
+        if (levels[count] > peak) {
+            peak = levels[count];
+        }
+        count++;
+    }
+    src.close(&src);
+
+    double threshold = peak - REF_RANGE_DB > REF_FLOOR_DBFS ? peak - REF_RANGE_DB : REF_FLOOR_DBFS;
+    long first = -1, last = -1;
+    for (size_t i = 0; i < count; i++) {
+        if (levels[i] >= threshold) {
+            if (first < 0) first = i;
+            last = i;
+        }
+    }
+    free(levels);
+    if (first < 0) {
+        return -1;
+    }
+    *begin = first * FRAME_SAMPLES;
+    *end = (last + 1) * FRAME_SAMPLES;
+    return 0;
+}
+
+// 回放一个文件，逐帧经过前端和端点检测
+static int replay_file(const char *path, Fvad *fvad, struct VadEndpoint *ep, struct FileResult *result) {
+    size_t ref_begin, ref_end;
+    if (reference_bounds(path, &ref_begin, &ref_end) != 0) {
+        fprintf(stderr, "%s: 没有找到语音，跳过\n", path);
+        return -1;
+    }
+
+    struct CaptureSource src;
+    struct CaptureWavOptions options = { .realtime = 0, .loop = 0, .pad_ms = CAPTURE_WAV_PAD_MS };
+    if (capture_source_open_wav(&src, path, RATE, FRAME_SAMPLES, &options) != 0) {
+        return -1;
+    }
+    size_t pad, samples;
+    capture_source_wav_bounds(&src, &pad, &samples);
+    ref_begin += pad;
+    ref_end += pad;
+
+    struct FrontendConfig config;
+    struct Frontend fe;
+    frontend_config_default(&config);
+    frontend_init(&fe, &config);
+    fvad_reset(fvad);
+    fvad_set_mode(fvad, 3);
+    fvad_set_sample_rate(fvad, RATE);
+    vad_endpoint_reset(ep);
+
+    short frame[FRAME_SAMPLES];
+    memset(result, 0, sizeof(*result));
+    size_t pos = 0;  // 当前帧结束时在时间轴上的采样位置
+    int rc;
+    while ((rc = src.read(&src, frame)) > 0) {
+        struct FrontendLevels levels;
+        size_t emitted = 0;
+        frontend_process(&fe, frame, frame, FRAME_SAMPLES, &levels);
+        int event = vad_endpoint_process_gated(ep, frame, levels.gated, count_emit, &emitted);
+        pos += FRAME_SAMPLES;
+        result->frames++;
+
+        if (event == VAD_EVENT_START) {
+            if (result->utterances == 0) {
+                result->onset_latency = ((double)pos - ref_begin) * 1000 / RATE;
+                result->clipped = pos - emitted > ref_begin;
+            }
+            result->utterances++;
+        } else if (event == VAD_EVENT_END) {
+            result->end_latency = ((double)pos - ref_end) * 1000 / RATE;
+        }
+    }
+    src.close(&src);
+    return rc;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void print_distribution(const char *label, double *values, size_t n) {
+    if (n == 0) {
+        printf("%s：无数据\n", label);
+        return;
+    }
+    qsort(values, n, sizeof(double), compare_double);
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += values[i];
+    }
+    printf("%s：平均 %6.0f ms，p50 %6.0f ms，p90 %6.0f ms，最大 %6.0f ms\n", label, sum / n,
+           values[n / 2], values[n * 9 / 10], values[n - 1]);
+}
+
+static void write_le32(FILE *fp, unsigned int v) {
+    unsigned char b[4] = { v, v >> 8, v >> 16, v >> 24 };
+    fwrite(b, 1, 4, fp);
+}
+
+static void write_le16(FILE *fp, unsigned int v) {
+    unsigned char b[2] = { v, v >> 8 };
+    fwrite(b, 1, 2, fp);
+}
+
+// 合成语音：0.2 秒底噪 + 0.5~3 秒音量起伏的类语音信号（中间有短停顿）+ 0.2 秒底噪
+static int synth_utterance(const char *path, unsigned int seed) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        return -1;
+    }
+    srand(seed);
+    size_t lead = RATE / 5, speech = RATE / 2 + (size_t)rand() % (RATE * 5 / 2), samples = 2 * lead + speech;
+    double f0 = 100 + rand() % 150, amp = 600 + rand() % 4000, phase = 0;
+
+    fwrite("RIFF", 1, 4, fp);
+    write_le32(fp, 36 + samples * 2);
+    fwrite("WAVEfmt ", 1, 8, fp);
+    write_le32(fp, 16);
+    write_le16(fp, 1);
+    write_le16(fp, 1);
+    write_le32(fp, RATE);
+    write_le32(fp, RATE * 2);
+    write_le16(fp, 2);
+    write_le16(fp, 16);
+    fwrite("data", 1, 4, fp);
+    write_le32(fp, samples * 2);
+    for (size_t i = 0; i < samples; i++) {
+        double v = 150 + 20.0 * (rand() / (double)RAND_MAX - 0.5);  // 直流偏置 + 底噪
+        if (i >= lead && i < lead + speech) {
+            double t = (double)(i - lead) / RATE;
+            double envelope = 0.5 + 0.5 * sin(2 * M_PI * 3 * t);  // 约 3 个音节每秒
+            phase += 2 * M_PI * f0 * (1 + 0.1 * sin(2 * M_PI * 0.7 * t)) / RATE;
+            for (int h = 1; h <= 8; h++) {
+                v += amp * envelope * sin(h * phase) / h;
+            }
+        }
+        write_le16(fp, (unsigned int)(short)v);
+    }
+    fclose(fp);
+    return 0;
+}
+
+// 收集待回放的文件：参数为目录时取其中的 .wav 文件
+static size_t collect_files(int argc, char **argv, char **files) {
+    size_t n = 0;
+    for (int i = 1; i < argc && n < MAX_FILES; i++) {
+        struct stat st;
+        if (stat(argv[i], &st) != 0) {
+            fprintf(stderr, "找不到 %s\n", argv[i]);
+            continue;
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            files[n++] = strdup(argv[i]);
+            continue;
+        }
+        DIR *dir = opendir(argv[i]);
+        struct dirent *entry;
+        while (dir && (entry = readdir(dir)) && n < MAX_FILES) {
+            size_t len = strlen(entry->d_name);
+            if (len > 4 && strcasecmp(entry->d_name + len - 4, ".wav") == 0) {
+                char path[1024];
+                snprintf(path, sizeof(path), "%s/%s", argv[i], entry->d_name);
+                files[n++] = strdup(path);
+            }
+        }
+        if (dir) closedir(dir);
+    }
+    return n;
+}
+
+int main(int argc, char **argv) {
+    static char *files[MAX_FILES];
+    size_t count;
+    char synth_dir[] = "/tmp/vad_bench_XXXXXX";
+    int synthetic = argc < 2;
+
+    if (synthetic) {
+        if (!mkdtemp(synth_dir)) {
+            perror("创建临时目录失败");
+            return 1;
+        }
+        for (count = 0; count < SYNTH_UTTERANCES; count++) {
+            char path[256];
+            snprintf(path, sizeof(path), "%s/synth_%02zu.wav", synth_dir, count);
+            if (synth_utterance(path, count + 1) != 0) {
+                return 1;
+            }
+            files[count] = strdup(path);
+        }
+    } else {
+        count = collect_files(argc, argv, files);
+    }
+    if (count == 0) {
+        fprintf(stderr, "没有可回放的 WAV 文件\n");
+        return 1;
+    }
+
+    Fvad *fvad = fvad_new();
+    struct VadConfig config;
+    struct VadEndpoint ep;
+    vad_config_default(&config, FRAME_MS);
+    if (!fvad || vad_endpoint_init(&ep, fvad, &config, FRAME_SAMPLES) != 0) {
+        return 1;
+    }
+
+    double *onset = malloc(count * sizeof(double)), *end = malloc(count * sizeof(double));
+    size_t detected = 0, missed = 0, split = 0, clipped = 0, frames = 0;
+    int utterances = 0;
+    double wall_start = now_seconds(CLOCK_MONOTONIC), cpu_start = now_seconds(CLOCK_PROCESS_CPUTIME_ID);
+
+    for (size_t i = 0; i < count; i++) {
+        struct FileResult result;
+        if (replay_file(files[i], fvad, &ep, &result) != 0) {
+            continue;
+        }
+        frames += result.frames;
+        utterances += result.utterances;
+        if (result.utterances == 0) {
+            printf("未检测到人声：%s\n", files[i]);
+            missed++;
+            continue;
+        }
+        onset[detected] = result.onset_latency;
+        end[detected] = result.end_latency;
+        detected++;
+        split += result.utterances > 1;
+        clipped += result.clipped;
+    }
+
+    // 参考起止点的估计也读了一遍文件，计入总耗时（与回放相比很小）
+    double wall = now_seconds(CLOCK_MONOTONIC) - wall_start;
+    double cpu = now_seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+    double audio_seconds = (double)frames * FRAME_MS / 1000;
+
+    printf("回放 %zu 个文件（%s），共 %.1f 秒音频，前后各补 %d ms 静音\n", count,
+           synthetic ? "合成语音" : "录音语料", audio_seconds, CAPTURE_WAV_PAD_MS);
+    printf("端点检测：预录 %d ms，起点 %d ms，尾音 %d ms\n",
+           config.pre_roll_ms, config.onset_ms, config.hangover_ms);
+    printf("检测到 %zu 个文件（漏检 %zu，被切成多段 %zu，首字截断 %zu），共 %d 条语音\n",
+           detected, missed, split, clipped, utterances);
+    print_distribution("起点延迟", onset, detected);
+    print_distribution("终点延迟", end, detected);
+    printf("每帧 CPU %.1f us（帧长 %d ms，占 CPU %.3f%%），实时倍数 %.0f 倍，每秒处理 %.1f 条语音\n",
+           cpu * 1e6 / frames, FRAME_MS, cpu / audio_seconds * 100, audio_seconds / wall, utterances / wall);
+
+    vad_endpoint_free(&ep);
+    fvad_free(fvad);
+    for (size_t i = 0; i < count; i++) {
+        if (synthetic) {
+            unlink(files[i]);
+        }
+        free(files[i]);
+    }
+    if (synthetic) {
+        rmdir(synth_dir);
+    }
+    free(onset);
+    free(end);
+    return missed == 0 ? 0 : 1;
+}
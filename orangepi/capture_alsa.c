@@ -0,0 +1,348 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <alsa/asoundlib.h>
+#include "capture_source.h"
+
+struct alsa_capture {
+    snd_pcm_t *pcm;
+    int mmap;                   // 使用 MMAP_INTERLEAVED 访问
+};
+
+void capture_alsa_config_default(struct AlsaCaptureConfig *config) {
+    config->device = CAPTURE_ALSA_DEVICE;
+    config->rate = CAPTURE_ALSA_RATE;
+    config->period = CAPTURE_ALSA_PERIOD;
+    config->buffer_periods = CAPTURE_ALSA_BUFFER_PERIODS;
+    config->mmap = 1;
+}
+
+// 读取正整数环境变量，未设置或无效时保持原值
+static void env_unsigned(const char *name, unsigned long *value) {
+    const char *text = getenv(name);
+    if (!text || !text[0]) {
+        return;
+    }
+    char *end;
+    unsigned long v = strtoul(text, &end, 10);
+    if (*end != '\0' || v == 0) {
+        fprintf(stderr, "忽略无效的 %s=%s\n", name, text);
+        return;
+    }
+    *value = v;
+}
+
+void capture_alsa_config_from_env(struct AlsaCaptureConfig *config) {
+    const char *device = getenv("QYAI_PCM_DEVICE");
+    if (device && device[0]) {
+        config->device = device;
+    }
+    unsigned long rate = config->rate, period = config->period, periods = config->buffer_periods;
+    env_unsigned("QYAI_PCM_RATE", &rate);
+    env_unsigned("QYAI_PCM_PERIOD", &period);
+    env_unsigned("QYAI_PCM_BUFFER_PERIODS", &periods);
+    config->rate = rate;
+    config->period = period;
+    config->buffer_periods = periods < 2 ? 2 : periods;
+
+    // QYAI_PCM_ACCESS=rw 强制使用 snd_pcm_readi，=mmap 使用 mmap（默认）
+    const char *access = getenv("QYAI_PCM_ACCESS");
+    if (access && strcmp(access, "rw") == 0) {
+        config->mmap = 0;
+    } else if (access && strcmp(access, "mmap") == 0) {
+        config->mmap = 1;
+    } else if (access && access[0]) {
+        fprintf(stderr, "忽略无效的 QYAI_PCM_ACCESS=%s（可选 mmap、rw）\n", access);
+    }
+}
+
+// 溢出（-EPIPE）或挂起（-ESTRPIPE）后恢复采集，其它错误返回负值
+static int alsa_recover(struct CaptureSource *src, snd_pcm_t *pcm, int err) {
+    if (err == -EPIPE) {
+        unsigned long xruns = atomic_fetch_add(&src->xruns, 1) + 1;
+        fprintf(stderr, "采集溢出（第 %lu 次）：采集线程没有及时取走数据，重新准备设备\n", xruns);
+    } else if (err == -ESTRPIPE) {
+        fprintf(stderr, "采集设备被挂起，正在恢复\n");
+        int rc;
+        while ((rc = snd_pcm_resume(pcm)) == -EAGAIN) {
+            usleep(10000);
+        }
+        if (rc == 0) {
+            return 0;
+        }
+    } else {
+        return err;
+    }
+    int rc = snd_pcm_prepare(pcm);
+    if (rc < 0) {
+        fprintf(stderr, "无法重新准备 PCM 设备: %s\n", snd_strerror(rc));
+        return rc;
+    }
+    return 0;
+}
+
+static int alsa_read(struct CaptureSource *src, short *frame) {
+    struct alsa_capture *cap = src->priv;
+    snd_pcm_uframes_t got = 0;
+
+    while (got < src->period) {
+        int rc = snd_pcm_readi(cap->pcm, frame + got, src->period - got);
+        if (rc < 0) {
+            if (rc == -EAGAIN) { usleep(1000); continue; }
+            if (alsa_recover(src, cap->pcm, rc) < 0) {
+                fprintf(stderr, "读取错误(采集线程): %s\n", snd_strerror(rc));
+                return -1;
+            }
+            continue;
+        }
+        got += rc;
+    }
+    return 1;
+}
+
+// mmap 读取：从映射到用户空间的 DMA 缓冲区直接拷入调用方的帧（即采集环形缓冲区的槽位），
+// 不经过 read 系统调用；DMA 缓冲区回绕时 mmap_begin 给出的帧数较少，分两次拷贝
+static int alsa_mmap_read(struct CaptureSource *src, short *frame) {
+    struct alsa_capture *cap = src->priv;
+    snd_pcm_uframes_t got = 0;
+
+    while (got < src->period) {
+        if (snd_pcm_state(cap->pcm) == SND_PCM_STATE_PREPARED) {
+            int rc = snd_pcm_start(cap->pcm);
+            if (rc < 0) {
+                fprintf(stderr, "无法启动采集: %s\n", snd_strerror(rc));
+                return -1;
+            }
+        }
+
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(cap->pcm);
+        if (avail < 0) {
+            if (alsa_recover(src, cap->pcm, avail) < 0) {
+                fprintf(stderr, "读取错误(采集线程): %s\n", snd_strerror(avail));
+                return -1;
+            }
+            continue;
+        }
+        if ((snd_pcm_uframes_t)avail < src->period - got) {
+            // 数据不足时阻塞到至少有 avail_min（一个 period）可读
+            int rc = snd_pcm_wait(cap->pcm, 1000);
+            if (rc < 0 && alsa_recover(src, cap->pcm, rc) < 0) {
+                fprintf(stderr, "等待采集数据失败: %s\n", snd_strerror(rc));
+                return -1;
+            }
+            continue;
+        }
+
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset, frames = src->period - got;
+        int rc = snd_pcm_mmap_begin(cap->pcm, &areas, &offset, &frames);
+        if (rc < 0) {
+            if (alsa_recover(src, cap->pcm, rc) < 0) {
+                return -1;
+            }
+            continue;
+        }
+        // 单声道交错格式：第 offset 帧的地址 = addr + first/8 + offset * step/8
+        const unsigned char *base = (const unsigned char *)areas[0].addr + areas[0].first / 8;
+        memcpy(frame + got, base + offset * (areas[0].step / 8), frames * sizeof(short));
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(cap->pcm, offset, frames);
+        if (committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+            // 拷贝期间发生了溢出，这部分数据可能已被覆盖，丢弃重读
+            if (alsa_recover(src, cap->pcm, committed < 0 ? (int)committed : -EPIPE) < 0) {
+                return -1;
+            }
+            continue;
+        }
+        got += frames;
+    }
+    return 1;
+}
+
+// 接入事件循环：设备需处于运行状态，avail_min（一个 period）可读时描述符就绪
+static int alsa_poll_descriptors(struct CaptureSource *src, struct pollfd *fds, unsigned int space) {
+    struct alsa_capture *cap = src->priv;
+    if (snd_pcm_state(cap->pcm) == SND_PCM_STATE_PREPARED) {
+        int rc = snd_pcm_start(cap->pcm);
+        if (rc < 0) {
+            fprintf(stderr, "无法启动采集: %s\n", snd_strerror(rc));
+            return -1;
+        }
+    }
+    int count = snd_pcm_poll_descriptors_count(cap->pcm);
+    if (count <= 0 || (unsigned int)count > space) {
+        fprintf(stderr, "PCM 设备的描述符个数异常: %d\n", count);
+        return -1;
+    }
+    return snd_pcm_poll_descriptors(cap->pcm, fds, space);
+}
+
+static int alsa_poll_frames(struct CaptureSource *src, struct pollfd *fds, unsigned int nfds) {
+    struct alsa_capture *cap = src->priv;
+    unsigned short revents = 0;
+    // 插件设备（如 plughw）的描述符事件需要经过转换才能判断
+    snd_pcm_poll_descriptors_revents(cap->pcm, fds, nfds, &revents);
+    if (!(revents & (POLLIN | POLLERR))) {
+        return 0;
+    }
+    snd_pcm_sframes_t avail = snd_pcm_avail_update(cap->pcm);
+    if (avail < 0) {
+        // 溢出后重新准备并启动，本次没有可读数据
+        if (alsa_recover(src, cap->pcm, avail) < 0) {
+            return -1;
+        }
+        int rc = snd_pcm_start(cap->pcm);
+        return rc < 0 && rc != -EBADFD ? -1 : 0;
+    }
+    return avail / src->period;
+}
+
+static void alsa_close(struct CaptureSource *src) {
+    struct alsa_capture *cap = src->priv;
+    if (cap) {
+        snd_pcm_drop(cap->pcm);
+        snd_pcm_close(cap->pcm);
+        free(cap);
+        src->priv = NULL;
+    }
+}
+
+// 设置硬件参数，period_size/buffer_size 输入期望值、输出实际值；mmap 不被支持时退回读写模式
+static int alsa_set_hw_params(snd_pcm_t *pcm_handle, const struct AlsaCaptureConfig *config, int *mmap,
+                              snd_pcm_uframes_t *period_size, snd_pcm_uframes_t *buffer_size) {
+    int rc;
+    snd_pcm_hw_params_t *params;
+    unsigned int actual_rate = config->rate;
+
+    snd_pcm_hw_params_alloca(&params);
+    rc = snd_pcm_hw_params_any(pcm_handle, params);
+    if (rc < 0) {
+        fprintf(stderr, "无法获取硬件参数: %s\n", snd_strerror(rc));
+        return -1;
+    }
+
+    // 交错模式，优先使用 mmap
+    rc = -1;
+    if (*mmap) {
+        rc = snd_pcm_hw_params_set_access(pcm_handle, params, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+        if (rc < 0) {
+            fprintf(stderr, "设备不支持 mmap 访问（%s），改用读写模式\n", snd_strerror(rc));
+            *mmap = 0;
+        }
+    }
+    if (!*mmap) {
+        rc = snd_pcm_hw_params_set_access(pcm_handle, params, SND_PCM_ACCESS_RW_INTERLEAVED);
+    }
+    if (rc < 0) {
+        fprintf(stderr, "无法设置访问模式: %s\n", snd_strerror(rc));
+        return -1;
+    }
+
+    // 设置音频格式（16位小端）
+    rc = snd_pcm_hw_params_set_format(pcm_handle, params, SND_PCM_FORMAT_S16_LE);
+    if (rc < 0) {
+        fprintf(stderr, "无法设置音频格式: %s\n", snd_strerror(rc));
+        return -1;
+    }
+
+    // 设置为单声道
+    rc = snd_pcm_hw_params_set_channels(pcm_handle, params, 1);
+    if (rc < 0) {
+        fprintf(stderr, "无法设置通道数: %s\n", snd_strerror(rc));
+        return -1;
+    }
+
+    // 设置采样率，必须与请求值一致（后续的 VAD 和上传都按该采样率处理）
+    rc = snd_pcm_hw_params_set_rate_near(pcm_handle, params, &actual_rate, 0);
+    if (rc < 0 || actual_rate != config->rate) {
+        fprintf(stderr, "无法设置采样率 %u Hz（设备给出 %u Hz），可改用 plughw 设备由 ALSA 转换\n",
+                config->rate, actual_rate);
+        return -1;
+    }
+
+    // 设置期望的 period size，并取回实际值
+    rc = snd_pcm_hw_params_set_period_size_near(pcm_handle, params, period_size, 0);
+    if (rc < 0) {
+        fprintf(stderr, "无法设置 period size: %s\n", snd_strerror(rc));
+        return -1;
+    }
+
+    rc = snd_pcm_hw_params_set_buffer_size_near(pcm_handle, params, buffer_size);
+    if (rc < 0) {
+        fprintf(stderr, "无法设置缓冲区大小: %s\n", snd_strerror(rc));
+        return -1;
+    }
+
+    rc = snd_pcm_hw_params(pcm_handle, params);
+    if (rc < 0) {
+        fprintf(stderr, "无法设置硬件参数: %s\n", snd_strerror(rc));
+        return -1;
+    }
+    snd_pcm_hw_params_get_period_size(params, period_size, 0);
+    snd_pcm_hw_params_get_buffer_size(params, buffer_size);
+    return 0;
+}
+
+// 软件参数：至少一个 period 可读时才唤醒；采集由第一次读取启动
+static int alsa_set_sw_params(snd_pcm_t *pcm_handle, snd_pcm_uframes_t period_size) {
+    snd_pcm_sw_params_t *params;
+    snd_pcm_sw_params_alloca(&params);
+    int rc = snd_pcm_sw_params_current(pcm_handle, params);
+    if (rc >= 0) rc = snd_pcm_sw_params_set_avail_min(pcm_handle, params, period_size);
+    if (rc >= 0) rc = snd_pcm_sw_params_set_start_threshold(pcm_handle, params, 1);
+    if (rc >= 0) rc = snd_pcm_sw_params(pcm_handle, params);
+    if (rc < 0) {
+        fprintf(stderr, "无法设置软件参数: %s\n", snd_strerror(rc));
+        return -1;
+    }
+    return 0;
+}
+
+int capture_source_open_alsa(struct CaptureSource *src, const struct AlsaCaptureConfig *config) {
+    snd_pcm_t *pcm_handle = NULL;
+    snd_pcm_uframes_t period_size = config->period;
+    snd_pcm_uframes_t buffer_size = config->period * config->buffer_periods;
+    int mmap = config->mmap;
+
+    // 打开 PCM 设备
+    int rc = snd_pcm_open(&pcm_handle, config->device, SND_PCM_STREAM_CAPTURE, 0);
+    if (rc < 0) {
+        fprintf(stderr, "无法打开 PCM 设备 %s: %s\n", config->device, snd_strerror(rc));
+        return -1;
+    }
+    if (alsa_set_hw_params(pcm_handle, config, &mmap, &period_size, &buffer_size) != 0 ||
+        alsa_set_sw_params(pcm_handle, period_size) != 0) {
+        snd_pcm_close(pcm_handle);
+        return -1;
+    }
+    rc = snd_pcm_prepare(pcm_handle);
+    if (rc < 0) {
+        fprintf(stderr, "无法准备 PCM 设备: %s\n", snd_strerror(rc));
+        snd_pcm_close(pcm_handle);
+        return -1;
+    }
+
+    struct alsa_capture *cap = malloc(sizeof(*cap));
+    if (!cap) {
+        snd_pcm_close(pcm_handle);
+        return -1;
+    }
+    cap->pcm = pcm_handle;
+    cap->mmap = mmap;
+
+    printf("设备 %s：采样率 %u Hz，period %lu 帧（%.0f ms），缓冲区 %lu 帧（%.0f ms），%s\n",
+           config->device, config->rate, (unsigned long)period_size, 1000.0 * period_size / config->rate,
+           (unsigned long)buffer_size, 1000.0 * buffer_size / config->rate, mmap ? "mmap 访问" : "读写访问");
+
+    src->name = config->device;
+    src->rate = config->rate;
+    src->period = period_size;
+    atomic_init(&src->xruns, 0);
+    src->read = mmap ? alsa_mmap_read : alsa_read;
+    src->close = alsa_close;
+    src->poll_descriptors = alsa_poll_descriptors;
+    src->poll_frames = alsa_poll_frames;
+    src->priv = cap;
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef CAPTURE_SOURCE_H
+#define CAPTURE_SOURCE_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <poll.h>
+
+#define CAPTURE_ALSA_DEVICE "plughw:3,0"  // 使用 plughw 接口，使 ALSA 自动转换采样率
+#define CAPTURE_ALSA_RATE   16000
+#define CAPTURE_ALSA_PERIOD 320           // 20ms
+#define CAPTURE_ALSA_BUFFER_PERIODS 8     // 缓冲区 160ms，采集线程短暂卡顿不会溢出
+#define CAPTURE_WAV_PAD_MS  1000          // 回放 WAV 时默认在前后补的静音时长
+
+// 采集源：采集线程只通过 read/close 访问，不关心数据来自声卡还是文件
+// 打开函数负责填写全部字段，period 为实际每帧采样数（可能与请求值不同）
+struct CaptureSource {
+    const char *name;
+    unsigned int rate;
+    size_t period;
+    atomic_ulong xruns;  // 设备溢出次数（回放源始终为 0）
+
+    // 读取一整帧（period 个采样），成功返回 1，数据读完返回 0，出错返回 -1
+    int (*read)(struct CaptureSource *src, short *frame);
+    void (*close)(struct CaptureSource *src);
+
+    // 单线程事件循环使用（不支持时为 NULL）：poll_descriptors 启动采集并填写需要监视的描述符，
+    // 返回个数；描述符就绪后调用 poll_frames（fds 中带有 revents），返回现在可以不阻塞读取的帧数
+    int (*poll_descriptors)(struct CaptureSource *src, struct pollfd *fds, unsigned int space);
+    int (*poll_frames)(struct CaptureSource *src, struct pollfd *fds, unsigned int nfds);
+    void *priv;
+};
+
+// WAV 回放参数
+struct CaptureWavOptions {
+    int realtime;          // 1：按采样率限速，模拟麦克风；0：尽快读出，用于离线基准
+    int loop;              // 1：读到结尾后从头重放（不返回 0）
+    unsigned int pad_ms;   // 文件前后各补的静音，保证端点检测能看到完整的起止
+};
+
+// ALSA 采集参数
+struct AlsaCaptureConfig {
+    const char *device;
+    unsigned int rate;
+    size_t period;                // 每帧采样数（期望值，设备可能调整）
+    unsigned int buffer_periods;  // 缓冲区能容纳的 period 数，至少 2
+    int mmap;                     // 1：MMAP_INTERLEAVED 直接从 DMA 缓冲区取数据，设备不支持时退回读写模式
+};
+
+// 默认参数：CAPTURE_ALSA_* 宏，mmap 访问
+void capture_alsa_config_default(struct AlsaCaptureConfig *config);
+
+// 用环境变量覆盖参数：QYAI_PCM_DEVICE、QYAI_PCM_RATE、QYAI_PCM_PERIOD、
+// QYAI_PCM_BUFFER_PERIODS、QYAI_PCM_ACCESS（mmap 或 rw）
+void capture_alsa_config_from_env(struct AlsaCaptureConfig *config);
+
+// ALSA 采集：16 位单声道交错模式；溢出计入 xruns 并输出警告后恢复
+int capture_source_open_alsa(struct CaptureSource *src, const struct AlsaCaptureConfig *config);
+
+// WAV 回放：只支持 16 位单声道 PCM，采样率必须与 rate 一致
+// 实时回放可以接入事件循环（由 timerfd 按帧长限速），非实时回放不支持
+int capture_source_open_wav(struct CaptureSource *src, const char *path,
+                            unsigned int rate, size_t period, const struct CaptureWavOptions *options);
+
+// 回放源中文件数据的起始位置和时长（采样数，不含补的静音），用于计算检测延迟
+void capture_source_wav_bounds(const struct CaptureSource *src, size_t *begin, size_t *samples);
+
+#endif // CAPTURE_SOURCE_H
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "capture_source.h"
+
+// 回放状态：时间轴为 [pad 静音][文件数据][pad 静音]
+struct wav_replay {
+    FILE *fp;
+    long data_offset;       // data 块在文件中的偏移
+    size_t data_samples;    // 文件中的采样数
+    size_t pad_samples;     // 前后各补的静音采样数
+    size_t pos;             // 当前在时间轴上的位置
+    int realtime;
+    int loop;
+    unsigned long frames;   // 已读出的帧数，用于限速
+    struct timespec start;  // 第一帧的读取时间
+    int timer_fd;           // 接入事件循环时按帧长触发的定时器，-1 表示未使用
+};
+
+static uint32_t read_le32(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_le16(const unsigned char *p) {
+    return p[0] | (p[1] << 8);
+}
+
+// 逐块查找 fmt 和 data，兼容带 LIST 等附加块的文件
+static int wav_parse(struct wav_replay *wav, const char *path, unsigned int rate) {
+    unsigned char hdr[12];
+    if (fread(hdr, 1, 12, wav->fp) != 12 || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "不是 WAV 文件: %s\n", path);
+        return -1;
+    }
+
+    int have_fmt = 0;
+    unsigned char chunk[8];
+    while (fread(chunk, 1, 8, wav->fp) == 8) {
+        uint32_t size = read_le32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, wav->fp) != 16) {
+                break;
+            }
+            uint16_t format = read_le16(fmt), channels = read_le16(fmt + 2), bits = read_le16(fmt + 14);
+            uint32_t file_rate = read_le32(fmt + 4);
+            if (format != 1 || channels != 1 || bits != 16 || file_rate != rate) {
+                fprintf(stderr, "%s: 只支持 %uHz 16 位单声道 PCM（文件为格式 %u，%u 声道，%u 位，%uHz）\n",
+                        path, rate, format, channels, bits, file_rate);
+                return -1;
+            }
+            have_fmt = 1;
+            size -= 16;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_fmt) {
+                break;
+            }
+            wav->data_offset = ftell(wav->fp);
+            wav->data_samples = size / sizeof(short);
+            // 录音异常中断的文件 data 长度可能未回填，以实际文件长度为准
+            fseek(wav->fp, 0, SEEK_END);
+            size_t actual = (size_t)(ftell(wav->fp) - wav->data_offset) / sizeof(short);
+            if (size == 0 || actual < wav->data_samples) {
+                wav->data_samples = actual;
+            }
+            fseek(wav->fp, wav->data_offset, SEEK_SET);
+            return 0;
+        }
+        fseek(wav->fp, size + (size & 1), SEEK_CUR);  // 块长度为奇数时有 1 字节填充
+    }
+    fprintf(stderr, "WAV 文件缺少 fmt 或 data 块: %s\n", path);
+    return -1;
+}
+
+// 按采样率限速：第 n 帧在 start + n * period / rate 之后才返回
+static void wav_pace(struct CaptureSource *src, struct wav_replay *wav) {
+    if (wav->frames == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &wav->start);
+        return;
+    }
+    uint64_t offset_ns = (uint64_t)wav->frames * src->period * 1000000000ull / src->rate;
+    struct timespec due = wav->start;
+    due.tv_sec += offset_ns / 1000000000ull;
+    due.tv_nsec += offset_ns % 1000000000ull;
+    if (due.tv_nsec >= 1000000000L) {
+        due.tv_sec++;
+        due.tv_nsec -= 1000000000L;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+}
+
+static int wav_read(struct CaptureSource *src, short *frame) {
+    struct wav_replay *wav = src->priv;
+    size_t total = wav->data_samples + 2 * wav->pad_samples;
+    size_t filled = 0;
+
+    if (total == 0) {
+        return 0;
+    }
+    while (filled < src->period) {
+        if (wav->pos >= total) {
+            if (!wav->loop) {
+                break;
+            }
+            wav->pos = 0;
+            fseek(wav->fp, wav->data_offset, SEEK_SET);
+        }
+        size_t want = src->period - filled;
+        size_t data_begin = wav->pad_samples, data_end = wav->pad_samples + wav->data_samples;
+        size_t n;
+        if (wav->pos < data_begin || wav->pos >= data_end) {
+            // 前后补的静音
+            size_t limit = wav->pos < data_begin ? data_begin : total;
+            n = limit - wav->pos < want ? limit - wav->pos : want;
+            memset(frame + filled, 0, n * sizeof(short));
+        } else {
+            n = data_end - wav->pos < want ? data_end - wav->pos : want;
+            size_t got = fread(frame + filled, sizeof(short), n, wav->fp);
+            if (got < n) {
+                fprintf(stderr, "读取 WAV 数据失败\n");
+                return -1;
+            }
+        }
+        filled += n;
+        wav->pos += n;
+    }
+
+    if (filled == 0) {
+        return 0;
+    }
+    // 最后一帧不足时补零
+    memset(frame + filled, 0, (src->period - filled) * sizeof(short));
+    if (wav->realtime) {
+        wav_pace(src, wav);
+    }
+    wav->frames++;
+    return 1;
+}
+
+// 接入事件循环：由周期为一帧的 timerfd 代替 clock_nanosleep 限速
+static int wav_poll_descriptors(struct CaptureSource *src, struct pollfd *fds, unsigned int space) {
+    struct wav_replay *wav = src->priv;
+    if (!wav->realtime) {
+        fprintf(stderr, "非实时回放不能接入事件循环\n");
+        return -1;
+    }
+    if (space < 1) {
+        return -1;
+    }
+    if (wav->timer_fd < 0) {
+        wav->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (wav->timer_fd < 0) {
+            fprintf(stderr, "无法创建回放定时器\n");
+            return -1;
+        }
+        long period_ns = (long)(src->period * 1000000000ull / src->rate);
+        struct itimerspec spec = { { 0, period_ns }, { 0, period_ns } };
+        timerfd_settime(wav->timer_fd, 0, &spec, NULL);
+        wav->realtime = 0;  // 读取时不再睡眠
+    }
+    fds[0].fd = wav->timer_fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    return 1;
+}
+
+// 定时器到期次数即可读帧数（事件循环卡顿时会一次补读多帧）
+static int wav_poll_frames(struct CaptureSource *src, struct pollfd *fds, unsigned int nfds) {
+    struct wav_replay *wav = src->priv;
+    uint64_t expirations;
+    (void)fds; (void)nfds;
+    if (read(wav->timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return 0;
+    }
+    return (int)expirations;
+}
+
+static void wav_close(struct CaptureSource *src) {
+    struct wav_replay *wav = src->priv;
+    if (wav) {
+        if (wav->timer_fd >= 0) {
+            close(wav->timer_fd);
+        }
+        fclose(wav->fp);
+        free(wav);
+        src->priv = NULL;
+    }
+}
+
+int capture_source_open_wav(struct CaptureSource *src, const char *path,
+                            unsigned int rate, size_t period, const struct CaptureWavOptions *options) {
+    struct wav_replay *wav = calloc(1, sizeof(*wav));
+    if (!wav) {
+        fprintf(stderr, "WAV 回放状态分配失败\n");
+        return -1;
+    }
+    wav->fp = fopen(path, "rb");
+    if (!wav->fp) {
+        fprintf(stderr, "无法打开 WAV 文件: %s\n", path);
+        free(wav);
+        return -1;
+    }
+    if (wav_parse(wav, path, rate) != 0) {
+        fclose(wav->fp);
+        free(wav);
+        return -1;
+    }
+    wav->pad_samples = (size_t)options->pad_ms * rate / 1000;
+    wav->realtime = options->realtime;
+    wav->loop = options->loop;
+    wav->timer_fd = -1;
+
+    src->name = path;
+    src->rate = rate;
+    src->period = period;
+    atomic_init(&src->xruns, 0);
+    src->read = wav_read;
+    src->close = wav_close;
+    src->poll_descriptors = wav_poll_descriptors;
+    src->poll_frames = wav_poll_frames;
+    src->priv = wav;
+    return 0;
+}
+
+void capture_source_wav_bounds(const struct CaptureSource *src, size_t *begin, size_t *samples) {
+    const struct wav_replay *wav = src->priv;
+    *begin = wav->pad_samples;
+    *samples = wav->data_samples;
+}
@@ -1,106 +1,296 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <curl/curl.h>
+#include <json-c/json.h>
 #include "chat.h"
+#include "http_client.h"
+#include "trace.h"
 
-// CURL 回调：动态扩展 buffer，安全地拼接响应数据
-static size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp) {
-    size_t realsz = size * nmemb;
-    struct Memory *mem = (struct Memory *)userp;
-
-    // 为新的数据分配内存
-    char *ptr = realloc(mem->data, mem->size + realsz + 1);
-    if (!ptr) {
-        fprintf(stderr, "内存分配失败\n");
-        return 0;
-    }
-    mem->data = ptr;
-
-    // 将新接收到的数据复制到内存中
-    memcpy(&(mem->data[mem->size]), contents, realsz);
-    mem->size += realsz;
-    mem->data[mem->size] = 0;  // 末尾添加 NUL 字符表示结束
-    return realsz;
+// 生成请求体 {"message": "..."}，由 json-c 负责转义引号、换行等字符
+static void build_chat_request(const char *query, char *out, size_t out_size) {
+    struct json_object *obj = json_object_new_object();
+    json_object_object_add(obj, "message", json_object_new_string(query));
+    snprintf(out, out_size, "%s", json_object_to_json_string_ext(obj, JSON_C_TO_STRING_PLAIN));
+    json_object_put(obj);
 }
 
-// 获取AI的响应数据
-int get_ai_response(const char *query, struct Memory *mem) {
-    CURL *curl;
+// 获取AI的响应数据（使用 http_client 中长期复用的 /chat/ 连接）
+int get_ai_response(const char *query, struct Memory *mem, struct Trace *trace) {
+    CURL *curl = http_client_handle(HTTP_ENDPOINT_CHAT);
     CURLcode res;
+    struct HttpTiming timing;
 
-    // 初始化CURL库
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl = curl_easy_init();
     if (!curl) {
-        fprintf(stderr, "无法初始化 CURL\n");
+        fprintf(stderr, "CURL 未初始化\n");
         return -1;
     }
 
-    // 设置目标URL和请求数据
-    const char *url = "http://192.168.2.118:8000/chat/";  // 你的AI服务地址
-    char post_data[512];
-    snprintf(post_data, sizeof(post_data), "{\"message\":\"%s\"}", query);
-
-    // 配置CURL的请求参数
-    curl_easy_setopt(curl, CURLOPT_URL, url);
+    // 设置请求数据（URL 和请求头已在 http_client_init 中预设）
+    char post_data[2048];
+    build_chat_request(query, post_data, sizeof(post_data));
     curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data);
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
 
-    // 为响应数据分配内存
-    mem->data = malloc(1);
+    // 清空响应缓冲区（定长缓冲区由调用方预先分配）
     mem->size = 0;
+    if (mem->data) {
+        mem->data[0] = '\0';
+    }
 
     // 设置CURL的回调函数，用来接收响应数据
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, memory_write_callback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)mem);
 
     // 执行请求
-    res = curl_easy_perform(curl);
+    trace_mark(trace, TRACE_CHAT_REQUEST);
+    res = http_client_perform(HTTP_ENDPOINT_CHAT, trace ? trace->id : NULL, &timing);
+    trace_mark(trace, TRACE_CHAT_REPLY);
     if (res != CURLE_OK) {
         fprintf(stderr, "请求失败: %s\n", curl_easy_strerror(res));
-        curl_easy_cleanup(curl);
-        curl_slist_free_all(headers);
-        curl_global_cleanup();
         return -1;
     }
 
-    // 清理CURL资源
-    curl_easy_cleanup(curl);
-    curl_slist_free_all(headers);
-    curl_global_cleanup();
+    printf("对话请求耗时 %.1f ms（连接 %.1f ms，传输 %.1f ms，新建连接 %ld）\n",
+           timing.total_ms, timing.connect_ms, timing.transfer_ms, timing.new_connections);
     return 0;
 }
 
-// 解析AI的响应数据，提取消息和命令
-int parse_ai_response(struct Memory *mem, struct AIResponse *response) {
-    // 提取 reply 字段中的消息内容
-    char *start = strstr(mem->data, "\"reply\":\"");
-    if (start) {
-        start += strlen("\"reply\":\"");
-        char *end = strchr(start, '"');
-        if (end) {
-            size_t msg_len = end - start;
-            strncpy(response->msg, start, msg_len);
-            response->msg[msg_len] = '\0';
+// 向回答中追加文本，超出长度时截断
+static void msg_append(struct ChatStreamParser *p, const char *text, size_t len) {
+    size_t room = sizeof(p->response->msg) - 1 - p->msg_len;
+    if (len > room) {
+        len = room;
+    }
+    memcpy(p->response->msg + p->msg_len, text, len);
+    p->msg_len += len;
+    p->response->msg[p->msg_len] = '\0';
+}
+
+// 标记不完整或不合法时，把已吞掉的字符原样还给回答文本
+static void marker_abort(struct ChatStreamParser *p) {
+    msg_append(p, "<|", p->marker_state >= 2 ? 2 : 1);
+    msg_append(p, p->marker, p->marker_len);
+    if (p->marker_state == 3) {
+        msg_append(p, "|", 1);
+    }
+    p->marker_state = 0;
+    p->marker_len = 0;
+}
+
+// 逐字节扫描回答文本，普通文本写入 msg，完整的 <|cmd|> 标记立即回调
+static void scan_text(struct ChatStreamParser *p, const char *text, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        char c = text[i];
+        switch (p->marker_state) {
+        case 0:
+            if (c == '<') {
+                p->marker_state = 1;
+            } else {
+                msg_append(p, &c, 1);
+            }
+            break;
+        case 1:
+            if (c != '|') {
+                marker_abort(p);
+                continue;  // 重新处理当前字符
+            }
+            p->marker_state = 2;
+            p->marker_len = 0;
+            break;
+        case 2:
+            if (c == '|') {
+                p->marker_state = 3;
+            } else if ((isalnum((unsigned char)c) || c == '_') && p->marker_len < sizeof(p->marker) - 1) {
+                p->marker[p->marker_len++] = c;
+            } else {
+                marker_abort(p);
+                continue;
+            }
+            break;
+        case 3:
+            if (c != '>' || p->marker_len == 0) {
+                marker_abort(p);
+                continue;
+            }
+            p->marker[p->marker_len] = '\0';
+            if (!p->response->cmd[0]) {
+                snprintf(p->response->cmd, sizeof(p->response->cmd), "%s", p->marker);
+            }
+            p->commands++;
+            if (p->on_command) {
+                p->on_command(p->marker, p->userdata);
+            }
+            p->marker_state = 0;
+            p->marker_len = 0;
+            break;
         }
+        i++;
     }
+}
+
+// 回答结束时还未闭合的标记按普通文本处理
+static void scan_finish(struct ChatStreamParser *p) {
+    if (p->marker_state != 0) {
+        marker_abort(p);
+    }
+}
 
-    // 提取命令字段，通常是控制指令
-    char *action_buf = response->cmd;
-    char *tok_start = strstr(mem->data, "<|");
-    if (tok_start) {
-        char *tok_end = strstr(tok_start, "|>");
-        if (tok_end && tok_end > tok_start + 2) {
-            size_t len = tok_end - tok_start - 2;
-            if (len < sizeof(response->cmd)) {
-                strncpy(action_buf, tok_start + 2, len);
-                action_buf[len] = '\0';
+void chat_stream_parser_init(struct ChatStreamParser *parser, struct AIResponse *response,
+                             chat_command_fn on_command, void *userdata) {
+    memset(parser, 0, sizeof(*parser));
+    memset(response, 0, sizeof(*response));
+    parser->response = response;
+    parser->on_command = on_command;
+    parser->userdata = userdata;
+}
+
+void chat_stream_parser_expect_text(struct ChatStreamParser *parser, char *text, size_t size,
+                                    chat_text_fn on_text, struct Trace *trace) {
+    parser->text = text;
+    parser->text_size = size;
+    parser->on_text = on_text;
+    parser->has_text = 0;
+    parser->trace = trace;
+    text[0] = '\0';
+}
+
+// 处理一行 JSON：{"text": "..."}（/converse/）、{"delta": "..."} 或 {"done": true, ...}
+static void parse_stream_line(struct ChatStreamParser *p, const char *line) {
+    struct json_object *obj = json_tokener_parse(line);
+    struct json_object *field;
+    if (!obj) {
+        fprintf(stderr, "无法解析流式回答: %s\n", line);
+        return;
+    }
+    if (p->text && !p->has_text && json_object_object_get_ex(obj, "text", &field)) {
+        snprintf(p->text, p->text_size, "%s", json_object_get_string(field));
+        p->has_text = 1;
+        trace_mark(p->trace, TRACE_STT_REPLY);
+        trace_mark(p->trace, TRACE_CHAT_REQUEST);
+        if (p->on_text) {
+            p->on_text(p->text, p->userdata);
+        }
+    }
+    if (json_object_object_get_ex(obj, "delta", &field)) {
+        scan_text(p, json_object_get_string(field), json_object_get_string_len(field));
+    }
+    if (json_object_object_get_ex(obj, "done", &field)) {
+        scan_finish(p);
+        p->done = 1;
+        // /converse/ 的结束行带有服务端提取的命令，回答文本中没有解析出标记时以它为准
+        if (p->commands == 0 && json_object_object_get_ex(obj, "cmd", &field) &&
+            json_object_get_string_len(field) > 0) {
+            snprintf(p->response->cmd, sizeof(p->response->cmd), "%s", json_object_get_string(field));
+            p->commands++;
+            if (p->on_command) {
+                p->on_command(p->response->cmd, p->userdata);
             }
         }
     }
+    json_object_put(obj);
+}
+
+void chat_stream_parser_feed(struct ChatStreamParser *parser, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != '\n') {
+            if (parser->line_len < sizeof(parser->line) - 1) {
+                parser->line[parser->line_len++] = data[i];
+            }
+            continue;
+        }
+        parser->line[parser->line_len] = '\0';
+        if (parser->line_len > 0) {
+            parse_stream_line(parser, parser->line);
+        }
+        parser->line_len = 0;
+    }
+}
+
+// CURL 回调：收到的数据直接交给增量解析器，不缓存整个回答
+static size_t stream_write_callback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsz = size * nmemb;
+    chat_stream_parser_feed((struct ChatStreamParser *)userp, (const char *)contents, realsz);
+    return realsz;
+}
+
+void chat_stream_attach(CURL *curl, struct ChatStreamParser *parser) {
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, stream_write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)parser);
+}
+
+int chat_stream_prepare(CURL *curl, const char *query, char *post_data, size_t post_size,
+                        struct ChatStreamParser *parser, struct Trace *trace) {
+    if (!curl) {
+        fprintf(stderr, "CURL 未初始化\n");
+        return -1;
+    }
+    build_chat_request(query, post_data, post_size);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, post_data);
+    chat_stream_attach(curl, parser);
+    trace_mark(trace, TRACE_CHAT_REQUEST);
+    return 0;
+}
+
+int chat_stream_complete(CURL *curl, struct ChatStreamParser *parser, CURLcode result, struct Trace *trace) {
+    struct HttpTiming timing;
+
+    trace_mark(trace, TRACE_CHAT_REPLY);
+    if (result != CURLE_OK) {
+        fprintf(stderr, "请求失败: %s\n", curl_easy_strerror(result));
+        return -1;
+    }
+    if (parser->line_len > 0) {
+        // 最后一行没有换行符
+        chat_stream_parser_feed(parser, "\n", 1);
+    }
+    scan_finish(parser);
+
+    http_client_get_timing(curl, &timing);
+    printf("流式对话耗时 %.1f ms（连接 %.1f ms，新建连接 %ld）\n",
+           timing.total_ms, timing.connect_ms, timing.new_connections);
+    if (!parser->done) {
+        // 连接正常关闭但没有结束行（服务端出错或中途断开），回答可能被截断，不能缓存
+        fprintf(stderr, "流式回答不完整：没有收到结束行\n");
+        return -1;
+    }
+    return 0;
+}
+
+// 流式获取AI的响应数据
+int get_ai_response_stream(const char *query, struct ChatStreamParser *parser, struct Trace *trace) {
+    CURL *curl = http_client_handle(HTTP_ENDPOINT_CHAT_STREAM);
+    char post_data[2048];
+
+    if (chat_stream_prepare(curl, query, post_data, sizeof(post_data), parser, trace) != 0) {
+        return -1;
+    }
+    CURLcode res = http_client_perform(HTTP_ENDPOINT_CHAT_STREAM, trace ? trace->id : NULL, NULL);
+    return chat_stream_complete(curl, parser, res, trace);
+}
+
+// 解析AI的响应数据，提取消息和命令
+// 使用 json-c 解析 reply 字段，正确处理转义字符；命令标记从回答文本中提取
+int parse_ai_response(struct Memory *mem, struct AIResponse *response) {
+    struct ChatStreamParser parser;
+    chat_stream_parser_init(&parser, response, NULL, NULL);
+
+    if (!mem->data) {
+        return -1;
+    }
+    struct json_object *obj = json_tokener_parse(mem->data);
+    struct json_object *reply;
+    if (!obj || !json_object_object_get_ex(obj, "reply", &reply)) {
+        fprintf(stderr, "AI响应中未找到 'reply' 字段: %s\n", mem->data);
+        if (obj) {
+            json_object_put(obj);
+        }
+        return -1;
+    }
 
+    scan_text(&parser, json_object_get_string(reply), json_object_get_string_len(reply));
+    scan_finish(&parser);
+    json_object_put(obj);
     return 0;
 }
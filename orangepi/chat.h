@@ -2,21 +2,80 @@
 #define CHAT_H
 
 #include <stddef.h>
+#include <curl/curl.h>
+#include "arena.h"
+#include "trace.h"
 
-// 用于保存AI回应的结构体
-struct Memory {
-    char *data;
-    size_t size;
-};
+#define CHAT_RESPONSE_SIZE 16384  // /chat/ 完整响应缓冲区大小
+
+#ifndef CHAT_STREAMING
+#define CHAT_STREAMING 1  // 1：使用 /chat/stream/ 边生成边解析；0：等待完整回答
+#endif
 
 // 用于表示AI回应的结构体，包括消息和命令
 struct AIResponse {
-    char msg[1024];  // 存储AI的回答
+    char msg[1024];  // 存储AI的回答（已去掉 <|…|> 标记）
     char cmd[64];    // 存储指令（如控制命令）
 };
 
+// 收到完整命令标记时的回调
+typedef void (*chat_command_fn)(const char *cmd, void *userdata);
+
+// /converse/ 返回识别结果时的回调
+typedef void (*chat_text_fn)(const char *text, void *userdata);
+
+// 流式回答的增量解析器：在 cURL 写回调中逐块喂入数据，
+// 按行解析 {"delta": "..."}，一旦拼出完整的 <|…|> 标记立即回调
+struct ChatStreamParser {
+    char line[4096];            // 未完成的一行
+    size_t line_len;
+    int marker_state;           // 0：普通文本，1：收到 '<'，2：标记内，3：标记内收到 '|'
+    char marker[64];            // 正在拼接的命令名
+    size_t marker_len;
+    struct AIResponse *response;
+    size_t msg_len;
+    chat_command_fn on_command;
+    void *userdata;
+    int done;                   // 收到结束行
+    int commands;               // 已回调的命令数
+    char *text;                 // /converse/ 的识别结果写入这里，不需要时为 NULL
+    size_t text_size;
+    chat_text_fn on_text;
+    int has_text;               // 已收到识别结果
+    struct Trace *trace;        // 收到识别结果时记录 TRACE_STT_REPLY 和 TRACE_CHAT_REQUEST，可为 NULL
+};
+
 // 函数声明
-int get_ai_response(const char *query, struct Memory *mem);
+// mem 为定长缓冲区（见 memory_init）时不申请内存，回答超长则请求失败
+// trace 不为 NULL 时记录请求和回答的时间点，并把追踪 ID 发给服务端
+int get_ai_response(const char *query, struct Memory *mem, struct Trace *trace);
 int parse_ai_response(struct Memory *mem, struct AIResponse *response);
 
+// 初始化解析器，response 会被清空并在解析过程中填写
+void chat_stream_parser_init(struct ChatStreamParser *parser, struct AIResponse *response,
+                             chat_command_fn on_command, void *userdata);
+
+// 用于 /converse/：响应的第一行 {"text": "..."} 为识别结果，写入 text 并回调 on_text（可为 NULL）
+// 服务端在识别结束后立即开始生成回答，因此识别结果到达的时刻同时记为对话请求的时刻
+void chat_stream_parser_expect_text(struct ChatStreamParser *parser, char *text, size_t size,
+                                    chat_text_fn on_text, struct Trace *trace);
+
+// 喂入一块原始响应数据（可在任意字节处切分）
+void chat_stream_parser_feed(struct ChatStreamParser *parser, const char *data, size_t len);
+
+// 请求 /chat/stream/，边接收边解析，命令在生成过程中即通过回调触发
+int get_ai_response_stream(const char *query, struct ChatStreamParser *parser, struct Trace *trace);
+
+// 把 curl 的响应数据交给解析器（/chat/stream/ 和 /converse/ 共用）
+void chat_stream_attach(CURL *curl, struct ChatStreamParser *parser);
+
+// 为 curl_multi 准备一次流式对话请求（curl 通常来自 http_client_dup_handle）
+// post_data 用于存放请求体，需在请求结束前保持有效；请求结束后调用 chat_stream_complete
+int chat_stream_prepare(CURL *curl, const char *query, char *post_data, size_t post_size,
+                        struct ChatStreamParser *parser, struct Trace *trace);
+
+// 请求结束后收尾：解析最后一行、闭合未完成的标记并输出耗时
+// result 不为 CURLE_OK 或没有收到 {"done": ...} 结束行（回答可能被截断）时返回 -1
+int chat_stream_complete(CURL *curl, struct ChatStreamParser *parser, CURLcode result, struct Trace *trace);
+
 #endif // CHAT_H
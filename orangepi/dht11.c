@@ -1,9 +1,31 @@
+#include <errno.h>
+#include <stdatomic.h>
+#include <time.h>
 #include "dht11.h"
 
 // DHT11传感器所连接的GPIO引脚
 int pinNumber = 6;  // GPIO6引脚用于读取数据
-uint32 databuf;
-int blockFlag;
+
+// 最新读数，采样线程写、其他线程读，用 seqlock 发布：
+// 序号为奇数表示正在写入，读者发现序号变化或为奇数时重读
+static atomic_uint reading_seq = 0;
+static atomic_int latest_humidity_x10;
+static atomic_int latest_temperature_x10;
+static _Atomic uint64_t latest_timestamp_ns = 0;  // 0 表示还没有有效读数
+
+static atomic_ulong stat_ok, stat_timeouts, stat_bad_crc, stat_invalid;
+
+static pthread_t sampler_tid;
+static dht11_sample_fn sampler_callback = NULL;
+static int sampler_running = 0;
+static pthread_mutex_t sampler_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sampler_cond = PTHREAD_COND_INITIALIZER;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
 
 // GPIO初始化
 void GPIO_init(int gpio_pin)
@@ -21,71 +43,187 @@ void DHT11_Start_Sig()
     digitalWrite(pinNumber, LOW);
     delay(25);   // 维持25ms低电平
     digitalWrite(pinNumber, HIGH);
-    
+
     pinMode(pinNumber, INPUT);
     pullUpDnControl(pinNumber, PUD_UP);  // 上拉电阻，增强稳定性
     delayMicroseconds(35);  // 等待35微秒
 }
 
-// 读取传感器数据
-void* readSensorData(void *arg)
+// 等待引脚变为 level，返回等待的微秒数，超时返回 -1
+static int wait_level(int level)
 {
-    uint8 crc;   
-    uint8 i;    
-    int attempt = 5;   // 尝试次数
-
-    while (attempt) {
-        databuf = 0;    // 清空数据存储buf
-        crc = 0;        // 清空校验位数据存储
-        DHT11_Start_Sig(); 
-        
-        // 检测DHT11是否响应
-        if (digitalRead(pinNumber) == 0) {
-            while (!digitalRead(pinNumber)); // 等待高电平
-            
-            // 读取32位数据
-            for (i = 0; i < 32; i++) {
-                while (digitalRead(pinNumber));  // 数据时钟开始
-                while (!digitalRead(pinNumber)); // 数据开始
-                delayMicroseconds(HIGH_TIME);   // 检测32微秒的高电平
-                databuf *= 2;  // 移位
-                if (digitalRead(pinNumber) == 1) {
-                    databuf++; // 如果是高电平，则该位为1
-                }
-            }
-            
-            // 读取校验位
-            for (i = 0; i < 8; i++) {
-                while (digitalRead(pinNumber));  // 数据时钟开始
-                while (!digitalRead(pinNumber)); // 数据开始
-                delayMicroseconds(HIGH_TIME);
-                crc *= 2;  
-                if (digitalRead(pinNumber) == 1) {
-                    crc++; // 如果是高电平，则该位为1
-                }
+    unsigned int start = micros();
+    while (digitalRead(pinNumber) != level) {
+        unsigned int elapsed = micros() - start;
+        if (elapsed > DHT11_EDGE_TIMEOUT_US) {
+            return -1;
+        }
+    }
+    return (int)(micros() - start);
+}
+
+// 读取传感器数据：按电平持续时间判断每一位，而不是固定延时后采样
+int dht11_read(struct Dht11Reading *reading)
+{
+    uint8 data[5] = {0};
+
+    DHT11_Start_Sig();
+
+    // 传感器响应：约 80us 低电平 + 80us 高电平，随后进入第一位的低电平
+    if (wait_level(LOW) < 0 || wait_level(HIGH) < 0 || wait_level(LOW) < 0) {
+        atomic_fetch_add(&stat_timeouts, 1);
+        return -1;
+    }
+
+    // 40 位数据：湿度整数、湿度小数、温度整数、温度小数、校验和
+    for (int i = 0; i < 40; i++) {
+        if (wait_level(HIGH) < 0) {      // 每位开头约 50us 低电平
+            atomic_fetch_add(&stat_timeouts, 1);
+            return -1;
+        }
+        int high_us = wait_level(LOW);   // 高电平持续时间决定该位是 0 还是 1
+        if (high_us < 0) {
+            atomic_fetch_add(&stat_timeouts, 1);
+            return -1;
+        }
+        data[i / 8] <<= 1;
+        if (high_us > DHT11_BIT_THRESHOLD_US) {
+            data[i / 8] |= 1;
+        }
+    }
+
+    if ((uint8)(data[0] + data[1] + data[2] + data[3]) != data[4]) {
+        atomic_fetch_add(&stat_bad_crc, 1);
+        return -1;
+    }
+    // 温度大于50°C，则认为数据无效
+    if (data[2] > 50 || data[0] > 100) {
+        atomic_fetch_add(&stat_invalid, 1);
+        return -1;
+    }
+
+    reading->humidity_x10 = data[0] * 10 + data[1] % 10;
+    reading->temperature_x10 = data[2] * 10 + data[3] % 10;
+    reading->timestamp_ns = now_ns();
+    reading->age_ms = 0;
+    atomic_fetch_add(&stat_ok, 1);
+    return 0;
+}
+
+// 发布新读数（只有采样线程调用）
+static void publish_reading(const struct Dht11Reading *reading)
+{
+    unsigned int seq = atomic_load_explicit(&reading_seq, memory_order_relaxed);
+    atomic_store_explicit(&reading_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&latest_humidity_x10, reading->humidity_x10, memory_order_relaxed);
+    atomic_store_explicit(&latest_temperature_x10, reading->temperature_x10, memory_order_relaxed);
+    atomic_store_explicit(&latest_timestamp_ns, reading->timestamp_ns, memory_order_relaxed);
+    atomic_store_explicit(&reading_seq, seq + 2, memory_order_release);
+}
+
+int dht11_latest(struct Dht11Reading *reading)
+{
+    unsigned int begin, end;
+    do {
+        begin = atomic_load_explicit(&reading_seq, memory_order_acquire);
+        reading->humidity_x10 = atomic_load_explicit(&latest_humidity_x10, memory_order_relaxed);
+        reading->temperature_x10 = atomic_load_explicit(&latest_temperature_x10, memory_order_relaxed);
+        reading->timestamp_ns = atomic_load_explicit(&latest_timestamp_ns, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&reading_seq, memory_order_relaxed);
+    } while ((begin & 1) || begin != end);
+
+    if (reading->timestamp_ns == 0) {
+        return -1;
+    }
+    reading->age_ms = (now_ns() - reading->timestamp_ns) / 1000000;
+    return 0;
+}
+
+void dht11_get_stats(struct Dht11Stats *stats)
+{
+    stats->ok = atomic_load(&stat_ok);
+    stats->timeouts = atomic_load(&stat_timeouts);
+    stats->bad_crc = atomic_load(&stat_bad_crc);
+    stats->invalid = atomic_load(&stat_invalid);
+}
+
+int dht11_sample(dht11_sample_fn on_sample)
+{
+    struct Dht11Reading reading;
+    if (dht11_read(&reading) != 0) {
+        return -1;
+    }
+    publish_reading(&reading);
+    if (on_sample) {
+        on_sample(&reading);
+    }
+    return 0;
+}
+
+// 可被 dht11_sampler_stop() 提前唤醒的睡眠，返回 0 表示应退出
+static int sampler_sleep(unsigned int ms)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&sampler_lock);
+    while (sampler_running &&
+           pthread_cond_timedwait(&sampler_cond, &sampler_lock, &deadline) != ETIMEDOUT) {
+    }
+    int running = sampler_running;
+    pthread_mutex_unlock(&sampler_lock);
+    return running;
+}
+
+// 采样线程：按固定间隔读取，失败时在本周期内有限次重试
+static void *sampler_thread_func(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        for (int attempt = 0; attempt < DHT11_MAX_RETRIES; attempt++) {
+            if (dht11_sample(sampler_callback) == 0) {
+                break;
             }
-            
-            // 校验数据的准确性，如果温度大于50°C，则认为数据无效
-            if (((databuf >> 8) & 0xff) > 50) {
-                attempt--;
-                delay(500); // 延迟后重试
-                continue;
-            } else {
-                // 打印数据
-                printf("恭喜！传感器数据读取成功！\n");
-                printf("湿度: %lu.%lu\n", (databuf >> 24) & 0xff, (databuf >> 16) & 0xff); 
-                printf("温度: %lu.%lu\n", (databuf >> 8) & 0xff, databuf & 0xff);
-                blockFlag = 0;  // 结束线程
-                return (void*)1;
+            if (!sampler_sleep(DHT11_RETRY_INTERVAL_MS)) {
+                return NULL;
             }
-        } else {
-            blockFlag = 0;
-            printf("抱歉！传感器未响应！\n");
-            return (void*)0;
+        }
+        if (!sampler_sleep(DHT11_SAMPLE_INTERVAL_MS)) {
+            return NULL;
         }
     }
+}
 
-    blockFlag = 0;
-    printf("获取数据失败\n");
-    return (void*)2;
+int dht11_sampler_start(dht11_sample_fn on_sample)
+{
+    sampler_callback = on_sample;
+    sampler_running = 1;
+    if (pthread_create(&sampler_tid, NULL, sampler_thread_func, NULL) != 0) {
+        fprintf(stderr, "创建温湿度采样线程失败\n");
+        sampler_running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void dht11_sampler_stop(void)
+{
+    pthread_mutex_lock(&sampler_lock);
+    if (!sampler_running) {
+        pthread_mutex_unlock(&sampler_lock);
+        return;
+    }
+    sampler_running = 0;
+    pthread_cond_signal(&sampler_cond);
+    pthread_mutex_unlock(&sampler_lock);
+    pthread_join(sampler_tid, NULL);
 }
@@ -5,16 +5,35 @@
 #include <wiringPi.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 typedef unsigned char uint8;
 typedef unsigned int  uint16;
 typedef unsigned long uint32;
 
-#define HIGH_TIME 32
+#define DHT11_EDGE_TIMEOUT_US 200      // 等待单个电平跳变的最长时间，超时视为读取失败
+#define DHT11_BIT_THRESHOLD_US 40      // 数据位高电平超过该时长为 1（0 约 26us，1 约 70us）
+#define DHT11_SAMPLE_INTERVAL_MS 5000  // 采样间隔
+#define DHT11_RETRY_INTERVAL_MS 1100   // 读取失败后的重试间隔（DHT11 两次读取至少间隔 1 秒）
+#define DHT11_MAX_RETRIES 3            // 每个采样周期最多重试次数
 
 extern int pinNumber;          // 用于读取数据的GPIO引脚
-extern uint32 databuf;         // 数据存储变量
-extern int blockFlag;          // 控制线程的标志
+
+// 一次有效的传感器读数
+struct Dht11Reading {
+    int humidity_x10;          // 湿度 ×10（%）
+    int temperature_x10;       // 温度 ×10（℃）
+    uint64_t timestamp_ns;     // 读取时间（CLOCK_MONOTONIC）
+    uint64_t age_ms;           // 读取距今的时长，由 dht11_latest() 填写
+};
+
+// 采样统计
+struct Dht11Stats {
+    unsigned long ok;          // 成功次数
+    unsigned long timeouts;    // 电平跳变超时（传感器未响应或时序被打断）
+    unsigned long bad_crc;     // 校验和错误
+    unsigned long invalid;     // 校验通过但数值不合理
+};
 
 // GPIO初始化函数
 void GPIO_init(int gpio_pin);
@@ -22,7 +41,26 @@ void GPIO_init(int gpio_pin);
 // DHT11起始信号发送函数
 void DHT11_Start_Sig(void);
 
-// 读取传感器数据的线程函数
-void* readSensorData(void *arg);
+// 同步读取一次传感器（约 30ms，每个电平都有超时），成功返回 0
+int dht11_read(struct Dht11Reading *reading);
+
+// 每次读取成功后在采样线程中调用（例如写入历史数据），应尽快返回
+typedef void (*dht11_sample_fn)(const struct Dht11Reading *reading);
+
+// 读取一次并发布读数（成功时调用 on_sample），用于自行安排采样时机的调用方（如事件循环）
+// 失败时返回 -1，调用方至少间隔 DHT11_RETRY_INTERVAL_MS 再重试
+int dht11_sample(dht11_sample_fn on_sample);
+
+// 启动后台采样线程，按固定间隔读取并发布最新读数，on_sample 可为 NULL
+int dht11_sampler_start(dht11_sample_fn on_sample);
+
+// 停止采样线程
+void dht11_sampler_stop(void);
+
+// 无锁读取最新读数，尚无有效读数时返回 -1
+int dht11_latest(struct Dht11Reading *reading);
+
+// 读取采样统计
+void dht11_get_stats(struct Dht11Stats *stats);
 
 #endif // DHT11_H
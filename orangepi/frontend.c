@@ -0,0 +1,167 @@
+#include <math.h>
+#include <stdint.h>
+#include "frontend.h"
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FRONTEND_NEON 1
+#endif
+
+// 帧的一阶、二阶统计量，用于计算直流和 RMS
+struct FrameMoments {
+    int64_t sum;
+    int64_t sum_sq;
+    int peak;              // 绝对值最大值（-32768 按 32767 计）
+};
+
+void frontend_config_default(struct FrontendConfig *config) {
+    config->gate_dbfs = FRONTEND_DEFAULT_GATE_DBFS;
+    config->target_dbfs = FRONTEND_DEFAULT_TARGET_DBFS;
+    config->max_gain = FRONTEND_DEFAULT_MAX_GAIN;
+}
+
+static float dbfs_to_linear(float dbfs) {
+    return 32768.0f * powf(10.0f, dbfs / 20.0f);
+}
+
+static float linear_to_dbfs(float value) {
+    return value < 1.0f ? -96.0f : 20.0f * log10f(value / 32768.0f);
+}
+
+void frontend_init(struct Frontend *fe, const struct FrontendConfig *config) {
+    fe->config = *config;
+    fe->dc_estimate = 0.0f;
+    fe->gain = 1.0f;
+    fe->gate_rms = dbfs_to_linear(config->gate_dbfs);
+    fe->target_rms = dbfs_to_linear(config->target_dbfs);
+    fe->frames = 0;
+    fe->gated = 0;
+}
+
+static inline int saturate16(int32_t v) {
+    return v > 32767 ? 32767 : v < -32768 ? -32768 : v;
+}
+
+static void moments_scalar(const short *in, size_t begin, size_t samples, struct FrameMoments *m) {
+    for (size_t i = begin; i < samples; i++) {
+        int v = in[i];
+        int a = v < 0 ? (v == -32768 ? 32767 : -v) : v;
+        m->sum += v;
+        m->sum_sq += (int64_t)(v * v);
+        if (a > m->peak) {
+            m->peak = a;
+        }
+    }
+}
+
+// out = saturate(((saturate(in - dc) * gain_q) + 0.5) >> SHIFT)，与 NEON 的 vqsub + vmull + vqrshrn 一致
+static void apply_scalar(const short *in, short *out, size_t begin, size_t samples, int dc, int gain_q) {
+    for (size_t i = begin; i < samples; i++) {
+        int32_t centered = saturate16((int32_t)in[i] - dc);
+        int32_t scaled = (centered * gain_q + (1 << (FRONTEND_GAIN_SHIFT - 1))) >> FRONTEND_GAIN_SHIFT;
+        out[i] = (short)saturate16(scaled);
+    }
+}
+
+#ifdef FRONTEND_NEON
+// 每次处理 8 个采样，尾部不足 8 个的交给标量实现
+static void moments_neon(const short *in, size_t samples, struct FrameMoments *m) {
+    size_t n = samples & ~(size_t)7;
+    int32x4_t sum = vdupq_n_s32(0);
+    int64x2_t sum_sq = vdupq_n_s64(0);
+    int16x8_t peak = vdupq_n_s16(0);
+
+    for (size_t i = 0; i < n; i += 8) {
+        int16x8_t v = vld1q_s16(in + i);
+        sum = vpadalq_s16(sum, v);
+        // 两个 -32768 的平方之和会超出 int32，高低两半分别累加到 64 位
+        sum_sq = vpadalq_s32(sum_sq, vmull_s16(vget_low_s16(v), vget_low_s16(v)));
+        sum_sq = vpadalq_s32(sum_sq, vmull_s16(vget_high_s16(v), vget_high_s16(v)));
+        peak = vmaxq_s16(peak, vqabsq_s16(v));
+    }
+    m->sum = vaddvq_s32(sum);
+    m->sum_sq = vaddvq_s64(sum_sq);
+    m->peak = vmaxvq_s16(peak);
+    moments_scalar(in, n, samples, m);
+}
+
+static void apply_neon(const short *in, short *out, size_t samples, int dc, int gain_q) {
+    size_t n = samples & ~(size_t)7;
+    int16x8_t dc_v = vdupq_n_s16((int16_t)dc);
+    int16_t gain = (int16_t)gain_q;
+
+    for (size_t i = 0; i < n; i += 8) {
+        int16x8_t v = vqsubq_s16(vld1q_s16(in + i), dc_v);
+        int32x4_t lo = vmull_n_s16(vget_low_s16(v), gain);
+        int32x4_t hi = vmull_n_s16(vget_high_s16(v), gain);
+        vst1q_s16(out + i, vcombine_s16(vqrshrn_n_s32(lo, FRONTEND_GAIN_SHIFT),
+                                        vqrshrn_n_s32(hi, FRONTEND_GAIN_SHIFT)));
+    }
+    apply_scalar(in, out, n, samples, dc, gain_q);
+}
+#endif
+
+// 根据本帧统计量更新直流估计、门限判断和增益，返回定点增益，*dc_out 为本帧扣除的直流
+static int update_levels(struct Frontend *fe, const struct FrameMoments *m, size_t samples,
+                         struct FrontendLevels *levels, int *dc_out) {
+    double mean = (double)m->sum / samples;
+    fe->dc_estimate += FRONTEND_DC_ALPHA * ((float)mean - fe->dc_estimate);
+    int dc = (int)lrintf(fe->dc_estimate);
+    *dc_out = dc;
+
+    // 去直流后的方差：E[x^2] - 2*dc*E[x] + dc^2，不需要再遍历一遍
+    double var = (double)m->sum_sq / samples - 2.0 * dc * mean + (double)dc * dc;
+    float rms = var > 0 ? (float)sqrt(var) : 0.0f;
+    int gated = rms < fe->gate_rms;
+
+    // 只根据非静音帧调整增益，静音时保持不变，避免把底噪放大
+    if (!gated) {
+        float target = fe->target_rms / rms;
+        if (target > fe->config.max_gain) {
+            target = fe->config.max_gain;
+        }
+        // 峰值乘以增益不超过满量程
+        if (m->peak > 0 && target * m->peak > 32767.0f) {
+            target = 32767.0f / m->peak;
+        }
+        float alpha = target < fe->gain ? FRONTEND_GAIN_ATTACK : FRONTEND_GAIN_RELEASE;
+        fe->gain += alpha * (target - fe->gain);
+    }
+    int gain_q = (int)lrintf(fe->gain * (1 << FRONTEND_GAIN_SHIFT));
+    if (gain_q > 32767) {
+        gain_q = 32767;
+    }
+
+    fe->frames++;
+    fe->gated += gated;
+    if (levels) {
+        levels->rms_dbfs = linear_to_dbfs(rms);
+        levels->peak_dbfs = linear_to_dbfs((float)m->peak);
+        levels->gain_db = 20.0f * log10f((float)gain_q / (1 << FRONTEND_GAIN_SHIFT));
+        levels->dc = dc;
+        levels->gated = gated;
+    }
+    return gain_q;
+}
+
+void frontend_process_scalar(struct Frontend *fe, const short *in, short *out, size_t samples,
+                             struct FrontendLevels *levels) {
+    struct FrameMoments m = {0, 0, 0};
+    moments_scalar(in, 0, samples, &m);
+    int dc;
+    int gain_q = update_levels(fe, &m, samples, levels, &dc);
+    apply_scalar(in, out, 0, samples, dc, gain_q);
+}
+
+void frontend_process(struct Frontend *fe, const short *in, short *out, size_t samples,
+                      struct FrontendLevels *levels) {
+#ifdef FRONTEND_NEON
+    struct FrameMoments m = {0, 0, 0};
+    moments_neon(in, samples, &m);
+    int dc;
+    int gain_q = update_levels(fe, &m, samples, levels, &dc);
+    apply_neon(in, out, samples, dc, gain_q);
+#else
+    frontend_process_scalar(fe, in, out, samples, levels);
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+#include <stddef.h>
+
+// 默认前端参数
+#define FRONTEND_DEFAULT_GATE_DBFS   -55.0f  // 去直流后 RMS 低于该电平的帧视为静音，不送 fvad
+#define FRONTEND_DEFAULT_TARGET_DBFS -20.0f  // 自动增益的目标 RMS 电平
+#define FRONTEND_DEFAULT_MAX_GAIN    16.0f   // 最大增益（24dB），避免把底噪放得太大
+#define FRONTEND_DC_ALPHA            0.05f   // 直流估计的平滑系数（每帧）
+#define FRONTEND_GAIN_ATTACK         0.3f    // 需要降低增益时的平滑系数，尽快避免削波
+#define FRONTEND_GAIN_RELEASE        0.02f   // 需要提高增益时的平滑系数，缓慢上升
+#define FRONTEND_GAIN_SHIFT          10      // 增益定点数的小数位（Q10）
+
+// 前端参数
+struct FrontendConfig {
+    float gate_dbfs;
+    float target_dbfs;
+    float max_gain;
+};
+
+// 单帧电平指标（均为输入端，即增益之前的数值）
+struct FrontendLevels {
+    float rms_dbfs;        // 去直流后的 RMS 电平
+    float peak_dbfs;       // 峰值电平
+    float gain_db;         // 本帧使用的增益
+    int dc;                // 本帧扣除的直流分量
+    int gated;             // 1 表示被能量门限判为静音，跳过 fvad
+};
+
+// 前端状态：直流估计和自动增益跨帧平滑
+struct Frontend {
+    struct FrontendConfig config;
+    float dc_estimate;
+    float gain;
+    float gate_rms;        // 门限对应的线性 RMS
+    float target_rms;      // 目标对应的线性 RMS
+    unsigned long frames;  // 处理的帧数
+    unsigned long gated;   // 被门限跳过的帧数
+};
+
+void frontend_config_default(struct FrontendConfig *config);
+
+void frontend_init(struct Frontend *fe, const struct FrontendConfig *config);
+
+// 处理一帧：去直流、自动增益，结果写入 out（可与 in 相同），并填写电平指标
+// 在 aarch64 上使用 NEON，其它平台使用标量实现，两者输出逐位一致
+void frontend_process(struct Frontend *fe, const short *in, short *out, size_t samples,
+                      struct FrontendLevels *levels);
+
+// 标量实现（无 NEON 平台使用，也供基准测试对比）
+void frontend_process_scalar(struct Frontend *fe, const short *in, short *out, size_t samples,
+                             struct FrontendLevels *levels);
+
+#endif // FRONTEND_H
@@ -0,0 +1,71 @@
+#include "histogram.h"
+
+// 值 -> 桶编号：v < 16 时桶编号就是 v；否则取最高位 m，桶编号 = (m - 3) * 16 + 次高 4 位
+static unsigned int bucket_of(uint32_t v) {
+    if (v < HIST_SUB_BUCKETS) {
+        return v;
+    }
+    unsigned int m = 31 - __builtin_clz(v);
+    unsigned int sub = (v >> (m - HIST_SUB_BITS)) & (HIST_SUB_BUCKETS - 1);
+    return ((m - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + sub;
+}
+
+// 桶编号 -> 该桶覆盖的 [low, low + width)
+static void bucket_range(unsigned int index, uint64_t *low, uint64_t *width) {
+    if (index < HIST_SUB_BUCKETS) {
+        *low = index;
+        *width = 1;
+        return;
+    }
+    unsigned int shift = (index >> HIST_SUB_BITS) - 1;
+    *low = (uint64_t)(HIST_SUB_BUCKETS + (index & (HIST_SUB_BUCKETS - 1))) << shift;
+    *width = (uint64_t)1 << shift;
+}
+
+void hist_reset(struct Histogram *h) {
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        atomic_store_explicit(&h->counts[i], 0, memory_order_relaxed);
+    }
+    atomic_store(&h->total, 0);
+    atomic_store(&h->sum_us, 0);
+    atomic_store(&h->max_us, 0);
+}
+
+void hist_record(struct Histogram *h, uint64_t value_us) {
+    uint32_t v = value_us > UINT32_MAX ? UINT32_MAX : (uint32_t)value_us;
+    atomic_fetch_add_explicit(&h->counts[bucket_of(v)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->total, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum_us, v, memory_order_relaxed);
+
+    unsigned int max = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+    while (v > max && !atomic_compare_exchange_weak_explicit(&h->max_us, &max, v,
+                                                              memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+uint64_t hist_percentile(const struct Histogram *h, double q) {
+    unsigned long total = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        total += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    // 第 rank 个值（从 1 开始）所在的桶
+    unsigned long rank = (unsigned long)(q * total + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+    unsigned long seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t low, width;
+            bucket_range(i, &low, &width);
+            uint64_t mid = low + width / 2;
+            uint64_t max = atomic_load_explicit(&h->max_us, memory_order_relaxed);
+            return mid < max ? mid : max;  // 最高的桶不会超过实际最大值
+        }
+    }
+    return atomic_load_explicit(&h->max_us, memory_order_relaxed);
+}
@@ -0,0 +1,31 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+// 对数-线性分桶的延迟直方图（与 HdrHistogram 思路相同）：
+// 小于 16us 每 1us 一个桶，之后每个 2 的幂区间再等分为 16 个桶，相对误差不超过 1/16
+// 记录只做几次原子加，可在任意线程中调用，不加锁、不分配内存
+#define HIST_SUB_BITS 4
+#define HIST_SUB_BUCKETS (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((32 - HIST_SUB_BITS + 1) << HIST_SUB_BITS)  // 覆盖 0 ~ 2^32 us（约 71 分钟）
+
+struct Histogram {
+    atomic_uint counts[HIST_BUCKETS];
+    atomic_ulong total;        // 记录次数
+    _Atomic uint64_t sum_us;   // 累计值，用于求平均
+    atomic_uint max_us;
+};
+
+// 清零（也可以直接使用静态零初始化的直方图）
+void hist_reset(struct Histogram *h);
+
+// 记录一个值（微秒），超出范围的值计入最后一个桶
+void hist_record(struct Histogram *h, uint64_t value_us);
+
+// 估算分位数（q 取 0~1），返回所在桶的中点（微秒）；没有记录时返回 0
+// 与记录并发调用时结果是近似值
+uint64_t hist_percentile(const struct Histogram *h, double q);
+
+#endif // HISTOGRAM_H
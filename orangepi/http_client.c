@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "http_client.h"
+#include "adpcm.h"
+#include "trace.h"
+#include "server_health.h"
+
+#if STT_ADPCM
+#define STT_STREAM_CONTENT_TYPE "Content-Type: " ADPCM_CONTENT_TYPE
+#else
+#define STT_STREAM_CONTENT_TYPE "Content-Type: application/octet-stream"
+#endif
+
+// 每个接口的固定配置
+struct endpoint_config {
+    const char *path;
+    const char *headers[7];  // 以 NULL 结尾
+    long timeout_s;          // 整个请求的期限（连接期限统一为 HTTP_CONNECT_TIMEOUT_MS）
+};
+
+static const struct endpoint_config endpoint_configs[HTTP_ENDPOINT_COUNT] = {
+    // multipart 上传时禁用 "Expect: 100-continue"，省去一次等待服务端确认的往返
+    [HTTP_ENDPOINT_STT]  = { "/stt/",  { "Expect:", "Connection: keep-alive", NULL }, 10 },
+    // PCM（或 ADPCM）以 chunked 方式边录边传，超时从请求开始计算，需覆盖整段说话时长
+    [HTTP_ENDPOINT_STT_STREAM] = { "/stt/stream/", { "Expect:", "Connection: keep-alive", "Transfer-Encoding: chunked",
+                                   STT_STREAM_CONTENT_TYPE, "X-Sample-Rate: 16000", NULL }, 40 },
+    // 整段回答生成完才返回，超时需覆盖最长回答的生成时间
+    [HTTP_ENDPOINT_CHAT] = { "/chat/", { "Content-Type: application/json", "Connection: keep-alive", NULL }, 30 },
+    [HTTP_ENDPOINT_CHAT_STREAM] = { "/chat/stream/", { "Content-Type: application/json", "Accept: application/x-ndjson",
+                                    "Connection: keep-alive", NULL }, 60 },
+    // 超时需覆盖说话时长、识别和整段回答的生成
+    [HTTP_ENDPOINT_CONVERSE] = { "/converse/", { "Expect:", "Connection: keep-alive", "Transfer-Encoding: chunked",
+                                 STT_STREAM_CONTENT_TYPE, "X-Sample-Rate: 16000", "Accept: application/x-ndjson",
+                                 NULL }, 60 },
+    [HTTP_ENDPOINT_HEALTH] = { "/health/", { "Connection: keep-alive", NULL }, 2 },
+};
+
+static CURLSH *share_handle = NULL;
+static pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+static CURL *handles[HTTP_ENDPOINT_COUNT];
+static struct curl_slist *header_lists[HTTP_ENDPOINT_COUNT];
+
+// 共享缓存可能被多个线程同时访问，按数据类型加锁
+static void share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userp) {
+    (void)handle; (void)access; (void)userp;
+    pthread_mutex_lock(&share_locks[data]);
+}
+
+static void share_unlock(CURL *handle, curl_lock_data data, void *userp) {
+    (void)handle; (void)userp;
+    pthread_mutex_unlock(&share_locks[data]);
+}
+
+int http_client_init(void) {
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != 0) {
+        fprintf(stderr, "cURL 全局初始化失败\n");
+        return -1;
+    }
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&share_locks[i], NULL);
+    }
+
+    // 只共享 DNS 结果和 TLS 会话：libcurl 不支持多个线程同时使用共享的连接缓存，
+    // 各句柄（及复制出的句柄）各自保留连接，同一句柄的前后请求复用连接
+    share_handle = curl_share_init();
+    if (!share_handle) {
+        fprintf(stderr, "无法创建 cURL 共享句柄\n");
+        http_client_cleanup();
+        return -1;
+    }
+    curl_share_setopt(share_handle, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(share_handle, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    curl_share_setopt(share_handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+    // 开发机上可以指向本地的 server/stub_server.py
+    const char *base_url = getenv("QYAI_SERVER");
+    if (!base_url || !base_url[0]) {
+        base_url = SERVER_BASE_URL;
+    }
+    printf("服务器地址：%s\n", base_url);
+
+    for (int i = 0; i < HTTP_ENDPOINT_COUNT; i++) {
+        const struct endpoint_config *cfg = &endpoint_configs[i];
+        char url[256];
+        snprintf(url, sizeof(url), "%s%s", base_url, cfg->path);
+
+        handles[i] = curl_easy_init();
+        if (!handles[i]) {
+            fprintf(stderr, "无法初始化 CURL（%s）\n", cfg->path);
+            http_client_cleanup();
+            return -1;
+        }
+
+        // 预先构建请求头，之后每次请求直接复用
+        for (int h = 0; cfg->headers[h]; h++) {
+            header_lists[i] = curl_slist_append(header_lists[i], cfg->headers[h]);
+        }
+
+        CURL *curl = handles[i];
+        curl_easy_setopt(curl, CURLOPT_URL, url);  // cURL 会复制 URL 字符串
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_lists[i]);
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_1_1);
+        curl_easy_setopt(curl, CURLOPT_SHARE, share_handle);
+        curl_easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, 600L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 15L);
+        curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);  // 多线程下不使用信号实现超时
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, (void *)&endpoint_configs[i]);  // 复制的句柄也能找到所属接口
+        // 连接、卡住和整个请求分别设期限：服务器不可达时在连接阶段就失败，流式回答中途卡住也不会等满整个期限
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, (long)HTTP_CONNECT_TIMEOUT_MS);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, (long)HTTP_STALL_TIMEOUT_S);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, cfg->timeout_s);
+    }
+
+    return 0;
+}
+
+void http_client_cleanup(void) {
+    for (int i = 0; i < HTTP_ENDPOINT_COUNT; i++) {
+        if (handles[i]) {
+            curl_easy_cleanup(handles[i]);
+            handles[i] = NULL;
+        }
+        curl_slist_free_all(header_lists[i]);
+        header_lists[i] = NULL;
+    }
+    if (share_handle) {
+        curl_share_cleanup(share_handle);
+        share_handle = NULL;
+        for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+            pthread_mutex_destroy(&share_locks[i]);
+        }
+    }
+    curl_global_cleanup();
+}
+
+CURL *http_client_handle(enum HttpEndpoint endpoint) {
+    return handles[endpoint];
+}
+
+CURL *http_client_dup_handle(enum HttpEndpoint endpoint) {
+    if (!handles[endpoint]) {
+        return NULL;
+    }
+    return curl_easy_duphandle(handles[endpoint]);
+}
+
+CURLcode http_client_perform(enum HttpEndpoint endpoint, const char *trace_id, struct HttpTiming *timing) {
+    return http_client_perform_handle(handles[endpoint], trace_id, timing);
+}
+
+// 句柄所属接口的预设请求头，句柄不是来自本模块时返回 NULL
+static const struct endpoint_config *handle_config(CURL *curl) {
+    const struct endpoint_config *cfg = NULL;
+    curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **)&cfg);
+    return cfg;
+}
+
+void http_client_set_trace(CURL *curl, struct HttpTraceHeader *header, const char *trace_id) {
+    const struct endpoint_config *cfg = trace_id ? handle_config(curl) : NULL;
+    if (!cfg) {
+        return;
+    }
+    snprintf(header->line, sizeof(header->line), TRACE_HEADER ": %s", trace_id);
+    header->node.data = header->line;
+    header->node.next = header_lists[cfg - endpoint_configs];
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, &header->node);
+}
+
+void http_client_clear_trace(CURL *curl) {
+    const struct endpoint_config *cfg = handle_config(curl);
+    if (cfg) {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_lists[cfg - endpoint_configs]);
+    }
+}
+
+void http_client_get_timing(CURL *curl, struct HttpTiming *timing) {
+    curl_off_t dns = 0, connect = 0, pretransfer = 0, total = 0;
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    // cURL 返回的时间均为从请求开始累计的微秒数
+    timing->dns_ms = dns / 1000.0;
+    timing->connect_ms = (connect - dns) / 1000.0;
+    timing->transfer_ms = (total - pretransfer) / 1000.0;
+    timing->total_ms = total / 1000.0;
+    timing->new_connections = connects;
+}
+
+CURLcode http_client_perform_handle(CURL *curl, const char *trace_id, struct HttpTiming *timing) {
+    if (!curl) {
+        return CURLE_FAILED_INIT;
+    }
+
+    // 追踪 ID 放在栈上的链表节点中，接在接口预设的请求头之前，请求结束后恢复
+    struct HttpTraceHeader trace_header;
+    http_client_set_trace(curl, &trace_header, trace_id);
+
+    CURLcode res = curl_easy_perform(curl);
+    server_health_report(curl, res);
+
+    if (trace_id) {
+        http_client_clear_trace(curl);
+    }
+    if (timing) {
+        http_client_get_timing(curl, timing);
+    }
+    return res;
+}
@@ -0,0 +1,66 @@
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <curl/curl.h>
+
+#define SERVER_BASE_URL "http://192.168.2.118:8000"  // 根据实际修改服务器地址，也可用 QYAI_SERVER 环境变量覆盖
+#define HTTP_CONNECT_TIMEOUT_MS 1500  // 建立连接的期限，服务器重启或断网时不等到整个请求超时
+#define HTTP_STALL_TIMEOUT_S 15       // 连接建立后持续该时长收发不到数据视为卡住
+
+// 客户端访问的服务端接口，每个接口持有一个长期复用的 easy handle
+enum HttpEndpoint {
+    HTTP_ENDPOINT_STT = 0,   // 语音识别 /stt/
+    HTTP_ENDPOINT_STT_STREAM,// 流式语音识别 /stt/stream/
+    HTTP_ENDPOINT_CHAT,      // 对话 /chat/
+    HTTP_ENDPOINT_CHAT_STREAM, // 流式对话 /chat/stream/
+    HTTP_ENDPOINT_CONVERSE,  // 语音对话 /converse/（上传同 /stt/stream/，响应同 /chat/stream/ 并带识别结果）
+    HTTP_ENDPOINT_HEALTH,    // 健康检查 /health/（断路后探测服务器是否恢复）
+    HTTP_ENDPOINT_COUNT
+};
+
+// 单次请求的耗时拆分（毫秒）
+struct HttpTiming {
+    double dns_ms;        // DNS 解析耗时
+    double connect_ms;    // 建立 TCP 连接耗时（复用连接时接近 0）
+    double transfer_ms;   // 从连接就绪到响应接收完毕的耗时
+    double total_ms;      // 请求总耗时
+    long new_connections; // 本次请求新建的连接数，0 表示复用了已有连接
+};
+
+// 异步请求（curl_multi）使用的追踪请求头，需在请求结束前保持有效
+struct HttpTraceHeader {
+    struct curl_slist node;
+    char line[64];
+};
+
+// 全局初始化（程序启动时调用一次）：cURL 全局状态、共享的 DNS/TLS 会话缓存、各接口的句柄
+// 设置了 QYAI_SERVER 环境变量（如 http://127.0.0.1:8765）时使用该地址代替 SERVER_BASE_URL
+int http_client_init(void);
+
+// 释放全部资源（程序退出时调用）
+void http_client_cleanup(void);
+
+// 获取接口对应的句柄，已预设 URL、keep-alive、请求头等通用选项
+// 调用方只需设置本次请求的请求体和回调；同一接口的句柄同一时刻只能在一个线程中使用
+CURL *http_client_handle(enum HttpEndpoint endpoint);
+
+// 复制接口句柄的全部预设选项，得到一个调用方独占的句柄（用完后 curl_easy_cleanup）
+// 复制出的句柄与原句柄共享 DNS 缓存，连接由各句柄自己保留，可在其它线程中并发使用
+CURL *http_client_dup_handle(enum HttpEndpoint endpoint);
+
+// 执行请求并记录耗时，timing 可为 NULL；结果计入服务器健康状态（见 server_health.h）
+// trace_id 不为 NULL 时本次请求额外带上 X-Trace-Id 请求头（不修改句柄预设的请求头，也不分配内存）
+CURLcode http_client_perform(enum HttpEndpoint endpoint, const char *trace_id, struct HttpTiming *timing);
+
+// 同上，用于 http_client_dup_handle 得到的句柄
+CURLcode http_client_perform_handle(CURL *curl, const char *trace_id, struct HttpTiming *timing);
+
+// 给句柄加上 X-Trace-Id 请求头（接在接口预设的请求头之前，不申请内存），trace_id 为 NULL 时不做任何事
+// 用于交给事件循环的句柄，请求结束后用 http_client_clear_trace 恢复预设请求头
+void http_client_set_trace(CURL *curl, struct HttpTraceHeader *header, const char *trace_id);
+void http_client_clear_trace(CURL *curl);
+
+// 读取句柄最近一次请求的耗时拆分
+void http_client_get_timing(CURL *curl, struct HttpTiming *timing);
+
+#endif // HTTP_CLIENT_H
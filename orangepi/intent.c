@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "intent.h"
+#include "intent_table.h"
+#include "text_normalize.h"
+
+#define PHRASE_COUNT (sizeof(intent_phrases) / sizeof(intent_phrases[0]))
+#define REPLY_COUNT (sizeof(intent_replies) / sizeof(intent_replies[0]))
+
+// Aho-Corasick 自动机节点，子节点以“首子节点 + 兄弟节点”链表存放，按 UTF-8 字节匹配
+struct AcNode {
+    int first_child;
+    int next_sibling;
+    int fail;          // 失配指针
+    int dict_link;     // 沿失配链最近的、有短语结束的节点
+    int phrase;        // 在此结束的短语下标，-1 表示无
+    unsigned char byte;
+};
+
+static struct AcNode *nodes = NULL;
+static int node_count = 0;
+
+static int child_of(int node, unsigned char byte) {
+    for (int c = nodes[node].first_child; c >= 0; c = nodes[c].next_sibling) {
+        if (nodes[c].byte == byte) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+static int new_node(unsigned char byte) {
+    struct AcNode *n = &nodes[node_count];
+    n->first_child = -1;
+    n->next_sibling = -1;
+    n->fail = 0;
+    n->dict_link = -1;
+    n->phrase = -1;
+    n->byte = byte;
+    return node_count++;
+}
+
+int intent_init(void) {
+    // 节点数不超过全部短语字节数之和 + 根节点，一次性分配
+    size_t capacity = 1;
+    for (size_t i = 0; i < PHRASE_COUNT; i++) {
+        capacity += strlen(intent_phrases[i].phrase);
+    }
+    nodes = malloc(capacity * sizeof(struct AcNode));
+    int *queue = malloc(capacity * sizeof(int));
+    if (!nodes || !queue) {
+        fprintf(stderr, "意图匹配器内存分配失败\n");
+        free(queue);
+        intent_free();
+        return -1;
+    }
+    node_count = 0;
+    new_node(0);
+
+    // 1. 构建字典树
+    for (size_t i = 0; i < PHRASE_COUNT; i++) {
+        int cur = 0;
+        for (const unsigned char *p = (const unsigned char *)intent_phrases[i].phrase; *p; p++) {
+            int next = child_of(cur, *p);
+            if (next < 0) {
+                next = new_node(*p);
+                nodes[next].next_sibling = nodes[cur].first_child;
+                nodes[cur].first_child = next;
+            }
+            cur = next;
+        }
+        nodes[cur].phrase = (int)i;
+    }
+
+    // 2. 广度优先计算失配指针和输出链
+    int head = 0, tail = 0;
+    for (int c = nodes[0].first_child; c >= 0; c = nodes[c].next_sibling) {
+        nodes[c].fail = 0;
+        queue[tail++] = c;
+    }
+    while (head < tail) {
+        int cur = queue[head++];
+        for (int c = nodes[cur].first_child; c >= 0; c = nodes[c].next_sibling) {
+            int f = nodes[cur].fail;
+            int target;
+            while ((target = child_of(f, nodes[c].byte)) < 0 && f != 0) {
+                f = nodes[f].fail;
+            }
+            nodes[c].fail = (target >= 0 && target != c) ? target : 0;
+            int fail = nodes[c].fail;
+            nodes[c].dict_link = nodes[fail].phrase >= 0 ? fail : nodes[fail].dict_link;
+            queue[tail++] = c;
+        }
+    }
+
+    free(queue);
+    printf("本地意图匹配器已就绪：%zu 条短语，%d 个节点\n", PHRASE_COUNT, node_count);
+    return 0;
+}
+
+void intent_free(void) {
+    free(nodes);
+    nodes = NULL;
+    node_count = 0;
+}
+
+static const char *reply_for(const char *cmd) {
+    for (size_t i = 0; i < REPLY_COUNT; i++) {
+        if (strcmp(intent_replies[i].cmd, cmd) == 0) {
+            return intent_replies[i].reply;
+        }
+    }
+    return "好的。";
+}
+
+int intent_match(const char *text, struct AIResponse *response) {
+    if (!nodes) {
+        return -1;
+    }
+
+    // 去掉标点和空白、折叠全角字符后再匹配
+    char normalized[1024];
+    size_t content_len = normalize_text(text, normalized, sizeof(normalized));
+
+    // 在文本中找出最长的命中短语
+    int state = 0;
+    int best = -1;
+    size_t best_len = 0;
+    for (const unsigned char *p = (const unsigned char *)normalized; *p; p++) {
+        int next;
+        while ((next = child_of(state, *p)) < 0 && state != 0) {
+            state = nodes[state].fail;
+        }
+        state = next >= 0 ? next : 0;
+
+        for (int n = nodes[state].phrase >= 0 ? state : nodes[state].dict_link; n >= 0; n = nodes[n].dict_link) {
+            size_t len = strlen(intent_phrases[nodes[n].phrase].phrase);
+            if (len > best_len) {
+                best_len = len;
+                best = nodes[n].phrase;
+            }
+        }
+    }
+
+    // 命中短语只是长句的一小部分时（如“开灯的时候要注意什么”）交给大模型
+    if (best < 0 || best_len < content_len * INTENT_MIN_COVERAGE) {
+        return -1;
+    }
+
+    const char *cmd = intent_phrases[best].cmd;
+    snprintf(response->cmd, sizeof(response->cmd), "%s", cmd);
+    snprintf(response->msg, sizeof(response->msg), "%s", reply_for(cmd));
+    return 0;
+}
+
+int intent_command(const char *cmd, struct AIResponse *response) {
+    for (size_t i = 0; i < REPLY_COUNT; i++) {
+        if (strcmp(intent_replies[i].cmd, cmd) == 0) {
+            snprintf(response->cmd, sizeof(response->cmd), "%s", cmd);
+            snprintf(response->msg, sizeof(response->msg), "%s", intent_replies[i].reply);
+            return 0;
+        }
+    }
+    return -1;
+}
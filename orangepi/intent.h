@@ -0,0 +1,32 @@
+#ifndef INTENT_H
+#define INTENT_H
+
+#include "chat.h"
+
+// 命中的短语至少要覆盖识别文本（规范化后）的比例，低于该比例交给大模型
+#define INTENT_MIN_COVERAGE 0.7
+
+// 短语表条目，见 intent_table.h（由 server/gen_intent_table.py 生成）
+struct IntentPhrase {
+    const char *phrase;
+    const char *cmd;
+};
+
+struct IntentReply {
+    const char *cmd;
+    const char *reply;
+};
+
+// 根据短语表构建 Aho-Corasick 自动机（程序启动时调用一次）
+int intent_init(void);
+
+// 释放自动机
+void intent_free(void);
+
+// 在识别文本中匹配本地命令，命中时填写 response 的命令和固定回答并返回 0，未命中返回 -1
+int intent_match(const char *text, struct AIResponse *response);
+
+// 按命令名填写 response 的命令和固定回答（如本地关键词识别的结果），不是已知命令时返回 -1
+int intent_command(const char *cmd, struct AIResponse *response);
+
+#endif // INTENT_H
@@ -0,0 +1,119 @@
+// 由 server/gen_intent_table.py 根据 data.json 自动生成，请勿手动修改
+#ifndef INTENT_TABLE_H
+#define INTENT_TABLE_H
+
+// 本地意图短语：问句 -> 命令
+static const struct IntentPhrase intent_phrases[] = {
+    { "不需要风扇了", "fan_off" },
+    { "关一下灯", "light_off" },
+    { "关掉空调", "ac_off" },
+    { "关灯", "light_off" },
+    { "关空调", "ac_off" },
+    { "关窗户", "window_close" },
+    { "关闭制冷", "ac_off" },
+    { "关闭空调", "ac_off" },
+    { "关闭窗户", "window_close" },
+    { "关闭风扇", "fan_off" },
+    { "关风扇", "fan_off" },
+    { "启动制冷", "ac_on" },
+    { "启动空调", "ac_on" },
+    { "好热啊", "fan_on" },
+    { "室内温度多少", "get_temperature" },
+    { "室内湿度多少", "get_humidity" },
+    { "室内湿度是多少", "get_humidity" },
+    { "屋子太暗了", "light_on" },
+    { "帮我打开风扇", "fan_on" },
+    { "帮我把灯打开", "light_on" },
+    { "开一下空调", "ac_on" },
+    { "开启空调", "ac_on" },
+    { "开灯", "light_on" },
+    { "开灯一下", "light_on" },
+    { "开点灯吧", "light_on" },
+    { "开空调", "ac_on" },
+    { "开窗户", "window_open" },
+    { "开窗户一下", "window_open" },
+    { "开风扇", "fan_on" },
+    { "当前温度是多少", "get_temperature" },
+    { "当前湿度多少", "get_humidity" },
+    { "当前状态如何", "status" },
+    { "我感觉很热", "fan_on" },
+    { "我有点热", "fan_on" },
+    { "我要睡觉了", "light_off" },
+    { "房间有点闷", "fan_on" },
+    { "所有设备的状态", "status" },
+    { "打开灯", "light_on" },
+    { "打开窗户", "window_open" },
+    { "打开风扇", "fan_on" },
+    { "把灯关掉", "light_off" },
+    { "把灯打开好吗", "light_on" },
+    { "把空调关了", "ac_off" },
+    { "把空调开了", "ac_on" },
+    { "把窗户关上", "window_close" },
+    { "把风扇关掉", "fan_off" },
+    { "查看状态", "status" },
+    { "温度多少", "get_temperature" },
+    { "湿度多少", "get_humidity" },
+    { "湿度是多少", "get_humidity" },
+    { "灯光太强了", "light_off" },
+    { "灯太亮了", "light_off" },
+    { "现在不热了", "fan_off" },
+    { "现在太热了", "fan_on" },
+    { "现在温度多少", "get_temperature" },
+    { "现在温度是多少", "get_temperature" },
+    { "现在湿度多少", "get_humidity" },
+    { "空调关了", "ac_off" },
+    { "空调关了可以开风扇吗", "fan_on" },
+    { "空调关闭", "ac_off" },
+    { "空调打开", "ac_on" },
+    { "窗户关了", "window_close" },
+    { "窗户关闭", "window_close" },
+    { "窗户能不能开", "window_open" },
+    { "窗户能开吗", "window_open" },
+    { "给我开点风", "fan_on" },
+    { "能告诉我现在温度吗", "get_temperature" },
+    { "能开下窗户吗", "window_open" },
+    { "能开个灯吗", "light_on" },
+    { "能开点灯吗", "light_on" },
+    { "能开风扇吗", "fan_on" },
+    { "设备状态如何", "status" },
+    { "设备运行状态", "status" },
+    { "设置风扇高速", "fan_high" },
+    { "请关一下窗户", "window_close" },
+    { "请关掉风扇", "fan_off" },
+    { "请关窗户", "window_close" },
+    { "请关闭灯光", "light_off" },
+    { "请关闭空调", "ac_off" },
+    { "请告诉我室内温度", "get_temperature" },
+    { "请开一下风扇", "fan_on" },
+    { "请开启空调", "ac_on" },
+    { "请打开窗户", "window_open" },
+    { "请把灯关了", "light_off" },
+    { "请把灯打开", "light_on" },
+    { "请问现在湿度如何", "get_humidity" },
+    { "调低风速", "fan_speed_down" },
+    { "调高风速", "fan_speed_up" },
+    { "风扇关一下", "fan_off" },
+    { "风扇声音有点吵", "fan_off" },
+    { "风扇太冷了", "fan_off" },
+    { "风扇能开一下吗", "fan_on" },
+};
+
+// 命中本地意图时使用的固定回答
+static const struct IntentReply intent_replies[] = {
+    { "ac_off", "空调已关闭。" },
+    { "ac_on", "空调已开启，制冷模式启动。" },
+    { "fan_high", "已将风扇设为高速模式。" },
+    { "fan_off", "好的，风扇已关闭。" },
+    { "fan_on", "风扇正在启动。" },
+    { "fan_speed_down", "已将风扇速度调低一级。" },
+    { "fan_speed_up", "已将风扇速度调高一级。" },
+    { "get_humidity", "当前室内湿度为45%。" },
+    { "get_temperature", "当前室内温度是25摄氏度。" },
+    { "light_off", "好的，灯已关闭。" },
+    { "light_on", "灯已点亮。" },
+    { "status", "所有设备运行正常，没有异常。" },
+    { "window_close", "窗户已关闭。" },
+    { "window_open", "窗户已打开。" },
+};
+
+#endif // INTENT_TABLE_H
@@ -0,0 +1,294 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include "kws.h"
+#include "capture_source.h"
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define KWS_NEON 1
+#endif
+
+#define KWS_LOAD_PERIOD 160  // 读取模板文件时每次读取的采样数
+#define KWS_MAX_SAMPLES ((KWS_MAX_FRAMES - 1) * MFCC_HOP + MFCC_WINDOW)
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int kws_init(struct Kws *kws) {
+    memset(kws, 0, sizeof(*kws));
+    mfcc_init(&kws->mfcc);
+    kws->threshold = KWS_DEFAULT_THRESHOLD;
+    kws->margin = KWS_DEFAULT_MARGIN;
+    kws->features = malloc(KWS_MAX_FRAMES * MFCC_STRIDE * sizeof(float));
+    kws->rows = malloc(2 * (KWS_MAX_FRAMES + 1) * sizeof(float));
+    if (!kws->features || !kws->rows) {
+        fprintf(stderr, "关键词识别内存分配失败\n");
+        kws_free(kws);
+        return -1;
+    }
+    return 0;
+}
+
+void kws_free(struct Kws *kws) {
+    for (int i = 0; i < kws->count; i++) {
+        free(kws->templates[i].features);
+    }
+    kws->count = 0;
+    free(kws->features);
+    free(kws->rows);
+    kws->features = NULL;
+    kws->rows = NULL;
+}
+
+/*
+ * 提取特征并规整：去掉首尾低能量帧，倒谱系数减去整段均值（抵消麦克风和房间的频响差异），
+ * 再把 c0 和能量清零，使距离只反映频谱形状而与音量无关。返回保留的帧数，首帧位置写入 begin
+ */
+static size_t extract(struct Kws *kws, const short *pcm, size_t samples, size_t *begin) {
+    float *feat = kws->features;
+    size_t frames = mfcc_compute(&kws->mfcc, pcm, samples, feat, KWS_MAX_FRAMES);
+    if (frames == 0) {
+        return 0;
+    }
+
+    float peak = feat[MFCC_ENERGY];
+    for (size_t f = 1; f < frames; f++) {
+        if (feat[f * MFCC_STRIDE + MFCC_ENERGY] > peak) {
+            peak = feat[f * MFCC_STRIDE + MFCC_ENERGY];
+        }
+    }
+    float floor = peak - KWS_TRIM_DB * logf(10.0f) / 10.0f;
+    size_t first = 0, last = frames - 1;
+    while (first < last && feat[first * MFCC_STRIDE + MFCC_ENERGY] < floor) {
+        first++;
+    }
+    while (last > first && feat[last * MFCC_STRIDE + MFCC_ENERGY] < floor) {
+        last--;
+    }
+
+    size_t n = last - first + 1;
+    float *kept = feat + first * MFCC_STRIDE;
+    float mean[MFCC_STRIDE] = {0};
+    for (size_t f = 0; f < n; f++) {
+        for (int k = 1; k < MFCC_COEFFS; k++) {
+            mean[k] += kept[f * MFCC_STRIDE + k];
+        }
+    }
+    for (size_t f = 0; f < n; f++) {
+        float *v = kept + f * MFCC_STRIDE;
+        for (int k = 1; k < MFCC_COEFFS; k++) {
+            v[k] -= mean[k] / n;
+        }
+        v[0] = 0;
+        v[MFCC_ENERGY] = 0;
+    }
+    *begin = first;
+    return n;
+}
+
+// 两帧特征的欧氏距离（补零的位置不影响结果）
+static inline float frame_distance(const float *a, const float *b) {
+#ifdef KWS_NEON
+    float32x4_t sum = vdupq_n_f32(0);
+    for (int k = 0; k < MFCC_STRIDE; k += 4) {
+        float32x4_t d = vsubq_f32(vld1q_f32(a + k), vld1q_f32(b + k));
+        sum = vfmaq_f32(sum, d, d);
+    }
+    return sqrtf(vaddvq_f32(sum));
+#else
+    float sum = 0;
+    for (int k = 0; k < MFCC_STRIDE; k++) {
+        float d = a[k] - b[k];
+        sum += d * d;
+    }
+    return sqrtf(sum);
+#endif
+}
+
+/*
+ * 对称 DTW（斜向步长权重为 2，按 n+m 归一化为平均帧距离），路径限制在对角线附近的带内。
+ * 某一行的最小累计代价已超过 limit 时提前放弃，返回 INFINITY
+ */
+static float dtw(float *rows, const float *a, size_t n, const float *b, size_t m, float limit) {
+    size_t longer = n > m ? n : m;
+    size_t band = longer * KWS_BAND_PERCENT / 100;
+    if (band < 2) {
+        band = 2;
+    }
+    float *prev = rows, *cur = rows + m + 1;
+    float scale = (float)(n + m);
+
+    prev[0] = 0;
+    for (size_t j = 1; j <= m; j++) {
+        prev[j] = INFINITY;
+    }
+    for (size_t i = 1; i <= n; i++) {
+        size_t center = i * m / n;
+        size_t lo = center > band + 1 ? center - band : 1;
+        size_t hi = center + band < m ? center + band : m;
+        float row_min = INFINITY;
+        for (size_t j = 0; j <= m; j++) {
+            cur[j] = INFINITY;
+        }
+        for (size_t j = lo; j <= hi; j++) {
+            float d = frame_distance(a + (i - 1) * MFCC_STRIDE, b + (j - 1) * MFCC_STRIDE);
+            float best = prev[j - 1] + 2 * d;
+            if (prev[j] + d < best) {
+                best = prev[j] + d;
+            }
+            if (cur[j - 1] + d < best) {
+                best = cur[j - 1] + d;
+            }
+            cur[j] = best;
+            if (best < row_min) {
+                row_min = best;
+            }
+        }
+        if (row_min / scale > limit) {
+            return INFINITY;
+        }
+        float *tmp = prev;
+        prev = cur;
+        cur = tmp;
+    }
+    return prev[m] / scale;
+}
+
+int kws_enroll(struct Kws *kws, const char *cmd, const short *pcm, size_t samples) {
+    if (kws->count == KWS_MAX_TEMPLATES) {
+        fprintf(stderr, "关键词模板已满（%d）\n", KWS_MAX_TEMPLATES);
+        return -1;
+    }
+    if (samples > KWS_MAX_SAMPLES) {
+        fprintf(stderr, "模板 %s 太长（%.1f 秒）\n", cmd, (double)samples / MFCC_RATE);
+        return -1;
+    }
+    size_t begin;
+    size_t n = extract(kws, pcm, samples, &begin);
+    if (n < KWS_MIN_FRAMES) {
+        fprintf(stderr, "模板 %s 太短或没有声音\n", cmd);
+        return -1;
+    }
+
+    struct KwsTemplate *t = &kws->templates[kws->count];
+    t->features = malloc(n * MFCC_STRIDE * sizeof(float));
+    if (!t->features) {
+        fprintf(stderr, "关键词模板内存分配失败\n");
+        return -1;
+    }
+    memcpy(t->features, kws->features + begin * MFCC_STRIDE, n * MFCC_STRIDE * sizeof(float));
+    t->frames = n;
+    snprintf(t->cmd, sizeof(t->cmd), "%s", cmd);
+    kws->count++;
+    return 0;
+}
+
+short *kws_load_wav(const char *path, size_t *samples) {
+    struct CaptureSource src;
+    struct CaptureWavOptions options = { .realtime = 0, .loop = 0, .pad_ms = 0 };
+    if (capture_source_open_wav(&src, path, MFCC_RATE, KWS_LOAD_PERIOD, &options) != 0) {
+        return NULL;
+    }
+    short *pcm = malloc((KWS_MAX_SAMPLES + KWS_LOAD_PERIOD) * sizeof(short));
+    size_t n = 0;
+    while (pcm && n < KWS_MAX_SAMPLES + 1 && src.read(&src, pcm + n) == 1) {
+        n += KWS_LOAD_PERIOD;
+    }
+    src.close(&src);
+    *samples = n;
+    return pcm;
+}
+
+int kws_load_dir(struct Kws *kws, const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        return -1;
+    }
+    int loaded = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d))) {
+        // 文件名去掉 .wav 和结尾的 _<序号> 即为命令名
+        char cmd[64];
+        size_t len = strlen(entry->d_name);
+        if (len <= 4 || len - 4 >= sizeof(cmd) || strcasecmp(entry->d_name + len - 4, ".wav") != 0) {
+            continue;
+        }
+        memcpy(cmd, entry->d_name, len - 4);
+        cmd[len - 4] = '\0';
+        char *suffix = strrchr(cmd, '_');
+        if (suffix && suffix[1]) {
+            char *p = suffix + 1;
+            while (isdigit((unsigned char)*p)) {
+                p++;
+            }
+            if (*p == '\0') {
+                *suffix = '\0';
+            }
+        }
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        size_t samples;
+        short *pcm = kws_load_wav(path, &samples);
+        if (pcm && kws_enroll(kws, cmd, pcm, samples) == 0) {
+            loaded++;
+        }
+        free(pcm);
+    }
+    closedir(d);
+    return loaded;
+}
+
+int kws_spot(struct Kws *kws, const short *pcm, size_t samples, struct KwsResult *result) {
+    double start = now_ms();
+    memset(result, 0, sizeof(*result));
+    result->distance = INFINITY;
+    result->runner_up = INFINITY;
+    if (kws->count == 0 || samples > KWS_MAX_SAMPLES) {
+        return 1;
+    }
+
+    size_t begin;
+    size_t n = extract(kws, pcm, samples, &begin);
+    result->frames = n;
+    if (n < KWS_MIN_FRAMES) {
+        result->ms = now_ms() - start;
+        return 1;
+    }
+    const float *feat = kws->features + begin * MFCC_STRIDE;
+
+    // 每个命令取其全部模板中的最小距离；已经不可能进入前两名的模板提前放弃
+    const char *best_cmd = NULL;
+    for (int i = 0; i < kws->count; i++) {
+        const struct KwsTemplate *t = &kws->templates[i];
+        if (n > 2 * t->frames || t->frames > 2 * n) {
+            continue;  // 时长相差一倍以上
+        }
+        float d = dtw(kws->rows, feat, n, t->features, t->frames, result->runner_up);
+        if (d < result->distance) {
+            if (!best_cmd || strcmp(best_cmd, t->cmd) != 0) {
+                result->runner_up = result->distance;
+            }
+            result->distance = d;
+            best_cmd = t->cmd;
+        } else if (d < result->runner_up && strcmp(best_cmd, t->cmd) != 0) {
+            result->runner_up = d;
+        }
+    }
+    if (best_cmd) {
+        snprintf(result->cmd, sizeof(result->cmd), "%s", best_cmd);
+        result->confident = result->distance < kws->threshold &&
+                            result->distance < kws->margin * result->runner_up;
+    }
+    result->ms = now_ms() - start;
+    return result->confident ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#ifndef KWS_H
+#define KWS_H
+
+#include <stddef.h>
+#include "mfcc.h"
+
+#define KWS_DEFAULT_DIR "kws"        // 命令模板目录，文件名为 <命令>.wav 或 <命令>_<序号>.wav
+#define KWS_MAX_TEMPLATES 64
+#define KWS_MAX_FRAMES 400           // 超过 4 秒的语音不会是固定命令，直接交给 /stt/
+#define KWS_MIN_FRAMES 20            // 去掉首尾静音后短于 200ms 的语音不做匹配
+#define KWS_TRIM_DB 35.0f            // 帧能量低于最大帧能量该值以上视为首尾静音
+#define KWS_BAND_PERCENT 20          // DTW 路径偏离对角线的最大幅度（占较长序列的百分比）
+// 可信时直接执行命令并取消上传，误接受会让普通说话操作家电，所以工作点优先压低误接受：
+// kws_bench 合成语料上（80 条命令、40 条非命令）为本地执行 63/80、认错 0、误接受 0/40，
+// 单独把阈值放宽到 6.5 或边际放宽到 0.7 就开始出现误接受（两者都留有余量）；没被接受的命令仍由 /stt/ 识别
+#define KWS_DEFAULT_THRESHOLD 4.5f   // 平均帧距离低于该值才可能接受
+#define KWS_DEFAULT_MARGIN 0.65f     // 最优命令的距离还必须低于次优命令距离的该比例
+
+// 一个已登记的命令模板：去掉首尾静音、减去均值后的 MFCC 序列
+struct KwsTemplate {
+    char cmd[64];
+    size_t frames;
+    float *features;
+};
+
+// 一次匹配的结果
+struct KwsResult {
+    char cmd[64];       // 距离最小的命令，没有可比较的模板时为空
+    float distance;     // 该命令的 DTW 平均帧距离
+    float runner_up;    // 其它命令中的最小距离，没有时为 INFINITY
+    int confident;      // 1：可以不经过 /stt/ 直接执行
+    size_t frames;      // 参与匹配的语音帧数
+    double ms;          // 特征提取和匹配的耗时
+};
+
+// 本地关键词识别：对端点检测切出的整段语音提取 MFCC，与各命令的录音模板做 DTW 比较，
+// 距离足够小且明显优于其它命令时判为可信，否则仍由 /stt/ 识别
+// 匹配使用结构体中的临时缓冲区，同一时间只能在一个线程中调用
+struct Kws {
+    struct Mfcc mfcc;
+    struct KwsTemplate templates[KWS_MAX_TEMPLATES];
+    int count;
+    float threshold;
+    float margin;
+    float *features;    // 待匹配语音的特征（KWS_MAX_FRAMES 帧）
+    float *rows;        // DTW 的两行累计代价
+};
+
+int kws_init(struct Kws *kws);
+
+void kws_free(struct Kws *kws);
+
+// 登记一段命令录音（16kHz 单声道），成功返回 0
+int kws_enroll(struct Kws *kws, const char *cmd, const short *pcm, size_t samples);
+
+// 读取 WAV 文件（按 16kHz 单声道读入），最多读到比 KWS_MAX_SAMPLES 多一个周期为止（更长的语音
+// 交给 kws_spot 时按超长处理）；返回 malloc 的 PCM，由调用方 free，失败返回 NULL
+short *kws_load_wav(const char *path, size_t *samples);
+
+// 登记目录中的全部 WAV 模板，返回登记成功的个数，目录无法打开时返回 -1
+int kws_load_dir(struct Kws *kws, const char *dir);
+
+// 匹配一段语音，结果写入 result；可信返回 0，否则返回 1（包括没有模板、语音过长或过短）
+int kws_spot(struct Kws *kws, const short *pcm, size_t samples, struct KwsResult *result);
+
+#endif // KWS_H
@@ -1,35 +1,878 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
 #include <wiringPi.h>
 
 #include "chat.h"
 #include "audio_recognition.h"
+#include "http_client.h"
+#include "pipeline.h"
+#include "intent.h"
+#include "reply_cache.h"
+#include "arena.h"
+#include "actuator.h"
+#include "dht11.h"
+#include "sensor_history.h"
+#include "trace.h"
+#include "reactor.h"
+#include "kws.h"
+#include "server_health.h"
+#include "spool.h"
 
-// 控制GPIO（用于模拟实际动作）
-void control_gpio(const char *action) {
-    if (strcmp(action, "light_on") == 0) {
-        digitalWrite(6, HIGH); // 假设用 BCM 6 来控制灯
-        printf("GPIO 6 点亮\n");
-    } else if (strcmp(action, "light_off") == 0) {
-        digitalWrite(6, LOW); // 假设用 BCM 6 来控制灯
-        printf("GPIO 6 关闭\n");
+#define PIPELINE_DEPTH 4             // 同时在流水线中流转的语音条数
+#define PIPELINE_REPORT_INTERVAL 60  // 流水线统计输出间隔（秒）
+#define KWS_ENROLL_TAKES 3           // 登记命令模板时每个命令录制的遍数
+#define SPOOL_ACTION_MAX_AGE_S 120   // 补发的语音超过该时长时只输出回答，不再执行其中的命令
+
+// 一条语音在流水线中的全部状态，预先分配、循环复用（另有一条专供探测线程补发暂存的语音）
+// 录音、响应等缓冲区都从该语音自己的 arena 中切分，每条语音开始时整体复位
+struct Utterance {
+    unsigned long id;
+    struct Arena arena;
+    struct AudioBuffer audio;
+    struct SttStream stream;
+    struct Memory stt_response;  // /stt/ 返回的原始 JSON
+    char text[1024];             // 识别结果
+    struct Memory mem;           // /chat/ 返回的原始数据
+    struct AIResponse response;  // 解析后的回答和命令
+    struct AIResponse kws_response;  // 本地关键词识别的命令和回答（录音线程填写，/converse/ 的解析器同时在写 response）
+    atomic_int action_done;      // 动作已在流式解析或关键词识别中执行（两者可能在不同线程）
+    int kws_hit;                 // 本地关键词识别已确认命令，不再需要 /stt/ 和 /chat/
+    int offline;                 // 开始录音时服务器不可用：不上传，只做本地关键词识别，未命中时暂存
+    unsigned long alloc_start;   // 开始录音时的 malloc 计数（调试用）
+    struct Trace trace;          // 各阶段的时间点，追踪 ID 随请求发给服务端
+
+    // 以下只在事件循环模式（QYAI_EVENT_LOOP）中使用
+    int state;                   // UTT_*
+    int uploading;               // 上传已交给事件循环且尚未结束
+    int failed;                  // 录音期间上传已失败，录完后直接丢弃
+    struct SttUpload upload;
+    CURL *chat_curl;             // 本条语音独占的 /chat/stream/ 句柄
+    struct ChatStreamParser parser;  // /chat/stream/ 或 /converse/ 的响应解析器（流水线模式的 /converse/ 也使用）
+    char chat_request[2048];     // 请求体，异步请求结束前需保持有效
+    struct HttpTraceHeader chat_trace;
+};
+
+#define REPLY_CACHE_SAVE_INTERVAL 300  // 回答缓存落盘间隔（秒）
+
+static const char *debug_audio_file = NULL;
+static const char *trace_output = NULL;
+static struct ReplyCache reply_cache;  // 只在对话阶段线程（或事件循环）中访问
+static struct Kws kws;                 // 只在录音阶段线程（或事件循环）中访问
+static int kws_enabled;                // 模板目录中有可用模板
+
+// 每条语音的 arena 按端点检测参数决定的最长语音和响应缓冲区一次性分配
+static struct Utterance utterances[PIPELINE_DEPTH];
+static struct Utterance replay_utterance;  // 只在探测线程中使用
+static size_t arena_bytes;
+
+// 温湿度采样线程每次读取成功后写入历史数据
+static void record_sensor_sample(const struct Dht11Reading *reading) {
+    sensor_history_append(time(NULL), reading->temperature_x10, reading->humidity_x10);
+}
+
+/* 开始一条新语音：分配编号、开始追踪，并从 arena 中切出全部缓冲区 */
+static int utterance_begin(struct Utterance *u) {
+    static unsigned long next_id = 0;
+
+    u->id = ++next_id;
+    u->alloc_start = alloc_count();
+    u->action_done = 0;
+    u->kws_hit = 0;
+    u->offline = !server_health_up();
+    trace_begin(&u->trace);
+
+    // 复位 arena，重新切出本条语音使用的全部缓冲区（不涉及堆分配）
+    arena_reset(&u->arena);
+    size_t audio_bytes = audio_buffer_max_bytes();
+    void *audio_mem = arena_alloc(&u->arena, audio_bytes);
+    if (!audio_mem ||
+        memory_init(&u->stt_response, &u->arena, STT_RESPONSE_SIZE) != 0 ||
+        memory_init(&u->mem, &u->arena, CHAT_RESPONSE_SIZE) != 0) {
+        return -1;
+    }
+    audio_buffer_attach(&u->audio, audio_mem, audio_bytes);
+    return 0;
+}
+
+/* 流式回答中出现完整命令标记时立即执行，动作阶段不再重复执行 */
+static void on_stream_command(const char *cmd, void *userdata) {
+    struct Utterance *u = (struct Utterance *)userdata;
+    if (atomic_exchange(&u->action_done, 1)) {
+        return;  // 每条语音只执行第一个命令
+    }
+    printf("[%lu] 动作：%s\n", u->id, cmd);
+    actuator_submit(cmd);
+    trace_mark(&u->trace, TRACE_ACTION);
+}
+
+/* /converse/ 的第一行：识别结果，服务端随即开始生成回答 */
+static void on_converse_text(const char *text, void *userdata) {
+    struct Utterance *u = (struct Utterance *)userdata;
+    printf("[%lu] 识别结果: %s\n", u->id, text);
+}
+
+/*
+ * 本地关键词识别：录音结束后在整段语音上匹配命令模板，可信时把命令和固定回答写入 out 并返回 0，
+ * 调用方不再等待 /stt/；不可信或不是已知命令时返回 1，照常交给 /stt/
+ */
+static int spot_keyword(struct Utterance *u, struct AIResponse *out) {
+    if (!kws_enabled) {
+        return 1;
+    }
+    size_t samples;
+    const short *pcm = audio_buffer_pcm(&u->audio, &samples);
+    struct KwsResult result;
+    int rc = kws_spot(&kws, pcm, samples, &result);
+    if (rc < 0 || !result.cmd[0]) {
+        return 1;
+    }
+    printf("[%lu] 关键词：%s（距离 %.2f，次优 %.2f，耗时 %.1f ms）%s\n", u->id, result.cmd,
+           result.distance, result.runner_up, result.ms, rc == 0 ? "" : "，不可信，交给 /stt/");
+    if (rc != 0) {
+        return 1;
+    }
+    memset(out, 0, sizeof(*out));
+    if (intent_command(result.cmd, out) != 0) {
+        printf("[%lu] 模板命令 %s 不是已知命令\n", u->id, result.cmd);
+        return 1;
+    }
+    u->kws_hit = 1;
+    return 0;
+}
+
+/* 服务器不可用且本地无法处理：暂存录音，恢复后补发。返回 1（流水线丢弃本条语音） */
+static int spool_utterance(struct Utterance *u) {
+    if (spool_save(&u->audio) == 0) {
+        printf("[%lu] 服务器不可用，语音已暂存，恢复后补发\n", u->id);
+    }
+    return 1;
+}
+
+/* 阶段1：录音。流式模式下确认人声后即开始上传，录音结束后马上开始录下一条 */
+static int capture_stage(void *item, void *ctx) {
+    struct Utterance *u = (struct Utterance *)item;
+    (void)ctx;
+
+    if (utterance_begin(u) != 0) {
+        return -1;
+    }
+    int rc;
+    if (u->offline) {
+        rc = record_audio(&u->audio, &u->trace);  // 服务器不可用，只在本地录音
+    } else {
+#if STT_CONVERSE
+        // 识别结果和回答由上传线程中的解析器边收边写，命令标记到达时立即执行
+        chat_stream_parser_init(&u->parser, &u->response, on_stream_command, u);
+        chat_stream_parser_expect_text(&u->parser, u->text, sizeof(u->text), on_converse_text, &u->trace);
+        rc = record_audio_converse(&u->audio, &u->stream, &u->parser, &u->trace);
+#elif STT_STREAMING
+        rc = record_audio_streaming(&u->audio, &u->stream, &u->stt_response, &u->trace);
+#else
+        rc = record_audio(&u->audio, &u->trace);
+#endif
+    }
+    if (rc != 0) {
+        printf("录音失败\n");
+        return -1;
+    }
+    if (debug_audio_file && save_audio_buffer(&u->audio, debug_audio_file) == 0) {
+        printf("调试录音已保存到 %s\n", debug_audio_file);
+    }
+    if (spot_keyword(u, &u->kws_response) == 0) {
+        // 本地已识别出命令：取消上传，立即执行，不等待前面的语音走完识别和对话
+#if STT_STREAMING
+        if (!u->offline) {
+            stt_stream_abort(&u->stream);
+        }
+#endif
+        on_stream_command(u->kws_response.cmd, u);
+    } else if (u->offline && !server_health_up()) {
+        return spool_utterance(u);
+    }
+    return 0;
+}
+
+/* 阶段2：语音识别 */
+static int stt_stage(void *item, void *ctx) {
+    struct Utterance *u = (struct Utterance *)item;
+    (void)ctx;
+
+    if (u->kws_hit) {
+#if STT_STREAMING
+        if (!u->offline) {
+            stt_stream_wait(&u->stream);  // 回收已取消的上传线程，之后才能改写 response
+        }
+#endif
+        u->response = u->kws_response;
+        return 0;
+    }
+    int rc;
+    if (u->offline) {
+        // 录音时服务器不可用、录完时已恢复（否则已在录音阶段暂存）：整段上传
+        struct ChatStreamParser *parser = NULL;
+#if STT_CONVERSE
+        chat_stream_parser_init(&u->parser, &u->response, on_stream_command, u);
+        chat_stream_parser_expect_text(&u->parser, u->text, sizeof(u->text), on_converse_text, &u->trace);
+        parser = &u->parser;
+#endif
+        rc = stt_upload_recorded(&u->upload, &u->audio, &u->stt_response, parser, &u->trace);
+    } else {
+#if STT_STREAMING
+        rc = stt_stream_wait(&u->stream);
+#else
+        rc = upload_audio_to_api(&u->audio, &u->stt_response, &u->trace);
+#endif
+    }
+    if (rc != 0) {
+        printf("[%lu] 音频上传失败\n", u->id);
+        // 还没收到识别结果就失败了（不会有命令已执行），服务器因此断路时暂存
+#if STT_CONVERSE
+        int recognized = u->parser.has_text;
+#else
+        int recognized = 0;
+#endif
+        return !recognized && !server_health_up() ? spool_utterance(u) : -1;
+    }
+#if STT_CONVERSE
+    if (!u->parser.has_text) {
+#else
+    if (handle_api_response(u->stt_response.data, u->text) != 0) {
+#endif
+        printf("[%lu] 识别失败\n", u->id);
+        return -1;
+    }
+#if !STT_CONVERSE
+    printf("[%lu] 识别结果: %s\n", u->id, u->text);
+#endif
+    if (u->text[0] == '\0') {
+        printf("[%lu] 不进行ai对话\n", u->id);
+        return 1;
+    }
+    return 0;
+}
+
+/* 固定家电命令先在本地匹配，重复的问题直接使用缓存的回答；命中返回 0，需要请求大模型返回 1 */
+static int resolve_locally(struct Utterance *u) {
+    memset(&u->response, 0, sizeof(u->response));
+    u->action_done = 0;
+    if (intent_match(u->text, &u->response) == 0) {
+        printf("[%lu] 本地命中命令：%s\n", u->id, u->response.cmd);
+        return 0;
+    }
+    if (reply_cache_get(&reply_cache, u->text, &u->response) == 0) {
+        printf("[%lu] 命中回答缓存（命中 %lu，未命中 %lu）\n",
+               u->id, reply_cache.hits, reply_cache.misses);
+        return 0;
+    }
+    return 1;
+}
+
+/* 定期把缓存写入文件，重启后热点回答立即可用 */
+static void save_reply_cache_periodically(void) {
+    static time_t last_save = 0;
+    time_t now = time(NULL);
+    if (reply_cache.dirty && now - last_save >= REPLY_CACHE_SAVE_INTERVAL) {
+        reply_cache_save(&reply_cache, REPLY_CACHE_FILE);
+        last_save = now;
+        printf("回答缓存：%zu 条，命中 %lu，未命中 %lu，过期 %lu，淘汰 %lu\n",
+               reply_cache.count, reply_cache.hits, reply_cache.misses,
+               reply_cache.expired, reply_cache.evictions);
+    }
+}
+
+/* 阶段3：对话。固定家电命令先在本地匹配，只有开放式对话才请求大模型 */
+static int chat_stage(void *item, void *ctx) {
+    struct Utterance *u = (struct Utterance *)item;
+    (void)ctx;
+
+    if (u->kws_hit) {
+        return 0;
+    }
+#if STT_CONVERSE
+    // 回答已随识别结果一起返回（服务端先匹配固定命令、再查缓存），命令已在流式解析中执行
+    return 0;
+#else
+    if (resolve_locally(u) == 0) {
+        return 0;
+    }
+
+    printf("[%lu] 上传到ai进行对话\n", u->id);
+#if CHAT_STREAMING
+    // 边生成边解析，收到完整命令标记时立即执行动作，不等待整段回答生成完
+    struct ChatStreamParser parser;
+    chat_stream_parser_init(&parser, &u->response, on_stream_command, u);
+    int rc = get_ai_response_stream(u->text, &parser, &u->trace);
+    if (rc == 0) {
+        reply_cache_put(&reply_cache, u->text, &u->response);
+    }
+#else
+    int rc = get_ai_response(u->text, &u->mem, &u->trace);
+    if (rc == 0) {
+        // 解析AI响应
+        rc = parse_ai_response(&u->mem, &u->response);
+    }
+    if (rc == 0) {
+        reply_cache_put(&reply_cache, u->text, &u->response);
+    }
+#endif
+
+    save_reply_cache_periodically();
+    return rc;
+#endif
+}
+
+/* 阶段4：输出回答并执行动作 */
+static int action_stage(void *item, void *ctx) {
+    struct Utterance *u = (struct Utterance *)item;
+    (void)ctx;
+
+    // 温湿度查询直接使用采样线程发布的最新读数，不等待传感器
+    actuator_sensor_reply(u->response.cmd, u->response.msg, sizeof(u->response.msg));
+    printf("\n[%lu] AI回答：%s \n \n", u->id, u->response.msg);
+    if (u->action_done) {
+        // 已在对话阶段收到命令标记时执行
+    } else if (u->response.cmd[0]) {
+        printf("动作：%s\n", u->response.cmd);
+        actuator_submit(u->response.cmd);
+        trace_mark(&u->trace, TRACE_ACTION);
+    } else {
+        printf("动作：无\n");
+    }
+    trace_finish(&u->trace, stdout);
+
+#ifdef USE_DEBUG
+    // 稳态下本程序代码不应再有堆分配（全局计数，包含同时在流水线中的其它语音）
+    unsigned long allocs = alloc_count() - u->alloc_start;
+    if (allocs > 0) {
+        printf("[%lu] 警告：本条语音期间发生 %lu 次 malloc\n", u->id, allocs);
+    }
+#ifdef ALLOC_ASSERT
+    assert(allocs == 0);
+#endif
+#endif
+    return 0;
+}
+
+/* 登记命令模板（QYAI_KWS_ENROLL=命令）：录制 KWS_ENROLL_TAKES 遍，保存为 <模板目录>/<命令>_<序号>.wav。
+ * 模板经过与实际使用时相同的前端和端点检测，最好在设备的安装位置录制 */
+static int enroll_keyword(const char *cmd, const char *dir) {
+    struct AIResponse response;
+    if (intent_command(cmd, &response) != 0) {
+        fprintf(stderr, "未知命令：%s\n", cmd);
+        return -1;
+    }
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "无法创建模板目录 %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+
+    struct AudioBuffer buf = {0};
+    int rc = 0;
+    int take = 1;
+    while (take <= KWS_ENROLL_TAKES && rc == 0) {
+        printf("请说出命令 %s（%d/%d）\n", cmd, take, KWS_ENROLL_TAKES);
+        char path[512];
+        size_t samples;
+        snprintf(path, sizeof(path), "%s/%s_%d.wav", dir, cmd, take);
+        if (record_audio(&buf, NULL) != 0) {
+            rc = -1;
+        } else if (kws_enroll(&kws, cmd, audio_buffer_pcm(&buf, &samples), samples) != 0) {
+            printf("这一遍不能用作模板，请重新录制\n");
+        } else if (save_audio_buffer(&buf, path) != 0) {
+            fprintf(stderr, "无法保存模板 %s\n", path);
+            rc = -1;
+        } else {
+            printf("已保存 %s\n", path);
+            take++;
+        }
+    }
+    audio_buffer_free(&buf);
+    return rc;
+}
+
+/*
+ * 补发一条暂存的语音（在探测线程中同步执行，使用独立的句柄和缓冲区）：识别、对话并输出回答，
+ * 录音时间较近时执行其中的命令。服务器又不可用时返回 -1，文件保留到下次恢复
+ */
+static int replay_spooled(const char *path, time_t recorded, void *userdata) {
+    struct Utterance *u = (struct Utterance *)userdata;
+    arena_reset(&u->arena);
+    size_t audio_bytes = audio_buffer_max_bytes();
+    void *audio_mem = arena_alloc(&u->arena, audio_bytes);
+    if (!audio_mem || memory_init(&u->stt_response, &u->arena, STT_RESPONSE_SIZE) != 0) {
+        return -1;
+    }
+    audio_buffer_attach(&u->audio, audio_mem, audio_bytes);
+    if (load_audio_buffer(&u->audio, path) != 0) {
+        return 0;  // 文件损坏，直接删除
+    }
+
+    struct ChatStreamParser *parser = NULL;
+#if STT_CONVERSE
+    chat_stream_parser_init(&u->parser, &u->response, NULL, NULL);
+    chat_stream_parser_expect_text(&u->parser, u->text, sizeof(u->text), NULL, NULL);
+    parser = &u->parser;
+#endif
+    if (stt_upload_recorded(&u->upload, &u->audio, &u->stt_response, parser, NULL) != 0) {
+        return server_health_up() ? 0 : -1;
+    }
+#if STT_CONVERSE
+    if (!u->parser.has_text) {
+        return 0;
+    }
+#else
+    if (handle_api_response(u->stt_response.data, u->text) != 0) {
+        return 0;
+    }
+    memset(&u->response, 0, sizeof(u->response));
+    if (u->text[0] && intent_match(u->text, &u->response) != 0) {
+        // 回答缓存只在对话阶段线程中访问，补发时直接请求大模型
+        if (!u->chat_curl) {
+            u->chat_curl = http_client_dup_handle(HTTP_ENDPOINT_CHAT_STREAM);
+        }
+        chat_stream_parser_init(&u->parser, &u->response, NULL, NULL);
+        if (chat_stream_prepare(u->chat_curl, u->text, u->chat_request, sizeof(u->chat_request),
+                                &u->parser, NULL) != 0) {
+            return 0;
+        }
+        CURLcode res = http_client_perform_handle(u->chat_curl, NULL, NULL);
+        if (chat_stream_complete(u->chat_curl, &u->parser, res, NULL) != 0) {
+            return server_health_up() ? 0 : -1;
+        }
+    }
+#endif
+
+    char when[16];
+    struct tm tm;
+    strftime(when, sizeof(when), "%H:%M:%S", localtime_r(&recorded, &tm));
+    printf("[补发 %s] 识别结果: %s\n", when, u->text);
+    if (u->text[0] == '\0') {
+        return 0;
+    }
+    actuator_sensor_reply(u->response.cmd, u->response.msg, sizeof(u->response.msg));
+    printf("[补发 %s] AI回答：%s\n", when, u->response.msg);
+    if (!u->response.cmd[0]) {
+        printf("动作：无\n");
+    } else if (time(NULL) - recorded <= SPOOL_ACTION_MAX_AGE_S) {
+        printf("动作：%s\n", u->response.cmd);
+        actuator_submit(u->response.cmd);
+    } else {
+        printf("动作：%s（已过时，不执行）\n", u->response.cmd);
+    }
+    return 0;
+}
+
+/* 服务器恢复：按录音顺序补发暂存的语音 */
+static void on_server_recovered(void *userdata) {
+    struct SpoolStats stats;
+    spool_get_stats(&stats);
+    if (stats.pending == 0) {
+        return;
+    }
+    printf("补发暂存的 %lu 条语音\n", stats.pending);
+    int replayed = spool_replay(replay_spooled, userdata);
+    spool_get_stats(&stats);
+    printf("补发完成：%d 条，剩余 %lu 条，累计过期丢弃 %lu 条\n", replayed, stats.pending, stats.expired);
+}
+
+/* 定期输出的统计（两种运行模式共用） */
+static void print_report(void) {
+    trace_report(stdout);
+    trace_dump(trace_output);
+    actuator_report(stdout);
+    struct Dht11Stats dht;
+    dht11_get_stats(&dht);
+    printf("温湿度采样：成功 %lu，超时 %lu，校验错误 %lu，数值异常 %lu\n",
+           dht.ok, dht.timeouts, dht.bad_crc, dht.invalid);
+    unsigned long fe_frames, fe_gated;
+    get_input_levels(NULL, &fe_frames, &fe_gated);
+    printf("音频前端：处理 %lu 帧，静音门限跳过 fvad %.1f%%\n",
+           fe_frames, fe_frames ? 100.0 * fe_gated / fe_frames : 0.0);
+    unsigned long xruns, dropped;
+    get_capture_stats(&xruns, &dropped);
+    printf("采集：设备溢出 %lu 次，丢弃 %lu 帧\n", xruns, dropped);
+    size_t high_water = 0;
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        if (utterances[i].arena.high_water > high_water) {
+            high_water = utterances[i].arena.high_water;
+        }
+    }
+    printf("arena 峰值占用 %zu / %zu 字节，malloc 累计 %lu 次\n",
+           high_water, arena_bytes, alloc_count());
+    struct ServerHealthStats health;
+    struct SpoolStats spool;
+    server_health_get_stats(&health);
+    spool_get_stats(&spool);
+    printf("服务器：%s，失败 %lu 次，断路 %lu 次，探测 %lu 次（失败 %lu），累计不可用 %.1f 秒\n",
+           health.up ? "可用" : "不可用（本地模式）", health.failures, health.trips, health.probes,
+           health.probe_failures, health.down_ms / 1000);
+    printf("暂存：待补发 %lu 条，累计暂存 %lu，补发 %lu，过期 %lu，已满丢弃 %lu\n",
+           spool.pending, spool.saved, spool.replayed, spool.expired, spool.full);
+}
+
+/* 多线程模式：录音 -> 识别 -> 对话 -> 动作 四个阶段各自运行在独立线程上，
+ * 上一条语音等待大模型回答时，下一条语音已经可以开始录制和识别 */
+static int run_pipeline(void) {
+    void *items[PIPELINE_DEPTH];
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        items[i] = &utterances[i];
+    }
+
+    struct Pipeline pipeline;
+    if (pipeline_init(&pipeline, items, PIPELINE_DEPTH) != 0 ||
+        pipeline_add_stage(&pipeline, "录音", capture_stage, NULL) != 0 ||
+        pipeline_add_stage(&pipeline, "识别", stt_stage, NULL) != 0 ||
+        pipeline_add_stage(&pipeline, "对话", chat_stage, NULL) != 0 ||
+        pipeline_add_stage(&pipeline, "动作", action_stage, NULL) != 0 ||
+        pipeline_start(&pipeline) != 0) {
+        fprintf(stderr, "启动流水线失败\n");
+        return -1;
+    }
+
+    printf("程序运行\n");
+    // 主线程定期输出各阶段的队列深度和占用率，占用率最高的阶段即为瓶颈
+    // 注意“录音”阶段的占用率包含等待用户说话的时间
+    while (1) {
+        sleep(PIPELINE_REPORT_INTERVAL);
+        pipeline_report(&pipeline, stdout);
+        print_report();
+    }
+
+    pipeline_stop(&pipeline);
+    return 0;
+}
+
+/*
+ * 单线程事件循环模式（QYAI_EVENT_LOOP=1）：一个 poll() 同时等待声卡、cURL 套接字和定时器，
+ * 采集、流式上传、对话请求和温湿度采样都在主线程的回调中推进，不再需要采集线程、上传线程、
+ * 流水线的四个阶段线程和温湿度采样线程。执行器仍在自己的线程上执行动作（动作之间需要延时）。
+ * 多条语音同样可以重叠：上一条在等识别结果或大模型回答时，下一条已经在录音
+ */
+enum {
+    UTT_IDLE = 0,   // 空闲，可用于下一条语音
+    UTT_RECORDING,  // 录音中（确认人声后同时在上传）
+    UTT_STT,        // 录音结束，等待识别结果
+    UTT_CHAT,       // 等待大模型回答
+};
+
+#define CAPTURE_MAX_FDS 4
+
+struct EventLoop {
+    struct Reactor reactor;
+    struct CaptureSource *src;
+    struct pollfd capture_fds[CAPTURE_MAX_FDS];
+    int capture_nfds;
+    short *frame;                  // 从采集源读出的一帧
+    struct Utterance *recording;   // 正在录音的语音，没有时为 NULL
+    struct ReactorTimer sensor_timer;
+    struct ReactorTimer report_timer;
+    int sensor_attempt;            // 本采样周期内已失败的次数
+};
+
+static struct EventLoop event_loop;
+
+static void utterance_release(struct Utterance *u) {
+    if (u->uploading) {
+        reactor_transfer_remove(&event_loop.reactor, u->upload.curl);
+        u->uploading = 0;
+    }
+    if (event_loop.recording == u) {
+        event_loop.recording = NULL;
+    }
+    u->state = UTT_IDLE;
+}
+
+static void on_chat_done(struct Reactor *r, CURL *easy, CURLcode result, void *arg) {
+    struct Utterance *u = (struct Utterance *)arg;
+    (void)r;
+    server_health_report(easy, result);
+    http_client_clear_trace(easy);
+    if (chat_stream_complete(easy, &u->parser, result, &u->trace) == 0) {
+        reply_cache_put(&reply_cache, u->text, &u->response);
+        save_reply_cache_periodically();
+        action_stage(u, NULL);
+    }
+    utterance_release(u);
+}
+
+/* 识别完成：本地命中时直接执行，否则发起流式对话请求 */
+static void utterance_recognized(struct Utterance *u) {
+    if (handle_api_response(u->stt_response.data, u->text) != 0) {
+        printf("[%lu] 识别失败\n", u->id);
+        utterance_release(u);
+        return;
+    }
+    printf("[%lu] 识别结果: %s\n", u->id, u->text);
+    if (u->text[0] == '\0') {
+        printf("[%lu] 不进行ai对话\n", u->id);
+        utterance_release(u);
+        return;
+    }
+    if (resolve_locally(u) == 0) {
+        action_stage(u, NULL);
+        utterance_release(u);
+        return;
+    }
+
+    printf("[%lu] 上传到ai进行对话\n", u->id);
+    if (!u->chat_curl) {
+        u->chat_curl = http_client_dup_handle(HTTP_ENDPOINT_CHAT_STREAM);
+    }
+    chat_stream_parser_init(&u->parser, &u->response, on_stream_command, u);
+    if (chat_stream_prepare(u->chat_curl, u->text, u->chat_request, sizeof(u->chat_request),
+                            &u->parser, &u->trace) != 0) {
+        utterance_release(u);
+        return;
+    }
+    http_client_set_trace(u->chat_curl, &u->chat_trace, u->trace.id);
+    if (reactor_transfer_add(&event_loop.reactor, u->chat_curl, on_chat_done, u) != 0) {
+        http_client_clear_trace(u->chat_curl);
+        utterance_release(u);
+        return;
+    }
+    u->state = UTT_CHAT;
+}
+
+/* /converse/ 完成：识别结果和回答已由解析器填写，命令可能已在流式解析中执行 */
+static void utterance_answered(struct Utterance *u) {
+    if (!u->parser.has_text) {
+        printf("[%lu] 识别失败\n", u->id);
+    } else if (u->text[0] == '\0') {
+        printf("[%lu] 不进行ai对话\n", u->id);
+    } else {
+        action_stage(u, NULL);
+    }
+    utterance_release(u);
+}
+
+static void on_stt_done(struct Reactor *r, CURL *easy, CURLcode result, void *arg) {
+    struct Utterance *u = (struct Utterance *)arg;
+    (void)r; (void)easy;
+    u->uploading = 0;
+    int rc = stt_upload_complete(&u->upload, result);
+    if (u->state == UTT_RECORDING) {
+        // 请求体还没结束服务端就结束了请求（超时或出错），录完这一段后丢弃
+        printf("[%lu] 音频上传失败\n", u->id);
+        u->failed = 1;
+        return;
+    }
+    if (rc != 0) {
+        printf("[%lu] 音频上传失败\n", u->id);
+        if (!(u->upload.parser && u->parser.has_text) && !server_health_up()) {
+            spool_utterance(u);
+        }
+        utterance_release(u);
+        return;
+    }
+    if (u->upload.parser) {
+        utterance_answered(u);
+    } else {
+        utterance_recognized(u);
+    }
+}
+
+/* 开始流式上传（预录音频会最先发出），交给事件循环 */
+static int utterance_upload_start(struct Utterance *u) {
+    struct ChatStreamParser *parser = NULL;
+#if STT_CONVERSE
+    chat_stream_parser_init(&u->parser, &u->response, on_stream_command, u);
+    chat_stream_parser_expect_text(&u->parser, u->text, sizeof(u->text), on_converse_text, &u->trace);
+    parser = &u->parser;
+#endif
+    if (stt_upload_prepare(&u->upload, &u->audio, &u->stt_response, parser, &u->trace) != 0 ||
+        reactor_transfer_add(&event_loop.reactor, u->upload.curl, on_stt_done, u) != 0) {
+        return -1;
+    }
+    u->uploading = 1;
+    return 0;
+}
+
+/* 一帧采集数据：交给正在录音的语音，没有时取一个空闲槽位开始新的一条 */
+static void event_loop_feed(const short *frame) {
+    struct Utterance *u = event_loop.recording;
+    if (!u) {
+        for (int i = 0; i < PIPELINE_DEPTH && !u; i++) {
+            if (utterances[i].state == UTT_IDLE) {
+                u = &utterances[i];
+            }
+        }
+        if (!u) {
+            audio_drop_frame();  // 全部语音都在等待服务端，暂不监听
+            return;
+        }
+        if (utterance_begin(u) != 0 || audio_listen_start(&u->audio) != 0) {
+            return;
+        }
+        u->state = UTT_RECORDING;
+        u->uploading = 0;
+        u->failed = 0;
+        event_loop.recording = u;
+    }
+
+    int event = audio_feed_frame(&u->audio, frame, &u->trace);
+    if (event < 0) {
+        printf("录音失败\n");
+        utterance_release(u);
+        return;
+    }
+    if (event == VAD_EVENT_START) {
+        // 已确认人声，服务器可用时开始流式上传，不可用时只在本地录音
+        u->offline = !server_health_up();
+        if (!u->offline && utterance_upload_start(u) != 0) {
+            u->failed = 1;
+        }
+    }
+    if (u->uploading) {
+        stt_upload_resume(&u->upload, event == VAD_EVENT_END);
+    }
+    if (event != VAD_EVENT_END) {
+        return;
+    }
+
+    event_loop.recording = NULL;
+    if (debug_audio_file && save_audio_buffer(&u->audio, debug_audio_file) == 0) {
+        printf("调试录音已保存到 %s\n", debug_audio_file);
+    }
+    if (spot_keyword(u, &u->response) == 0) {
+        // 本地已识别出命令（上传失败时也可以），立即执行并取消上传；解析器只在事件循环中运行，不会同时改写 response
+        action_stage(u, NULL);
+        utterance_release(u);
+    } else if (u->offline && server_health_up() && utterance_upload_start(u) == 0) {
+        // 录音时服务器不可用、录完时已恢复：整段上传
+        stt_upload_resume(&u->upload, 1);
+        u->state = UTT_STT;
+    } else if (u->offline || u->failed) {
+        if (!server_health_up()) {
+            spool_utterance(u);
+        }
+        utterance_release(u);
+    } else {
+        u->state = UTT_STT;  // 上传已在录音期间结束时不会走到这里（见 on_stt_done）
+    }
+}
+
+static void on_capture_ready(struct Reactor *r, int fd, short revents, void *arg) {
+    struct CaptureSource *src = event_loop.src;
+    (void)arg;
+    for (int i = 0; i < event_loop.capture_nfds; i++) {
+        event_loop.capture_fds[i].revents = event_loop.capture_fds[i].fd == fd ? revents : 0;
+    }
+    int frames = src->poll_frames(src, event_loop.capture_fds, event_loop.capture_nfds);
+    if (frames < 0) {
+        reactor_stop(r);
+        return;
+    }
+    while (frames-- > 0) {
+        int rc = src->read(src, event_loop.frame);
+        if (rc <= 0) {
+            if (rc == 0) {
+                printf("采集源 %s 已读完\n", src->name);
+            }
+            reactor_stop(r);
+            return;
+        }
+        event_loop_feed(event_loop.frame);
+    }
+}
+
+/* 温湿度采样：读取约 30ms，期间采集数据留在声卡缓冲区中，不会丢失 */
+static void on_sensor_timer(struct Reactor *r, void *arg) {
+    (void)r; (void)arg;
+    if (dht11_sample(record_sensor_sample) == 0 || ++event_loop.sensor_attempt >= DHT11_MAX_RETRIES) {
+        event_loop.sensor_attempt = 0;
+        reactor_timer_arm(&event_loop.sensor_timer, DHT11_SAMPLE_INTERVAL_MS, 0);
     } else {
-        printf("未识别动作：%s\n", action);
+        reactor_timer_arm(&event_loop.sensor_timer, DHT11_RETRY_INTERVAL_MS, 0);
     }
 }
 
+static void on_report_timer(struct Reactor *r, void *arg) {
+    (void)arg;
+    reactor_report(r, stdout);
+    print_report();
+}
+
+static int run_event_loop(void) {
+    struct Reactor *r = &event_loop.reactor;
+    struct CaptureSource *src = get_capture_source();
+    if (!src->poll_descriptors) {
+        fprintf(stderr, "采集源 %s 不支持事件循环\n", src->name);
+        return -1;
+    }
+    if (reactor_init(r) != 0) {
+        return -1;
+    }
+    event_loop.src = src;
+    event_loop.frame = malloc(src->period * sizeof(short));
+    event_loop.capture_nfds = src->poll_descriptors(src, event_loop.capture_fds, CAPTURE_MAX_FDS);
+    int rc = -1;
+    if (!event_loop.frame || event_loop.capture_nfds <= 0) {
+        fprintf(stderr, "采集源 %s 无法接入事件循环\n", src->name);
+    } else {
+        rc = 0;
+        for (int i = 0; i < event_loop.capture_nfds && rc == 0; i++) {
+            rc = reactor_add_fd(r, event_loop.capture_fds[i].fd, event_loop.capture_fds[i].events,
+                                on_capture_ready, NULL);
+        }
+        if (rc == 0 &&
+            (reactor_timer_init(r, &event_loop.sensor_timer, on_sensor_timer, NULL) != 0 ||
+             reactor_timer_init(r, &event_loop.report_timer, on_report_timer, NULL) != 0)) {
+            rc = -1;
+        }
+    }
+
+    if (rc == 0) {
+        reactor_timer_arm(&event_loop.sensor_timer, 0, 0);
+        reactor_timer_arm(&event_loop.report_timer, PIPELINE_REPORT_INTERVAL * 1000L,
+                          PIPELINE_REPORT_INTERVAL * 1000L);
+        printf("程序运行（单线程事件循环）\n");
+        rc = reactor_run(r);
+    }
+
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        utterance_release(&utterances[i]);
+    }
+    reactor_timer_close(r, &event_loop.sensor_timer);
+    reactor_timer_close(r, &event_loop.report_timer);
+    reactor_free(r);
+    free(event_loop.frame);
+    return rc;
+}
+
 int main() {
     // 初始化 GPIO
     if (wiringPiSetup() == -1) {
         fprintf(stderr, "wiringPiSetupGpio 初始化失败\n");
         return 1;
     }
-    pinMode(6, OUTPUT);
+
+    // 温湿度在后台定时采样，查询时直接返回最新读数，历史数据按分钟、小时汇总保存
+    if (sensor_history_open(SENSOR_HISTORY_FILE) != 0) {
+        fprintf(stderr, "打开传感器历史数据失败，不保存历史\n");
+    }
+    // QYAI_EVENT_LOOP=1 时温湿度采样由事件循环的定时器驱动，不启动采样线程
+    const char *loop_env = getenv("QYAI_EVENT_LOOP");
+    // 设置 QYAI_KWS_ENROLL=命令 时只录制该命令的模板，录完即退出
+    const char *enroll_cmd = getenv("QYAI_KWS_ENROLL");
+    int use_event_loop = !enroll_cmd && loop_env && strcmp(loop_env, "0") != 0;
+    if (!use_event_loop && dht11_sampler_start(record_sensor_sample) != 0) {
+        return 1;
+    }
+
+    // 执行器在独立线程上执行动作，语音流水线只负责把命令放入队列
+    if (actuator_init() != 0) {
+        fprintf(stderr, "初始化执行器失败\n");
+        return 1;
+    }
 
     // char user_input[256];
-    struct Memory mem;
-    struct AIResponse response;
 
     // while (1) {
     //     printf("请输入指令: ");
@@ -44,7 +887,7 @@ int main() {
     //         printf("回答：%s\n", response.msg);
     //         if (response.cmd[0]) {
     //             printf("动作：%s\n", response.cmd);
-    //             control_gpio(response.cmd);
+    //             actuator_submit(response.cmd);
     //         } else {
     //             printf("动作：无\n");
     //         }
@@ -55,49 +898,132 @@ int main() {
 
     // return 0;
 
-    if (init_audio_device() != 0) {
-        fprintf(stderr, "初始化音频设备失败\n");
+    // 初始化与服务器的长连接（/stt/ 与 /chat/ 共用）
+    if (http_client_init() != 0) {
+        fprintf(stderr, "初始化 HTTP 客户端失败\n");
         return -1;
     }
-    
-    const char *audio_file = "recorded_audio.wav";
-    // 录制音频（可添加定时停止或其它退出条件）
-    
-    printf("程序运行\n");
-    // 调用 API 进行识别（示例）
-    char recognized_text[1024] = {0};
-    int i=0;
-    while (1)
-    {   
-        if (start_realtime_recognition(audio_file, recognized_text) == 0) {
-            printf("识别结果: %s\n", recognized_text);
-
-            if (get_ai_response(recognized_text, &mem) == 0 && strcmp(recognized_text, "") != 0 && !(sizeof(recognized_text)<2) ) {
-
-                printf("上传到ai进行对话\n");
-
-                // 解析AI响应
-                parse_ai_response(&mem, &response);
-        
-                // 输出 AI 回答和动作
-                printf("\nAI回答：%s \n \n", response.msg);
-                
-                if (response.cmd[0]) {
-                    printf("动作：%s\n", response.cmd);
-                    control_gpio(response.cmd);
-                } else {
-                    printf("动作：无\n");
-                }
-            } else{
-                printf("不进行ai对话\n");
+
+    // 构建本地命令匹配器
+    if (intent_init() != 0) {
+        fprintf(stderr, "初始化本地意图匹配失败\n");
+        return -1;
+    }
+
+    // 本地关键词识别：QYAI_KWS_DIR 为命令模板目录（默认 kws/），QYAI_KWS_THRESHOLD 调整接受阈值
+    const char *kws_dir = getenv("QYAI_KWS_DIR");
+    if (!kws_dir) {
+        kws_dir = KWS_DEFAULT_DIR;
+    }
+    if (kws_init(&kws) != 0) {
+        return -1;
+    }
+    const char *kws_threshold = getenv("QYAI_KWS_THRESHOLD");
+    if (kws_threshold) {
+        kws.threshold = strtof(kws_threshold, NULL);
+    }
+    if (!enroll_cmd) {
+        int templates = kws_load_dir(&kws, kws_dir);
+        struct AIResponse check;
+        for (int i = 0; i < kws.count; i++) {
+            if (intent_command(kws.templates[i].cmd, &check) != 0) {
+                printf("警告：模板 %s 不是已知命令，匹配到时仍交给 /stt/\n", kws.templates[i].cmd);
             }
+        }
+        kws_enabled = templates > 0;
+        if (kws_enabled) {
+            printf("本地关键词识别：%d 个模板，阈值 %.1f\n", templates, kws.threshold);
         } else {
-            printf("识别失败\n");
+            printf("没有命令模板（%s），不使用本地关键词识别\n", kws_dir);
+        }
+    }
+
+    // 回答缓存，启动时从文件预热
+    if (reply_cache_init(&reply_cache, REPLY_CACHE_CAPACITY, REPLY_CACHE_TTL) != 0) {
+        return -1;
+    }
+    reply_cache_load(&reply_cache, REPLY_CACHE_FILE);
+
+    // 设置 QYAI_REPLAY_WAV 环境变量后按实时速度循环回放该文件，代替麦克风（16kHz 单声道）
+    static struct CaptureSource replay_source;
+    const char *replay_file = getenv("QYAI_REPLAY_WAV");
+    if (replay_file) {
+        struct CaptureWavOptions replay = { .realtime = 1, .loop = 1, .pad_ms = CAPTURE_WAV_PAD_MS };
+        if (capture_source_open_wav(&replay_source, replay_file, AUDIO_RATE, AUDIO_PERIOD, &replay) != 0) {
+            return -1;
+        }
+        set_capture_source(&replay_source);
+    } else {
+        // 麦克风参数可通过 QYAI_PCM_DEVICE/RATE/PERIOD/BUFFER_PERIODS/ACCESS 调整，无需重新编译
+        struct AlsaCaptureConfig capture;
+        capture_alsa_config_default(&capture);
+        capture_alsa_config_from_env(&capture);
+        set_capture_config(&capture);
+    }
+
+    if ((use_event_loop ? init_audio_device_polled() : init_audio_device()) != 0) {
+        fprintf(stderr, "初始化音频设备失败\n");
+        return -1;
+    }
+    
+    // 录音默认只保存在内存中，设置 QYAI_DEBUG_WAV 环境变量后额外写入该文件用于调试
+    debug_audio_file = getenv("QYAI_DEBUG_WAV");
+
+    // 各区间的延迟直方图定期写入该文件，QYAI_TRACE_OUT=unix:/路径 时改为发送到 Unix 数据报套接字
+    trace_output = getenv("QYAI_TRACE_OUT");
+    if (!trace_output) {
+        trace_output = TRACE_DEFAULT_OUTPUT;
+    }
+
+    arena_bytes = audio_buffer_max_bytes() + STT_RESPONSE_SIZE + CHAT_RESPONSE_SIZE + 64;
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        if (arena_init(&utterances[i].arena, arena_bytes) != 0) {
+            return -1;
+        }
+        stt_stream_init(&utterances[i].stream);
+    }
+    printf("每条语音预分配 %zu KB，共 %d 条\n", arena_bytes / 1024, PIPELINE_DEPTH);
+
+    // 服务器健康监测：连续失败后转入本地模式（只做关键词识别，其它语音暂存到 QYAI_SPOOL_DIR，默认 spool/），
+    // 后台按指数退避探测，恢复后补发暂存的语音
+    if (!enroll_cmd) {
+        const char *spool_dir = getenv("QYAI_SPOOL_DIR");
+        if (spool_init(spool_dir ? spool_dir : SPOOL_DEFAULT_DIR) != 0 ||
+            arena_init(&replay_utterance.arena, arena_bytes) != 0 ||
+            server_health_start(on_server_recovered, &replay_utterance) != 0) {
+            return -1;
         }
-        i++;
     }
 
-    free(mem.data);
+    int rc = enroll_cmd ? enroll_keyword(enroll_cmd, kws_dir)
+             : use_event_loop ? run_event_loop() : run_pipeline();
+
+    server_health_stop();
+    actuator_shutdown();
+    dht11_sampler_stop();
+    sensor_history_close();
+    for (int i = 0; i < PIPELINE_DEPTH; i++) {
+        stt_stream_destroy(&utterances[i].stream);
+        arena_free(&utterances[i].arena);
+        if (utterances[i].upload.curl) {
+            curl_easy_cleanup(utterances[i].upload.curl);
+        }
+        if (utterances[i].chat_curl) {
+            curl_easy_cleanup(utterances[i].chat_curl);
+        }
+    }
+    arena_free(&replay_utterance.arena);
+    if (replay_utterance.upload.curl) {
+        curl_easy_cleanup(replay_utterance.upload.curl);
+    }
+    if (replay_utterance.chat_curl) {
+        curl_easy_cleanup(replay_utterance.chat_curl);
+    }
     cleanup();
-    return 0;
+    reply_cache_save(&reply_cache, REPLY_CACHE_FILE);
+    reply_cache_free(&reply_cache);
+    kws_free(&kws);
+    intent_free();
+    http_client_cleanup();
+    return rc == 0 ? 0 : 1;
 }
@@ -0,0 +1,219 @@
+#include <math.h>
+#include <string.h>
+#include "mfcc.h"
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MFCC_NEON 1
+#endif
+
+#define MFCC_LOG_FLOOR 1.0f  // 功率谱以 16 位采样的平方为单位，低于 1 视为数字静音
+
+static float hz_to_mel(float hz) {
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static float mel_to_hz(float mel) {
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+void mfcc_init(struct Mfcc *m) {
+    memset(m, 0, sizeof(*m));
+    for (int i = 0; i < MFCC_WINDOW; i++) {
+        m->window[i] = 0.54f - 0.46f * cosf(2.0f * (float)M_PI * i / (MFCC_WINDOW - 1));
+    }
+    for (int k = 0; k < MFCC_FFT / 2; k++) {
+        m->cos_table[k] = cosf(2.0f * (float)M_PI * k / MFCC_FFT);
+        m->sin_table[k] = -sinf(2.0f * (float)M_PI * k / MFCC_FFT);
+    }
+    for (int i = 0; i < MFCC_FFT; i++) {
+        int r = 0;
+        for (int b = 1, v = i; b < MFCC_FFT; b <<= 1, v >>= 1) {
+            r = (r << 1) | (v & 1);
+        }
+        m->bitrev[i] = r;
+    }
+
+    // 三角滤波器在 mel 刻度上等间隔，边界换算成（小数）频点
+    float low = hz_to_mel(MFCC_LOW_HZ);
+    float high = hz_to_mel(MFCC_HIGH_HZ);
+    float edges[MFCC_MELS + 2];
+    for (int i = 0; i < MFCC_MELS + 2; i++) {
+        edges[i] = mel_to_hz(low + (high - low) * i / (MFCC_MELS + 1)) * MFCC_FFT / MFCC_RATE;
+    }
+    for (int j = 0; j < MFCC_MELS; j++) {
+        float l = edges[j], c = edges[j + 1], r = edges[j + 2];
+        for (int b = (int)l + 1; b <= (int)r && b < MFCC_BINS; b++) {
+            float w = b <= c ? (b - l) / (c - l) : (r - b) / (r - c);
+            m->mel_weights[j][b] = w > 0 ? w : 0;
+        }
+        m->mel_begin[j] = ((int)l + 1) & ~3;
+        int end = ((int)r + 4) & ~3;
+        m->mel_end[j] = end < MFCC_BINS_PAD ? end : MFCC_BINS_PAD;
+    }
+
+    // 正交 DCT-II
+    for (int k = 0; k < MFCC_COEFFS; k++) {
+        float scale = sqrtf((k == 0 ? 1.0f : 2.0f) / MFCC_MELS);
+        for (int n = 0; n < MFCC_MELS; n++) {
+            m->dct[k][n] = scale * cosf((float)M_PI * k * (n + 0.5f) / MFCC_MELS);
+        }
+    }
+}
+
+size_t mfcc_frame_count(size_t samples) {
+    return samples < MFCC_WINDOW ? 0 : 1 + (samples - MFCC_WINDOW) / MFCC_HOP;
+}
+
+// 原位基 2 FFT，输入已按位反转顺序排列
+static void fft(const struct Mfcc *m, float *re, float *im) {
+    for (size_t half = 1; half < MFCC_FFT; half <<= 1) {
+        size_t step = MFCC_FFT / (half * 2);
+        for (size_t start = 0; start < MFCC_FFT; start += half * 2) {
+            for (size_t k = 0; k < half; k++) {
+                float wr = m->cos_table[k * step];
+                float wi = m->sin_table[k * step];
+                size_t a = start + k, b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+// 预加重、加窗并按位反转顺序写入 FFT 输入；p[-1] 必须可读
+static void window_scalar(const struct Mfcc *m, const short *p, float *re) {
+    for (int i = 0; i < MFCC_WINDOW; i++) {
+        re[m->bitrev[i]] = (p[i] - MFCC_PREEMPH * p[i - 1]) * m->window[i];
+    }
+}
+
+// 功率谱，返回全部频点的能量之和
+static float power_scalar(const float *re, const float *im, float *power) {
+    float total = 0;
+    for (int b = 0; b < MFCC_BINS; b++) {
+        power[b] = re[b] * re[b] + im[b] * im[b];
+        total += power[b];
+    }
+    return total;
+}
+
+static float dot_scalar(const float *a, const float *b, int begin, int end) {
+    float sum = 0;
+    for (int i = begin; i < end; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#ifdef MFCC_NEON
+static void window_neon(const struct Mfcc *m, const short *p, float *re) {
+    float x[MFCC_WINDOW];
+    float32x4_t pre = vdupq_n_f32(MFCC_PREEMPH);
+    for (int i = 0; i < MFCC_WINDOW; i += 4) {
+        float32x4_t cur = vcvtq_f32_s32(vmovl_s16(vld1_s16(p + i)));
+        float32x4_t prev = vcvtq_f32_s32(vmovl_s16(vld1_s16(p + i - 1)));
+        float32x4_t v = vmulq_f32(vfmsq_f32(cur, pre, prev), vld1q_f32(m->window + i));
+        vst1q_f32(x + i, v);
+    }
+    for (int i = 0; i < MFCC_WINDOW; i++) {
+        re[m->bitrev[i]] = x[i];
+    }
+}
+
+static float power_neon(const float *re, const float *im, float *power) {
+    float32x4_t total = vdupq_n_f32(0);
+    for (int b = 0; b < MFCC_BINS - 1; b += 4) {
+        float32x4_t r = vld1q_f32(re + b);
+        float32x4_t i = vld1q_f32(im + b);
+        float32x4_t v = vfmaq_f32(vmulq_f32(r, r), i, i);
+        vst1q_f32(power + b, v);
+        total = vaddq_f32(total, v);
+    }
+    int last = MFCC_BINS - 1;
+    power[last] = re[last] * re[last] + im[last] * im[last];
+    return vaddvq_f32(total) + power[last];
+}
+
+// begin、end 均按 4 对齐
+static float dot_neon(const float *a, const float *b, int begin, int end) {
+    float32x4_t sum = vdupq_n_f32(0);
+    for (int i = begin; i < end; i += 4) {
+        sum = vfmaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    return vaddvq_f32(sum);
+}
+#endif
+
+static void frame_features(const struct Mfcc *m, const short *p, float *out, int neon) {
+    float re[MFCC_FFT] = {0};
+    float im[MFCC_FFT] = {0};
+    float power[MFCC_BINS_PAD] = {0};
+    float logmel[MFCC_MELS_PAD] = {0};
+    float total;
+
+#ifdef MFCC_NEON
+    if (neon) {
+        window_neon(m, p, re);
+        fft(m, re, im);
+        total = power_neon(re, im, power);
+        for (int j = 0; j < MFCC_MELS; j++) {
+            float e = dot_neon(m->mel_weights[j], power, m->mel_begin[j], m->mel_end[j]);
+            logmel[j] = logf(e > MFCC_LOG_FLOOR ? e : MFCC_LOG_FLOOR);
+        }
+        for (int k = 0; k < MFCC_COEFFS; k++) {
+            out[k] = dot_neon(m->dct[k], logmel, 0, MFCC_MELS_PAD);
+        }
+        out[MFCC_ENERGY] = logf(total > MFCC_LOG_FLOOR ? total : MFCC_LOG_FLOOR);
+        return;
+    }
+#else
+    (void)neon;
+#endif
+    window_scalar(m, p, re);
+    fft(m, re, im);
+    total = power_scalar(re, im, power);
+    for (int j = 0; j < MFCC_MELS; j++) {
+        float e = dot_scalar(m->mel_weights[j], power, m->mel_begin[j], m->mel_end[j]);
+        logmel[j] = logf(e > MFCC_LOG_FLOOR ? e : MFCC_LOG_FLOOR);
+    }
+    for (int k = 0; k < MFCC_COEFFS; k++) {
+        out[k] = dot_scalar(m->dct[k], logmel, 0, MFCC_MELS);
+    }
+    out[MFCC_ENERGY] = logf(total > MFCC_LOG_FLOOR ? total : MFCC_LOG_FLOOR);
+}
+
+static size_t compute_frames(const struct Mfcc *m, const short *pcm, size_t samples, float *out,
+                             size_t max_frames, int neon) {
+    size_t frames = mfcc_frame_count(samples);
+    if (frames > max_frames) {
+        frames = max_frames;
+    }
+    memset(out, 0, frames * MFCC_STRIDE * sizeof(float));
+    if (frames == 0) {
+        return 0;
+    }
+
+    // 第一帧没有前一个采样，复制一份并把第一个采样重复一次作为预加重的输入
+    short first[MFCC_WINDOW + 1];
+    first[0] = pcm[0];
+    memcpy(first + 1, pcm, MFCC_WINDOW * sizeof(short));
+    frame_features(m, first + 1, out, neon);
+    for (size_t f = 1; f < frames; f++) {
+        frame_features(m, pcm + f * MFCC_HOP, out + f * MFCC_STRIDE, neon);
+    }
+    return frames;
+}
+
+size_t mfcc_compute(const struct Mfcc *m, const short *pcm, size_t samples, float *out, size_t max_frames) {
+    return compute_frames(m, pcm, samples, out, max_frames, 1);
+}
+
+size_t mfcc_compute_scalar(const struct Mfcc *m, const short *pcm, size_t samples, float *out,
+                           size_t max_frames) {
+    return compute_frames(m, pcm, samples, out, max_frames, 0);
+}
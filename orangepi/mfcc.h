@@ -0,0 +1,48 @@
+#ifndef MFCC_H
+#define MFCC_H
+
+#include <stddef.h>
+
+// 特征参数（16kHz，25ms 窗、10ms 帧移）
+#define MFCC_RATE     16000
+#define MFCC_WINDOW   400        // 窗长（采样数）
+#define MFCC_HOP      160        // 帧移（采样数）
+#define MFCC_FFT      512
+#define MFCC_BINS     (MFCC_FFT / 2 + 1)
+#define MFCC_BINS_PAD 260        // 频谱按 4 对齐补零，便于向量化
+#define MFCC_MELS     26         // mel 滤波器个数
+#define MFCC_MELS_PAD 28
+#define MFCC_COEFFS   13         // 输出的倒谱系数个数（含 c0）
+#define MFCC_STRIDE   16         // 每帧特征占用的 float 个数，系数之后补零
+#define MFCC_ENERGY   13         // 每帧特征中存放帧对数能量的位置
+#define MFCC_PREEMPH  0.97f
+#define MFCC_LOW_HZ   100.0f
+#define MFCC_HIGH_HZ  7600.0f
+
+// 预先计算的窗函数、FFT 旋转因子、mel 滤波器和 DCT 矩阵，初始化后只读，可多线程共用
+struct Mfcc {
+    float window[MFCC_WINDOW];
+    float cos_table[MFCC_FFT / 2];
+    float sin_table[MFCC_FFT / 2];
+    unsigned short bitrev[MFCC_FFT];
+    float mel_weights[MFCC_MELS][MFCC_BINS_PAD];
+    unsigned short mel_begin[MFCC_MELS];  // 每个滤波器非零权重的范围 [begin, end)，按 4 对齐
+    unsigned short mel_end[MFCC_MELS];
+    float dct[MFCC_COEFFS][MFCC_MELS_PAD];
+};
+
+void mfcc_init(struct Mfcc *m);
+
+// samples 个采样能分出的帧数
+size_t mfcc_frame_count(size_t samples);
+
+// 计算 MFCC：每帧 MFCC_STRIDE 个 float，前 MFCC_COEFFS 个为倒谱系数，MFCC_ENERGY 处为帧对数能量，
+// 其余为 0；最多输出 max_frames 帧，返回帧数
+// 在 aarch64 上使用 NEON，其它平台使用标量实现，两者结果在浮点舍入误差内一致
+size_t mfcc_compute(const struct Mfcc *m, const short *pcm, size_t samples, float *out, size_t max_frames);
+
+// 标量实现（无 NEON 平台使用，也供基准测试对比）
+size_t mfcc_compute_scalar(const struct Mfcc *m, const short *pcm, size_t samples, float *out,
+                           size_t max_frames);
+
+#endif // MFCC_H
@@ -0,0 +1,215 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pipeline.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int queue_init(struct BoundedQueue *q, size_t capacity) {
+    q->items = calloc(capacity, sizeof(void *));
+    if (!q->items) {
+        return -1;
+    }
+    q->capacity = capacity;
+    q->head = 0;
+    q->count = 0;
+    q->max_count = 0;
+    q->closed = 0;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    return 0;
+}
+
+static void queue_destroy(struct BoundedQueue *q) {
+    if (!q->items) {
+        return;
+    }
+    pthread_cond_destroy(&q->not_full);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_mutex_destroy(&q->lock);
+    free(q->items);
+    q->items = NULL;
+}
+
+// 入队，队列满时阻塞；队列已关闭返回 -1
+static int queue_push(struct BoundedQueue *q, void *item) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->capacity && !q->closed) {
+        pthread_cond_wait(&q->not_full, &q->lock);
+    }
+    if (q->closed) {
+        pthread_mutex_unlock(&q->lock);
+        return -1;
+    }
+    q->items[(q->head + q->count) % q->capacity] = item;
+    q->count++;
+    if (q->count > q->max_count) {
+        q->max_count = q->count;
+    }
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+// 出队，队列空时阻塞；队列已关闭返回 NULL
+static void *queue_pop(struct BoundedQueue *q) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closed) {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+    if (q->count == 0) {
+        pthread_mutex_unlock(&q->lock);
+        return NULL;
+    }
+    void *item = q->items[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return item;
+}
+
+static void queue_close(struct BoundedQueue *q) {
+    pthread_mutex_lock(&q->lock);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+}
+
+static void *stage_worker(void *arg) {
+    struct PipelineStage *stage = (struct PipelineStage *)arg;
+    void *item;
+
+    while ((item = queue_pop(stage->in)) != NULL) {
+        uint64_t start = now_ns();
+        int rc = stage->process(item, stage->ctx);
+        uint64_t elapsed = now_ns() - start;
+
+        pthread_mutex_lock(&stage->stats_lock);
+        stage->busy_ns += elapsed;
+        stage->processed++;
+        stage->total++;
+        if (rc != 0) {
+            stage->dropped++;
+        }
+        pthread_mutex_unlock(&stage->stats_lock);
+
+        if (queue_push(rc == 0 ? stage->out : stage->drop, item) != 0) {
+            break;  // 流水线已停止
+        }
+    }
+    return NULL;
+}
+
+int pipeline_init(struct Pipeline *p, void **items, size_t item_count) {
+    memset(p, 0, sizeof(*p));
+    p->items = items;
+    p->item_count = item_count;
+
+    // 空闲池容量等于条目数，初始时装满全部条目
+    if (queue_init(&p->queues[0], item_count) != 0) {
+        fprintf(stderr, "流水线队列分配失败\n");
+        return -1;
+    }
+    for (size_t i = 0; i < item_count; i++) {
+        queue_push(&p->queues[0], items[i]);
+    }
+    p->queues[0].max_count = 0;
+    return 0;
+}
+
+int pipeline_add_stage(struct Pipeline *p, const char *name, pipeline_stage_fn process, void *ctx) {
+    if (p->stage_count >= PIPELINE_MAX_STAGES) {
+        fprintf(stderr, "流水线阶段过多: %s\n", name);
+        return -1;
+    }
+    int idx = p->stage_count;
+    // 第一个阶段的输入是空闲池，其余阶段各有一个输入队列
+    if (idx > 0 && queue_init(&p->queues[idx], p->item_count) != 0) {
+        fprintf(stderr, "流水线队列分配失败\n");
+        return -1;
+    }
+
+    struct PipelineStage *stage = &p->stages[idx];
+    stage->name = name;
+    stage->process = process;
+    stage->ctx = ctx;
+    stage->in = &p->queues[idx];
+    stage->drop = &p->queues[0];
+    pthread_mutex_init(&stage->stats_lock, NULL);
+    if (idx > 0) {
+        p->stages[idx - 1].out = stage->in;
+    }
+    stage->out = &p->queues[0];  // 最后一个阶段把条目送回空闲池
+    p->stage_count++;
+    return 0;
+}
+
+int pipeline_start(struct Pipeline *p) {
+    p->report_start_ns = now_ns();
+    for (int i = 0; i < p->stage_count; i++) {
+        if (pthread_create(&p->stages[i].tid, NULL, stage_worker, &p->stages[i]) != 0) {
+            fprintf(stderr, "无法创建流水线线程: %s\n", p->stages[i].name);
+            p->stage_count = i;
+            pipeline_stop(p);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void pipeline_stop(struct Pipeline *p) {
+    for (int i = 0; i < p->stage_count; i++) {
+        queue_close(&p->queues[i]);
+    }
+    for (int i = 0; i < p->stage_count; i++) {
+        pthread_join(p->stages[i].tid, NULL);
+        pthread_mutex_destroy(&p->stages[i].stats_lock);
+    }
+    for (int i = 0; i < PIPELINE_MAX_STAGES; i++) {
+        queue_destroy(&p->queues[i]);
+    }
+    p->stage_count = 0;
+}
+
+void pipeline_report(struct Pipeline *p, FILE *out) {
+    uint64_t now = now_ns();
+    double window_ms = (now - p->report_start_ns) / 1e6;
+    p->report_start_ns = now;
+    if (window_ms <= 0) {
+        return;
+    }
+
+    fprintf(out, "流水线统计（%.1f 秒）：\n", window_ms / 1000.0);
+    for (int i = 0; i < p->stage_count; i++) {
+        struct PipelineStage *stage = &p->stages[i];
+        struct BoundedQueue *q = stage->in;
+
+        pthread_mutex_lock(&q->lock);
+        size_t depth = q->count;
+        size_t max_depth = q->max_count;
+        q->max_count = q->count;
+        pthread_mutex_unlock(&q->lock);
+
+        pthread_mutex_lock(&stage->stats_lock);
+        double busy_ms = stage->busy_ns / 1e6;
+        unsigned long processed = stage->processed;
+        unsigned long dropped = stage->dropped;
+        unsigned long total = stage->total;
+        stage->busy_ns = 0;
+        stage->processed = 0;
+        stage->dropped = 0;
+        pthread_mutex_unlock(&stage->stats_lock);
+
+        // 占用率接近 100% 的阶段就是限制吞吐的瓶颈
+        fprintf(out, "  %-8s 输入队列 %zu（峰值 %zu） 占用率 %5.1f%% 处理 %lu（丢弃 %lu，累计 %lu） 平均 %.1f ms\n",
+                stage->name, depth, max_depth, 100.0 * busy_ms / window_ms,
+                processed, dropped, total, processed ? busy_ms / processed : 0.0);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define PIPELINE_MAX_STAGES 8
+
+// 有界阻塞队列，存放在各阶段之间传递的条目指针
+struct BoundedQueue {
+    void **items;
+    size_t capacity;
+    size_t head;            // 下一个出队位置
+    size_t count;           // 当前条目数
+    size_t max_count;       // 统计周期内的最大深度
+    int closed;             // 关闭后出队立即返回 NULL
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+};
+
+// 阶段处理函数：返回 0 表示把条目交给下一阶段，非 0 表示丢弃（条目直接回到空闲池）
+typedef int (*pipeline_stage_fn)(void *item, void *ctx);
+
+// 流水线中的一个阶段，每个阶段运行在独立的工作线程上
+struct PipelineStage {
+    const char *name;
+    pipeline_stage_fn process;
+    void *ctx;
+    pthread_t tid;
+    struct BoundedQueue *in;
+    struct BoundedQueue *out;
+    struct BoundedQueue *drop;  // 丢弃的条目放回空闲池
+
+    // 统计信息（由工作线程更新，报告时加锁读取）
+    pthread_mutex_t stats_lock;
+    uint64_t busy_ns;           // 统计周期内处理条目的累计耗时
+    unsigned long processed;    // 统计周期内处理的条目数
+    unsigned long dropped;      // 统计周期内丢弃的条目数
+    unsigned long total;        // 累计处理条目数
+};
+
+// 环形流水线：空闲池 -> 阶段0 -> 队列1 -> 阶段1 -> ... -> 最后一个阶段 -> 空闲池
+// 条目数量固定，空闲池为空时第一个阶段阻塞，形成反压
+struct Pipeline {
+    struct BoundedQueue queues[PIPELINE_MAX_STAGES];  // queues[0] 为空闲池，queues[i] 为阶段 i 的输入
+    struct PipelineStage stages[PIPELINE_MAX_STAGES];
+    int stage_count;
+    size_t item_count;
+    void **items;
+    uint64_t report_start_ns;   // 当前统计周期的起点
+};
+
+// 用预先分配好的条目初始化流水线，条目全部放入空闲池
+int pipeline_init(struct Pipeline *p, void **items, size_t item_count);
+
+// 按顺序追加阶段（启动前调用）
+int pipeline_add_stage(struct Pipeline *p, const char *name, pipeline_stage_fn process, void *ctx);
+
+// 启动所有阶段的工作线程
+int pipeline_start(struct Pipeline *p);
+
+// 关闭所有队列并等待工作线程退出
+void pipeline_stop(struct Pipeline *p);
+
+// 输出各队列深度和各阶段占用率（忙碌时间 / 统计周期时长），并开始新的统计周期
+void pipeline_report(struct Pipeline *p, FILE *out);
+
+#endif // PIPELINE_H
@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+#include "reactor.h"
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int find_fd(const struct Reactor *r, int fd) {
+    for (int i = 0; i < r->nfds; i++) {
+        if (r->fds[i].fd == fd) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int reactor_add_fd(struct Reactor *r, int fd, short events, reactor_fd_fn fn, void *arg) {
+    if (r->nfds == REACTOR_MAX_FDS) {
+        fprintf(stderr, "事件循环描述符已满（%d）\n", REACTOR_MAX_FDS);
+        return -1;
+    }
+    // 新表项追加在末尾，分发过程中不会改变已有表项的位置
+    int i = r->nfds++;
+    r->fds[i].fd = fd;
+    r->fds[i].events = events;
+    r->fds[i].revents = 0;
+    r->watches[i].fn = fn;
+    r->watches[i].arg = arg;
+    return 0;
+}
+
+int reactor_set_events(struct Reactor *r, int fd, short events) {
+    int i = find_fd(r, fd);
+    if (i < 0) {
+        return -1;
+    }
+    r->fds[i].events = events;
+    return 0;
+}
+
+void reactor_remove_fd(struct Reactor *r, int fd) {
+    int i = find_fd(r, fd);
+    if (i >= 0) {
+        // 先置为 -1（poll 会忽略负数描述符），本轮分发结束后再压缩
+        r->fds[i].fd = -1;
+        r->fds[i].revents = 0;
+        r->removed++;
+    }
+}
+
+static void compact_fds(struct Reactor *r) {
+    int n = 0;
+    for (int i = 0; i < r->nfds; i++) {
+        if (r->fds[i].fd >= 0) {
+            r->fds[n] = r->fds[i];
+            r->watches[n] = r->watches[i];
+            n++;
+        }
+    }
+    r->nfds = n;
+    r->removed = 0;
+}
+
+static void on_timer_fd(struct Reactor *r, int fd, short revents, void *arg) {
+    struct ReactorTimer *t = (struct ReactorTimer *)arg;
+    uint64_t expirations;
+    (void)revents;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return;  // 已被重新设置，没有到期
+    }
+    t->fn(r, t->arg);
+}
+
+int reactor_timer_init(struct Reactor *r, struct ReactorTimer *t, reactor_timer_fn fn, void *arg) {
+    t->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (t->fd < 0) {
+        fprintf(stderr, "无法创建定时器: %s\n", strerror(errno));
+        return -1;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    if (reactor_add_fd(r, t->fd, POLLIN, on_timer_fd, t) != 0) {
+        close(t->fd);
+        t->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+int reactor_timer_arm(struct ReactorTimer *t, long delay_ms, unsigned long interval_ms) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (delay_ms >= 0) {
+        // it_value 全为 0 表示停止，立即触发用 1 纳秒代替
+        spec.it_value.tv_sec = delay_ms / 1000;
+        spec.it_value.tv_nsec = delay_ms > 0 ? (delay_ms % 1000) * 1000000L : 1;
+        spec.it_interval.tv_sec = interval_ms / 1000;
+        spec.it_interval.tv_nsec = (interval_ms % 1000) * 1000000L;
+    }
+    return timerfd_settime(t->fd, 0, &spec, NULL);
+}
+
+void reactor_timer_close(struct Reactor *r, struct ReactorTimer *t) {
+    if (t->fd >= 0) {
+        reactor_remove_fd(r, t->fd);
+        close(t->fd);
+        t->fd = -1;
+    }
+}
+
+// 收集结束的传输：先从 multi 中移除再回调，回调中可以立即复用句柄发起下一个请求
+static void check_transfers(struct Reactor *r) {
+    CURLMsg *msg;
+    int left;
+    while ((msg = curl_multi_info_read(r->multi, &left))) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        CURL *easy = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        curl_multi_remove_handle(r->multi, easy);
+        for (int i = 0; i < REACTOR_MAX_TRANSFERS; i++) {
+            struct reactor_transfer *t = &r->transfers[i];
+            if (t->easy == easy) {
+                t->easy = NULL;
+                t->fn(r, easy, result, t->arg);
+                break;
+            }
+        }
+    }
+}
+
+static void on_curl_socket(struct Reactor *r, int fd, short revents, void *arg) {
+    int running;
+    int mask = 0;
+    (void)arg;
+    if (revents & POLLIN) mask |= CURL_CSELECT_IN;
+    if (revents & POLLOUT) mask |= CURL_CSELECT_OUT;
+    if (revents & (POLLERR | POLLHUP)) mask |= CURL_CSELECT_ERR;
+    curl_multi_socket_action(r->multi, fd, mask, &running);
+    check_transfers(r);
+}
+
+static void on_curl_timeout(struct Reactor *r, void *arg) {
+    int running;
+    (void)arg;
+    curl_multi_socket_action(r->multi, CURL_SOCKET_TIMEOUT, 0, &running);
+    check_transfers(r);
+}
+
+// cURL 通知需要监视或不再监视某个套接字
+static int curl_socket_cb(CURL *easy, curl_socket_t s, int what, void *userp, void *socketp) {
+    struct Reactor *r = (struct Reactor *)userp;
+    (void)easy; (void)socketp;
+    if (what == CURL_POLL_REMOVE) {
+        reactor_remove_fd(r, s);
+        return 0;
+    }
+    short events = ((what & CURL_POLL_IN) ? POLLIN : 0) | ((what & CURL_POLL_OUT) ? POLLOUT : 0);
+    if (reactor_set_events(r, s, events) == 0) {
+        return 0;
+    }
+    return reactor_add_fd(r, s, events, on_curl_socket, NULL);
+}
+
+// cURL 通知下一次超时，-1 表示取消
+static int curl_timer_cb(CURLM *multi, long timeout_ms, void *userp) {
+    struct Reactor *r = (struct Reactor *)userp;
+    (void)multi;
+    return reactor_timer_arm(&r->curl_timer, timeout_ms, 0);
+}
+
+int reactor_init(struct Reactor *r) {
+    memset(r, 0, sizeof(*r));
+    r->curl_timer.fd = -1;
+    r->multi = curl_multi_init();
+    if (!r->multi) {
+        fprintf(stderr, "无法创建 cURL multi 句柄\n");
+        return -1;
+    }
+    if (reactor_timer_init(r, &r->curl_timer, on_curl_timeout, NULL) != 0) {
+        reactor_free(r);
+        return -1;
+    }
+    curl_multi_setopt(r->multi, CURLMOPT_SOCKETFUNCTION, curl_socket_cb);
+    curl_multi_setopt(r->multi, CURLMOPT_SOCKETDATA, r);
+    curl_multi_setopt(r->multi, CURLMOPT_TIMERFUNCTION, curl_timer_cb);
+    curl_multi_setopt(r->multi, CURLMOPT_TIMERDATA, r);
+    r->start_ns = now_ns();
+    return 0;
+}
+
+void reactor_free(struct Reactor *r) {
+    if (r->multi) {
+        for (int i = 0; i < REACTOR_MAX_TRANSFERS; i++) {
+            if (r->transfers[i].easy) {
+                curl_multi_remove_handle(r->multi, r->transfers[i].easy);
+                r->transfers[i].easy = NULL;
+            }
+        }
+        curl_multi_cleanup(r->multi);
+        r->multi = NULL;
+    }
+    reactor_timer_close(r, &r->curl_timer);
+    r->nfds = 0;
+}
+
+int reactor_transfer_add(struct Reactor *r, CURL *easy, reactor_transfer_fn fn, void *arg) {
+    for (int i = 0; i < REACTOR_MAX_TRANSFERS; i++) {
+        struct reactor_transfer *t = &r->transfers[i];
+        if (t->easy) {
+            continue;
+        }
+        CURLMcode rc = curl_multi_add_handle(r->multi, easy);
+        if (rc != CURLM_OK) {
+            fprintf(stderr, "无法添加传输: %s\n", curl_multi_strerror(rc));
+            return -1;
+        }
+        t->easy = easy;
+        t->fn = fn;
+        t->arg = arg;
+        return 0;  // cURL 会通过 curl_timer_cb 要求立即开始
+    }
+    fprintf(stderr, "同时进行的传输已满（%d）\n", REACTOR_MAX_TRANSFERS);
+    return -1;
+}
+
+void reactor_transfer_remove(struct Reactor *r, CURL *easy) {
+    for (int i = 0; i < REACTOR_MAX_TRANSFERS; i++) {
+        if (r->transfers[i].easy == easy) {
+            curl_multi_remove_handle(r->multi, easy);
+            r->transfers[i].easy = NULL;
+            return;
+        }
+    }
+}
+
+int reactor_run(struct Reactor *r) {
+    r->running = 1;
+    while (r->running) {
+        int ready = poll(r->fds, r->nfds, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "poll 失败: %s\n", strerror(errno));
+            return -1;
+        }
+        uint64_t begin = now_ns();
+        r->wakeups++;
+
+        // 回调中新增的描述符追加在末尾，留到下一轮
+        int count = r->nfds;
+        for (int i = 0; i < count && ready > 0; i++) {
+            short revents = r->fds[i].revents;
+            if (r->fds[i].fd < 0 || revents == 0) {
+                continue;
+            }
+            ready--;
+            r->fds[i].revents = 0;
+            r->watches[i].fn(r, r->fds[i].fd, revents, r->watches[i].arg);
+        }
+        if (r->removed) {
+            compact_fds(r);
+        }
+        r->busy_ns += now_ns() - begin;
+    }
+    return 0;
+}
+
+void reactor_stop(struct Reactor *r) {
+    r->running = 0;
+}
+
+void reactor_report(const struct Reactor *r, FILE *out) {
+    double elapsed = (now_ns() - r->start_ns) / 1e9;
+    if (elapsed <= 0) {
+        return;
+    }
+    fprintf(out, "事件循环：唤醒 %lu 次（%.1f 次/秒），回调耗时占 %.2f%%，监视 %d 个描述符\n",
+            r->wakeups, r->wakeups / elapsed, 100.0 * r->busy_ns / 1e9 / elapsed, r->nfds);
+}
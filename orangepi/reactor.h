@@ -0,0 +1,94 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <poll.h>
+#include <curl/curl.h>
+
+#define REACTOR_MAX_FDS 32        // 同时监视的描述符上限（采集设备、定时器、cURL 套接字）
+#define REACTOR_MAX_TRANSFERS 8   // 同时进行的 cURL 传输上限
+
+struct Reactor;
+
+// 描述符就绪回调，revents 为 poll() 返回的事件
+typedef void (*reactor_fd_fn)(struct Reactor *r, int fd, short revents, void *arg);
+typedef void (*reactor_timer_fn)(struct Reactor *r, void *arg);
+// cURL 传输结束回调，回调前句柄已从 multi 中移除，可以立即复用
+typedef void (*reactor_transfer_fn)(struct Reactor *r, CURL *easy, CURLcode result, void *arg);
+
+// 基于 timerfd 的定时器，由 reactor_timer_init 注册到事件循环
+struct ReactorTimer {
+    int fd;
+    reactor_timer_fn fn;
+    void *arg;
+};
+
+struct reactor_watch {
+    reactor_fd_fn fn;
+    void *arg;
+};
+
+struct reactor_transfer {
+    CURL *easy;               // NULL 表示空闲
+    reactor_transfer_fn fn;
+    void *arg;
+};
+
+// 单线程事件循环：poll() 同时等待采集设备、定时器和 cURL 套接字，全部回调都在 reactor_run 的线程中执行
+// 描述符表和传输表都是定长数组，运行期间不申请内存
+struct Reactor {
+    struct pollfd fds[REACTOR_MAX_FDS];
+    struct reactor_watch watches[REACTOR_MAX_FDS];
+    int nfds;
+    int removed;                    // 分发期间被移除（fd 置为 -1）的表项数，本轮结束后压缩
+    CURLM *multi;
+    struct ReactorTimer curl_timer; // cURL 要求的超时
+    struct reactor_transfer transfers[REACTOR_MAX_TRANSFERS];
+    int running;
+    unsigned long wakeups;          // poll() 返回次数
+    uint64_t busy_ns;               // 回调累计耗时
+    uint64_t start_ns;
+};
+
+// 初始化事件循环和 curl_multi（需先调用 http_client_init）
+int reactor_init(struct Reactor *r);
+
+// 中止未完成的传输并释放资源
+void reactor_free(struct Reactor *r);
+
+// 监视描述符，events 为 POLLIN/POLLOUT 组合
+int reactor_add_fd(struct Reactor *r, int fd, short events, reactor_fd_fn fn, void *arg);
+
+// 修改已监视描述符的事件，描述符未注册时返回 -1
+int reactor_set_events(struct Reactor *r, int fd, short events);
+
+// 停止监视描述符（可在回调中调用）
+void reactor_remove_fd(struct Reactor *r, int fd);
+
+// 创建定时器并注册到事件循环，初始为未启动状态
+int reactor_timer_init(struct Reactor *r, struct ReactorTimer *t, reactor_timer_fn fn, void *arg);
+
+// 启动定时器：delay_ms 后首次触发（0 表示尽快），之后每 interval_ms 触发（0 表示只触发一次）
+// delay_ms 为负数时停止定时器
+int reactor_timer_arm(struct ReactorTimer *t, long delay_ms, unsigned long interval_ms);
+
+// 注销并关闭定时器
+void reactor_timer_close(struct Reactor *r, struct ReactorTimer *t);
+
+// 把已设置好选项的 easy handle 交给事件循环，传输结束时调用 fn
+int reactor_transfer_add(struct Reactor *r, CURL *easy, reactor_transfer_fn fn, void *arg);
+
+// 中止传输，不调用结束回调
+void reactor_transfer_remove(struct Reactor *r, CURL *easy);
+
+// 运行事件循环，直到 reactor_stop 被调用；poll() 出错时返回 -1
+int reactor_run(struct Reactor *r);
+
+// 让 reactor_run 在本轮回调结束后返回
+void reactor_stop(struct Reactor *r);
+
+// 输出唤醒次数和回调耗时占比
+void reactor_report(const struct Reactor *r, FILE *out);
+
+#endif // REACTOR_H
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "reply_cache.h"
+#include "text_normalize.h"
+
+#define REPLY_CACHE_MAGIC 0x51594352u  // "QYCR"
+#define REPLY_CACHE_VERSION 1
+
+// 持久化文件中的单条记录
+struct cache_record {
+    char key[REPLY_CACHE_KEY_SIZE];
+    struct AIResponse response;
+    int64_t created;
+};
+
+static uint32_t hash_key(const char *key) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+int reply_cache_init(struct ReplyCache *cache, size_t capacity, time_t ttl) {
+    memset(cache, 0, sizeof(*cache));
+    cache->bucket_count = 1;
+    while (cache->bucket_count < capacity * 2) {
+        cache->bucket_count <<= 1;
+    }
+    cache->entries = calloc(capacity, sizeof(struct ReplyCacheEntry));
+    cache->buckets = malloc(cache->bucket_count * sizeof(int));
+    if (!cache->entries || !cache->buckets) {
+        fprintf(stderr, "回答缓存分配失败\n");
+        reply_cache_free(cache);
+        return -1;
+    }
+    for (size_t i = 0; i < cache->bucket_count; i++) {
+        cache->buckets[i] = -1;
+    }
+    // 空闲条目通过 next 串成链表
+    for (size_t i = 0; i < capacity; i++) {
+        cache->entries[i].next = (i + 1 < capacity) ? (int)(i + 1) : -1;
+    }
+    cache->capacity = capacity;
+    cache->free_list = capacity ? 0 : -1;
+    cache->lru_head = cache->lru_tail = -1;
+    cache->ttl = ttl;
+    return 0;
+}
+
+void reply_cache_free(struct ReplyCache *cache) {
+    free(cache->entries);
+    free(cache->buckets);
+    cache->entries = NULL;
+    cache->buckets = NULL;
+}
+
+static void lru_unlink(struct ReplyCache *cache, int idx) {
+    struct ReplyCacheEntry *e = &cache->entries[idx];
+    if (e->prev >= 0) cache->entries[e->prev].next = e->next; else cache->lru_head = e->next;
+    if (e->next >= 0) cache->entries[e->next].prev = e->prev; else cache->lru_tail = e->prev;
+}
+
+static void lru_push_front(struct ReplyCache *cache, int idx) {
+    struct ReplyCacheEntry *e = &cache->entries[idx];
+    e->prev = -1;
+    e->next = cache->lru_head;
+    if (cache->lru_head >= 0) cache->entries[cache->lru_head].prev = idx;
+    cache->lru_head = idx;
+    if (cache->lru_tail < 0) cache->lru_tail = idx;
+}
+
+static int find(struct ReplyCache *cache, const char *key, uint32_t h) {
+    for (int i = cache->buckets[h & (cache->bucket_count - 1)]; i >= 0; i = cache->entries[i].hash_next) {
+        if (strcmp(cache->entries[i].key, key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void remove_entry(struct ReplyCache *cache, int idx) {
+    struct ReplyCacheEntry *e = &cache->entries[idx];
+    int *link = &cache->buckets[hash_key(e->key) & (cache->bucket_count - 1)];
+    while (*link != idx) {
+        link = &cache->entries[*link].hash_next;
+    }
+    *link = e->hash_next;
+    lru_unlink(cache, idx);
+    e->used = 0;
+    e->next = cache->free_list;
+    cache->free_list = idx;
+    cache->count--;
+}
+
+static int is_expired(const struct ReplyCache *cache, time_t created, time_t now) {
+    return cache->ttl > 0 && now - created >= cache->ttl;
+}
+
+int reply_cache_get(struct ReplyCache *cache, const char *text, struct AIResponse *response) {
+    char key[REPLY_CACHE_KEY_SIZE];
+    if (!cache->entries || normalize_text_exact(text, key, sizeof(key)) == 0) {
+        return -1;
+    }
+
+    int idx = find(cache, key, hash_key(key));
+    if (idx < 0) {
+        cache->misses++;
+        return -1;
+    }
+    if (is_expired(cache, cache->entries[idx].created, time(NULL))) {
+        remove_entry(cache, idx);
+        cache->expired++;
+        cache->misses++;
+        cache->dirty = 1;
+        return -1;
+    }
+
+    lru_unlink(cache, idx);
+    lru_push_front(cache, idx);
+    *response = cache->entries[idx].response;
+    cache->hits++;
+    return 0;
+}
+
+static void put_key(struct ReplyCache *cache, const char *key, const struct AIResponse *response, time_t created) {
+    uint32_t h = hash_key(key);
+    int idx = find(cache, key, h);
+    if (idx >= 0) {
+        lru_unlink(cache, idx);
+    } else {
+        if (cache->free_list < 0) {
+            remove_entry(cache, cache->lru_tail);  // 淘汰最久未使用的条目
+            cache->evictions++;
+        }
+        idx = cache->free_list;
+        cache->free_list = cache->entries[idx].next;
+
+        struct ReplyCacheEntry *e = &cache->entries[idx];
+        snprintf(e->key, sizeof(e->key), "%s", key);
+        e->used = 1;
+        e->hash_next = cache->buckets[h & (cache->bucket_count - 1)];
+        cache->buckets[h & (cache->bucket_count - 1)] = idx;
+        cache->count++;
+    }
+    cache->entries[idx].response = *response;
+    cache->entries[idx].created = created;
+    lru_push_front(cache, idx);
+    cache->dirty = 1;
+}
+
+void reply_cache_put(struct ReplyCache *cache, const char *text, const struct AIResponse *response) {
+    char key[REPLY_CACHE_KEY_SIZE];
+    if (!cache->entries || cache->capacity == 0 || normalize_text_exact(text, key, sizeof(key)) == 0) {
+        return;
+    }
+    put_key(cache, key, response, time(NULL));
+}
+
+int reply_cache_save(struct ReplyCache *cache, const char *path) {
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file) {
+        fprintf(stderr, "无法写入回答缓存: %s\n", tmp_path);
+        return -1;
+    }
+
+    uint32_t header[3] = { REPLY_CACHE_MAGIC, REPLY_CACHE_VERSION, (uint32_t)cache->count };
+    int ok = fwrite(header, sizeof(header), 1, file) == 1;
+
+    // 从最久未使用的条目开始写，加载时依次插入即可恢复 LRU 顺序
+    for (int i = cache->lru_tail; ok && i >= 0; i = cache->entries[i].prev) {
+        struct cache_record rec;
+        memset(&rec, 0, sizeof(rec));
+        memcpy(rec.key, cache->entries[i].key, sizeof(rec.key));
+        rec.response = cache->entries[i].response;
+        rec.created = cache->entries[i].created;
+        ok = fwrite(&rec, sizeof(rec), 1, file) == 1;
+    }
+
+    if (fclose(file) != 0 || !ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "保存回答缓存失败: %s\n", path);
+        remove(tmp_path);
+        return -1;
+    }
+    cache->dirty = 0;
+    return 0;
+}
+
+int reply_cache_load(struct ReplyCache *cache, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return -1;  // 首次启动时没有缓存文件
+    }
+
+    uint32_t header[3];
+    if (fread(header, sizeof(header), 1, file) != 1 ||
+        header[0] != REPLY_CACHE_MAGIC || header[1] != REPLY_CACHE_VERSION) {
+        fprintf(stderr, "回答缓存文件格式不符，忽略: %s\n", path);
+        fclose(file);
+        return -1;
+    }
+
+    time_t now = time(NULL);
+    size_t loaded = 0;
+    struct cache_record rec;
+    for (uint32_t i = 0; i < header[2] && fread(&rec, sizeof(rec), 1, file) == 1; i++) {
+        rec.key[sizeof(rec.key) - 1] = '\0';
+        rec.response.msg[sizeof(rec.response.msg) - 1] = '\0';
+        rec.response.cmd[sizeof(rec.response.cmd) - 1] = '\0';
+        if (rec.key[0] && !is_expired(cache, (time_t)rec.created, now)) {
+            put_key(cache, rec.key, &rec.response, (time_t)rec.created);
+            loaded++;
+        }
+    }
+    fclose(file);
+    cache->dirty = 0;
+    printf("已从 %s 加载 %zu 条缓存回答\n", path, loaded);
+    return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef REPLY_CACHE_H
+#define REPLY_CACHE_H
+
+#include <stddef.h>
+#include <time.h>
+#include "chat.h"
+
+#define REPLY_CACHE_CAPACITY 256            // 最多缓存的回答条数
+#define REPLY_CACHE_TTL (24 * 60 * 60)      // 缓存有效期（秒），0 表示永不过期
+#define REPLY_CACHE_FILE "reply_cache.bin"  // 持久化文件，重启后预热缓存
+#define REPLY_CACHE_KEY_SIZE 256
+
+// 一条缓存：规范化后的识别文本 -> 解析后的 AI 回答
+struct ReplyCacheEntry {
+    char key[REPLY_CACHE_KEY_SIZE];
+    struct AIResponse response;
+    time_t created;   // 写入时间（墙上时间，便于跨重启判断过期）
+    int prev, next;   // LRU 双向链表，表头为最近使用
+    int hash_next;    // 哈希桶链表
+    int used;
+};
+
+// 固定容量的 LRU 缓存，全部条目在初始化时分配，之后不再申请内存
+// 只在对话阶段的单个线程中使用，不加锁
+struct ReplyCache {
+    struct ReplyCacheEntry *entries;
+    int *buckets;
+    size_t capacity;
+    size_t bucket_count;
+    size_t count;
+    int lru_head, lru_tail;
+    int free_list;
+    time_t ttl;
+    int dirty;              // 有尚未保存的修改
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long expired;
+    unsigned long evictions;
+};
+
+int reply_cache_init(struct ReplyCache *cache, size_t capacity, time_t ttl);
+void reply_cache_free(struct ReplyCache *cache);
+
+// 按原始识别文本查找（内部先做规范化），命中时复制回答并返回 0，未命中或已过期返回 -1
+// 规范化后超过 REPLY_CACHE_KEY_SIZE 的长问题不查找也不写入（键不截断，避免前缀相同的问题互相命中）
+int reply_cache_get(struct ReplyCache *cache, const char *text, struct AIResponse *response);
+
+// 写入回答，缓存已满时淘汰最久未使用的条目
+void reply_cache_put(struct ReplyCache *cache, const char *text, const struct AIResponse *response);
+
+// 持久化：保存时先写临时文件再改名，避免断电留下半个文件；加载时跳过已过期条目
+int reply_cache_save(struct ReplyCache *cache, const char *path);
+int reply_cache_load(struct ReplyCache *cache, const char *path);
+
+#endif // REPLY_CACHE_H
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ring_buffer.h"
+
+int ring_buffer_init(struct ring_buffer *rb, size_t slots, size_t frame_samples) {
+    size_t n = 1;
+    while (n < slots) {
+        n <<= 1;
+    }
+
+    rb->data = malloc(n * frame_samples * sizeof(short));
+    if (!rb->data) {
+        fprintf(stderr, "环形缓冲区分配失败\n");
+        return -1;
+    }
+    rb->slots = n;
+    rb->frame_samples = frame_samples;
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    if (sem_init(&rb->available, 0, 0) != 0) {
+        free(rb->data);
+        rb->data = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void ring_buffer_free(struct ring_buffer *rb) {
+    if (rb->data) {
+        sem_destroy(&rb->available);
+        free(rb->data);
+        rb->data = NULL;
+    }
+}
+
+short *ring_buffer_write_slot(struct ring_buffer *rb) {
+    size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    if (head - tail >= rb->slots) {
+        return NULL;  // 消费者跟不上，缓冲区已满
+    }
+    return rb->data + (head & (rb->slots - 1)) * rb->frame_samples;
+}
+
+void ring_buffer_commit(struct ring_buffer *rb) {
+    size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    atomic_store_explicit(&rb->head, head + 1, memory_order_release);
+    sem_post(&rb->available);
+}
+
+const short *ring_buffer_read_slot(struct ring_buffer *rb) {
+    while (sem_wait(&rb->available) != 0) {
+        // 被信号打断时重试
+    }
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    if (head == tail) {
+        return NULL;  // 被 ring_buffer_wakeup 唤醒
+    }
+    return rb->data + (tail & (rb->slots - 1)) * rb->frame_samples;
+}
+
+void ring_buffer_release(struct ring_buffer *rb) {
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    atomic_store_explicit(&rb->tail, tail + 1, memory_order_release);
+}
+
+size_t ring_buffer_count(struct ring_buffer *rb) {
+    return atomic_load_explicit(&rb->head, memory_order_acquire) -
+           atomic_load_explicit(&rb->tail, memory_order_acquire);
+}
+
+void ring_buffer_wakeup(struct ring_buffer *rb) {
+    sem_post(&rb->available);
+}
@@ -0,0 +1,43 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+
+// 单生产者/单消费者无锁环形缓冲区，每个槽位存放一个 period 的 PCM 数据
+// 生产者（采集线程）和消费者（VAD/录音）各自只修改自己的索引，不需要加锁
+struct ring_buffer {
+    short *data;              // 槽位数据，共 slots * frame_samples 个采样点
+    size_t slots;             // 槽位数量，必须是 2 的幂
+    size_t frame_samples;     // 每个槽位的采样点数
+    atomic_size_t head;       // 生产者写入位置（只由生产者修改）
+    atomic_size_t tail;       // 消费者读取位置（只由消费者修改）
+    sem_t available;          // 可读槽位计数，消费者无数据时在此阻塞
+};
+
+// 预分配全部槽位，slots 会向上取整为 2 的幂
+int ring_buffer_init(struct ring_buffer *rb, size_t slots, size_t frame_samples);
+
+// 释放缓冲区
+void ring_buffer_free(struct ring_buffer *rb);
+
+// 生产者：获取下一个可写槽位，缓冲区已满时返回 NULL
+short *ring_buffer_write_slot(struct ring_buffer *rb);
+
+// 生产者：提交 ring_buffer_write_slot 返回的槽位
+void ring_buffer_commit(struct ring_buffer *rb);
+
+// 消费者：阻塞等待下一个可读槽位，被 ring_buffer_wakeup 唤醒且无数据时返回 NULL
+const short *ring_buffer_read_slot(struct ring_buffer *rb);
+
+// 消费者：释放 ring_buffer_read_slot 返回的槽位
+void ring_buffer_release(struct ring_buffer *rb);
+
+// 当前已缓存的槽位数
+size_t ring_buffer_count(struct ring_buffer *rb);
+
+// 唤醒阻塞中的消费者（用于停止采集）
+void ring_buffer_wakeup(struct ring_buffer *rb);
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sensor_history.h"
+
+#define SENSOR_HISTORY_MAGIC 0x53485951u  // "QYHS"
+#define SENSOR_HISTORY_VERSION 1
+
+// 环形区描述，head 为下一条写入位置
+struct RingHeader {
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+    uint32_t period_s;
+};
+
+// 文件头，后面依次是原始、分钟、小时三个环形区的记录
+struct HistoryHeader {
+    uint32_t magic;
+    uint32_t version;
+    struct RingHeader rings[SENSOR_RES_COUNT];
+    struct SensorRollup pending[SENSOR_RES_COUNT];  // 当前未结束的分钟/小时（原始分辨率不用）
+    int64_t last_ts;
+};
+
+static const uint32_t ring_capacities[SENSOR_RES_COUNT] = {
+    SENSOR_HISTORY_RAW_CAPACITY,
+    SENSOR_HISTORY_MINUTE_CAPACITY,
+    SENSOR_HISTORY_HOUR_CAPACITY,
+};
+static const uint32_t ring_periods[SENSOR_RES_COUNT] = { 0, 60, 3600 };
+
+static int history_fd = -1;
+static size_t history_size = 0;
+static struct HistoryHeader *header = NULL;
+static struct SensorRollup *rings[SENSOR_RES_COUNT];
+static pthread_mutex_t history_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t history_file_size(void) {
+    size_t size = sizeof(struct HistoryHeader);
+    for (int i = 0; i < SENSOR_RES_COUNT; i++) {
+        size += (size_t)ring_capacities[i] * sizeof(struct SensorRollup);
+    }
+    return size;
+}
+
+static int header_valid(void) {
+    if (header->magic != SENSOR_HISTORY_MAGIC || header->version != SENSOR_HISTORY_VERSION) {
+        return 0;
+    }
+    for (int i = 0; i < SENSOR_RES_COUNT; i++) {
+        const struct RingHeader *r = &header->rings[i];
+        if (r->capacity != ring_capacities[i] || r->head >= r->capacity || r->count > r->capacity) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int sensor_history_open(const char *path) {
+    history_size = history_file_size();
+    history_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (history_fd < 0) {
+        perror("打开传感器历史文件失败");
+        return -1;
+    }
+
+    // 文件大小固定，运行多久都不会增长
+    struct stat st;
+    int fresh = fstat(history_fd, &st) != 0 || (size_t)st.st_size != history_size;
+    if (fresh && ftruncate(history_fd, history_size) != 0) {
+        perror("设置传感器历史文件大小失败");
+        close(history_fd);
+        history_fd = -1;
+        return -1;
+    }
+
+    void *base = mmap(NULL, history_size, PROT_READ | PROT_WRITE, MAP_SHARED, history_fd, 0);
+    if (base == MAP_FAILED) {
+        perror("映射传感器历史文件失败");
+        close(history_fd);
+        history_fd = -1;
+        return -1;
+    }
+    header = base;
+
+    struct SensorRollup *records = (struct SensorRollup *)(header + 1);
+    for (int i = 0; i < SENSOR_RES_COUNT; i++) {
+        rings[i] = records;
+        records += ring_capacities[i];
+    }
+
+    if (fresh || !header_valid()) {
+        memset(header, 0, sizeof(*header));
+        header->magic = SENSOR_HISTORY_MAGIC;
+        header->version = SENSOR_HISTORY_VERSION;
+        for (int i = 0; i < SENSOR_RES_COUNT; i++) {
+            header->rings[i].capacity = ring_capacities[i];
+            header->rings[i].period_s = ring_periods[i];
+        }
+        printf("新建传感器历史文件 %s（%zu KB）\n", path, history_size / 1024);
+    } else {
+        printf("已加载传感器历史：原始 %u 条，分钟 %u 条，小时 %u 条\n",
+               header->rings[SENSOR_RES_RAW].count, header->rings[SENSOR_RES_MINUTE].count,
+               header->rings[SENSOR_RES_HOUR].count);
+    }
+    return 0;
+}
+
+void sensor_history_close(void) {
+    pthread_mutex_lock(&history_lock);
+    if (header) {
+        msync(header, history_size, MS_SYNC);
+        munmap(header, history_size);
+        header = NULL;
+    }
+    if (history_fd >= 0) {
+        close(history_fd);
+        history_fd = -1;
+    }
+    pthread_mutex_unlock(&history_lock);
+}
+
+static void ring_push(enum SensorResolution res, const struct SensorRollup *rec) {
+    struct RingHeader *r = &header->rings[res];
+    rings[res][r->head] = *rec;
+    r->head = (r->head + 1) % r->capacity;
+    if (r->count < r->capacity) {
+        r->count++;
+    }
+}
+
+// 按时间顺序取第 i 条（0 为最旧）
+static const struct SensorRollup *ring_at(enum SensorResolution res, uint32_t i) {
+    const struct RingHeader *r = &header->rings[res];
+    return &rings[res][(r->head + r->capacity - r->count + i) % r->capacity];
+}
+
+// 第一条 start >= ts 的记录序号（记录按时间递增，二分查找）
+static uint32_t ring_lower_bound(enum SensorResolution res, int64_t ts) {
+    uint32_t lo = 0, hi = header->rings[res].count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (ring_at(res, mid)->start < ts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void rollup_merge(struct SensorRollup *acc, const struct SensorRollup *rec) {
+    if (acc->count == 0) {
+        *acc = *rec;
+        return;
+    }
+    if (rec->temp_min < acc->temp_min) acc->temp_min = rec->temp_min;
+    if (rec->temp_max > acc->temp_max) acc->temp_max = rec->temp_max;
+    if (rec->hum_min < acc->hum_min) acc->hum_min = rec->hum_min;
+    if (rec->hum_max > acc->hum_max) acc->hum_max = rec->hum_max;
+    acc->temp_sum += rec->temp_sum;
+    acc->hum_sum += rec->hum_sum;
+    acc->count += rec->count;
+}
+
+int sensor_history_append(time_t ts, int temperature_x10, int humidity_x10) {
+    pthread_mutex_lock(&history_lock);
+    if (!header || ts < header->last_ts) {
+        pthread_mutex_unlock(&history_lock);
+        return -1;
+    }
+    header->last_ts = ts;
+
+    struct SensorRollup rec = {
+        .start = ts,
+        .count = 1,
+        .temp_min = temperature_x10, .temp_max = temperature_x10,
+        .hum_min = humidity_x10, .hum_max = humidity_x10,
+        .temp_sum = temperature_x10, .hum_sum = humidity_x10,
+    };
+    ring_push(SENSOR_RES_RAW, &rec);
+
+    // 时间进入新的分钟/小时后，把上一段的汇总写入对应环形区
+    int hour_closed = 0;
+    for (int res = SENSOR_RES_MINUTE; res < SENSOR_RES_COUNT; res++) {
+        struct SensorRollup *acc = &header->pending[res];
+        int64_t bucket = ts - ts % ring_periods[res];
+        if (acc->count && acc->start != bucket) {
+            ring_push(res, acc);
+            acc->count = 0;
+            hour_closed |= res == SENSOR_RES_HOUR;
+        }
+        rollup_merge(acc, &rec);
+        acc->start = bucket;
+    }
+
+    // 平时的脏页交给内核定期回写，只在每小时汇总落定时主动提交一次，不逐条 fsync，避免频繁写闪存
+    if (hour_closed) {
+        msync(header, history_size, MS_ASYNC);
+    }
+    pthread_mutex_unlock(&history_lock);
+    return 0;
+}
+
+size_t sensor_history_query(enum SensorResolution res, time_t from, time_t to,
+                            struct SensorRollup *out, size_t max) {
+    size_t n = 0;
+    pthread_mutex_lock(&history_lock);
+    if (!header) {
+        pthread_mutex_unlock(&history_lock);
+        return 0;
+    }
+    uint32_t count = header->rings[res].count;
+    for (uint32_t i = ring_lower_bound(res, from); i < count && n < max; i++) {
+        const struct SensorRollup *rec = ring_at(res, i);
+        if (rec->start >= to) {
+            break;
+        }
+        out[n++] = *rec;
+    }
+    // 还没结束的分钟/小时也算在内
+    const struct SensorRollup *acc = &header->pending[res];
+    if (res != SENSOR_RES_RAW && acc->count && acc->start >= from && acc->start < to && n < max) {
+        out[n++] = *acc;
+    }
+    pthread_mutex_unlock(&history_lock);
+    return n;
+}
+
+// 选择保留范围能覆盖 from 的最细分辨率
+static enum SensorResolution pick_resolution(time_t from) {
+    for (int res = SENSOR_RES_RAW; res < SENSOR_RES_HOUR; res++) {
+        const struct RingHeader *r = &header->rings[res];
+        if (r->count > 0 && r->count < r->capacity) {
+            return res;  // 还没写满，最早的数据都在
+        }
+        if (r->count > 0 && ring_at(res, 0)->start <= from) {
+            return res;
+        }
+    }
+    return SENSOR_RES_HOUR;
+}
+
+int sensor_history_summary(time_t from, time_t to, struct SensorSummary *summary) {
+    struct SensorRollup acc = {0};
+
+    pthread_mutex_lock(&history_lock);
+    if (!header) {
+        pthread_mutex_unlock(&history_lock);
+        return -1;
+    }
+    enum SensorResolution res = pick_resolution(from);
+    uint32_t count = header->rings[res].count;
+    for (uint32_t i = ring_lower_bound(res, from); i < count; i++) {
+        const struct SensorRollup *rec = ring_at(res, i);
+        if (rec->start >= to) {
+            break;
+        }
+        rollup_merge(&acc, rec);
+    }
+    const struct SensorRollup *pending = &header->pending[res];
+    if (res != SENSOR_RES_RAW && pending->count && pending->start >= from && pending->start < to) {
+        rollup_merge(&acc, pending);
+    }
+    pthread_mutex_unlock(&history_lock);
+
+    if (acc.count == 0) {
+        return -1;
+    }
+    summary->resolution = res;
+    summary->samples = acc.count;
+    summary->temp_min = acc.temp_min;
+    summary->temp_max = acc.temp_max;
+    summary->temp_avg = acc.temp_sum / (int32_t)acc.count;
+    summary->hum_min = acc.hum_min;
+    summary->hum_max = acc.hum_max;
+    summary->hum_avg = acc.hum_sum / (int32_t)acc.count;
+    return 0;
+}
+
+int sensor_history_describe(int hours, char *msg, size_t size) {
+    struct SensorSummary s;
+    time_t now = time(NULL);
+    if (sensor_history_summary(now - (time_t)hours * 3600, now + 1, &s) != 0) {
+        return -1;
+    }
+    snprintf(msg, size, "过去%d小时温度%d.%d~%d.%d摄氏度，平均%d.%d摄氏度；湿度%d~%d%%，平均%d%%。",
+             hours, s.temp_min / 10, s.temp_min % 10, s.temp_max / 10, s.temp_max % 10,
+             s.temp_avg / 10, s.temp_avg % 10, s.hum_min / 10, s.hum_max / 10, s.hum_avg / 10);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define SENSOR_HISTORY_FILE "sensor_history.bin"  // 历史数据文件（固定大小，mmap 映射）
+#define SENSOR_HISTORY_RAW_CAPACITY 17280         // 原始采样：5 秒一条，约保留 1 天
+#define SENSOR_HISTORY_MINUTE_CAPACITY 10080      // 1 分钟汇总：保留 7 天
+#define SENSOR_HISTORY_HOUR_CAPACITY 8760         // 1 小时汇总：保留 1 年
+
+// 三种分辨率，每种是一个独立的环形区
+enum SensorResolution {
+    SENSOR_RES_RAW,
+    SENSOR_RES_MINUTE,
+    SENSOR_RES_HOUR,
+    SENSOR_RES_COUNT
+};
+
+// 一条记录：原始采样是 count 为 1 的汇总
+struct SensorRollup {
+    int64_t start;             // 时间段起点（Unix 时间，秒）
+    uint32_t count;            // 汇总的原始采样数
+    int16_t temp_min, temp_max;    // 温度 ×10
+    int16_t hum_min, hum_max;      // 湿度 ×10
+    int32_t temp_sum, hum_sum;     // 用于计算平均值
+};
+
+// 一段时间内的统计结果
+struct SensorSummary {
+    enum SensorResolution resolution;  // 实际使用的分辨率
+    uint32_t samples;          // 覆盖的原始采样数
+    int temp_min, temp_max, temp_avg;  // ×10
+    int hum_min, hum_max, hum_avg;     // ×10
+};
+
+// 打开（不存在或格式不符时新建）历史文件并映射到内存
+int sensor_history_open(const char *path);
+
+// 解除映射并关闭文件
+void sensor_history_close(void);
+
+// 追加一条采样并更新分钟、小时汇总；时间早于上一条（系统时钟回拨）时丢弃并返回 -1
+int sensor_history_append(time_t ts, int temperature_x10, int humidity_x10);
+
+// 读取 [from, to) 内指定分辨率的记录（按时间升序），返回写入 out 的条数
+size_t sensor_history_query(enum SensorResolution res, time_t from, time_t to,
+                            struct SensorRollup *out, size_t max);
+
+// 统计 [from, to) 的最小/最大/平均值，自动选择覆盖该时间段的最细分辨率；没有数据返回 -1
+int sensor_history_summary(time_t from, time_t to, struct SensorSummary *summary);
+
+// 生成“过去 N 小时”温湿度的中文描述，供对话使用；没有数据返回 -1
+int sensor_history_describe(int hours, char *msg, size_t size);
+
+#endif // SENSOR_HISTORY_H
@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "server_health.h"
+#include "http_client.h"
+
+// 断路器：可用时请求照常发出，连续失败 HEALTH_FAILURE_THRESHOLD 次后断路，
+// 断路期间调用方不再发请求，只由探测线程按指数退避探测，探测成功即恢复
+static atomic_int server_up = 1;
+static int monitoring = 0;        // 探测线程在运行（未启动时不断路）
+static int consecutive_failures = 0;
+static long probe_interval_ms = HEALTH_PROBE_MIN_MS;
+static double down_since_ms = 0;  // 本次断路的开始时间
+static double down_total_ms = 0;  // 此前各次断路的累计时长
+static unsigned long stat_failures, stat_trips, stat_probes, stat_probe_failures;
+
+static server_recover_fn recover_callback = NULL;
+static void *recover_userdata = NULL;
+static pthread_t probe_tid;
+static pthread_mutex_t health_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t health_cond = PTHREAD_COND_INITIALIZER;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// 探测响应只看状态码，内容直接丢弃
+static size_t discard_callback(void *contents, size_t size, size_t nmemb, void *userp) {
+    (void)contents; (void)userp;
+    return size * nmemb;
+}
+
+// 请求结果是否说明服务器不可用（而不是请求本身的问题）
+static int is_server_failure(CURL *curl, CURLcode result) {
+    long status = 0;
+    switch (result) {
+    case CURLE_OK:
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+        return status >= 500;
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_SEND_ERROR:
+    case CURLE_RECV_ERROR:
+    case CURLE_GOT_NOTHING:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+// 断路：之后的请求都走本地逻辑，唤醒探测线程开始探测（调用时持有 health_lock）
+static void trip_locked(const char *reason) {
+    atomic_store(&server_up, 0);
+    stat_trips++;
+    down_since_ms = now_ms();
+    probe_interval_ms = HEALTH_PROBE_MIN_MS;
+    printf("服务器不可用（%s），转入本地模式，%ld ms 后探测\n", reason, probe_interval_ms);
+    pthread_cond_signal(&health_cond);
+}
+
+void server_health_report(CURL *curl, CURLcode result) {
+    if (result == CURLE_ABORTED_BY_CALLBACK) {
+        return;
+    }
+    int failed = is_server_failure(curl, result);
+    pthread_mutex_lock(&health_lock);
+    if (!failed) {
+        consecutive_failures = 0;
+    } else {
+        stat_failures++;
+        if (++consecutive_failures >= HEALTH_FAILURE_THRESHOLD && monitoring && atomic_load(&server_up)) {
+            char reason[128];
+            snprintf(reason, sizeof(reason), "连续 %d 次失败：%s", consecutive_failures, curl_easy_strerror(result));
+            trip_locked(reason);
+        }
+    }
+    pthread_mutex_unlock(&health_lock);
+}
+
+int server_health_up(void) {
+    return atomic_load(&server_up);
+}
+
+// 等待 ms 毫秒（ms < 0 时一直等到被唤醒），调用时持有 health_lock，返回 0 表示应退出
+static int probe_wait(long ms) {
+    if (ms < 0) {
+        pthread_cond_wait(&health_cond, &health_lock);
+        return monitoring;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while (monitoring && pthread_cond_timedwait(&health_cond, &health_lock, &deadline) != ETIMEDOUT) {
+    }
+    return monitoring;
+}
+
+// 请求 /health/，服务器返回 200 时为可用
+static int probe(CURL *curl) {
+    long status = 0;
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    return res == CURLE_OK && status == 200;
+}
+
+// 服务器可用：调用恢复回调（调用时持有 health_lock，回调期间释放，其它线程照常发请求和报告结果）
+static void recovered_locked(void) {
+    if (!atomic_load(&server_up)) {
+        double down_ms = now_ms() - down_since_ms;
+        down_total_ms += down_ms;
+        consecutive_failures = 0;
+        atomic_store(&server_up, 1);
+        printf("服务器已恢复（不可用 %.1f 秒，探测 %lu 次）\n", down_ms / 1000, stat_probes);
+    }
+    if (recover_callback) {
+        pthread_mutex_unlock(&health_lock);
+        recover_callback(recover_userdata);
+        pthread_mutex_lock(&health_lock);
+    }
+}
+
+/*
+ * 探测线程：启动时先探测一次，不可用时直接从本地模式开始，可用时补发上次运行留下的语音；
+ * 之后服务器可用时休眠，断路后按 1、2、4 ... 秒的间隔（上限 HEALTH_PROBE_MAX_MS）探测 /health/
+ */
+static void *probe_thread_func(void *arg) {
+    CURL *curl = (CURL *)arg;
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discard_callback);
+
+    int ok = probe(curl);
+    pthread_mutex_lock(&health_lock);
+    stat_probes++;
+    if (ok) {
+        recovered_locked();
+    } else if (atomic_load(&server_up)) {
+        stat_probe_failures++;
+        trip_locked("启动时探测失败");
+    }
+    while (monitoring) {
+        if (atomic_load(&server_up)) {
+            probe_wait(-1);
+            continue;
+        }
+        if (!probe_wait(probe_interval_ms)) {
+            break;
+        }
+        pthread_mutex_unlock(&health_lock);
+        ok = probe(curl);
+        pthread_mutex_lock(&health_lock);
+        stat_probes++;
+        if (ok) {
+            recovered_locked();
+        } else {
+            stat_probe_failures++;
+            probe_interval_ms = probe_interval_ms * 2 < HEALTH_PROBE_MAX_MS ? probe_interval_ms * 2
+                                                                          : HEALTH_PROBE_MAX_MS;
+        }
+    }
+    pthread_mutex_unlock(&health_lock);
+    curl_easy_cleanup(curl);
+    return NULL;
+}
+
+int server_health_start(server_recover_fn on_recover, void *userdata) {
+    CURL *curl = http_client_dup_handle(HTTP_ENDPOINT_HEALTH);
+    if (!curl) {
+        fprintf(stderr, "CURL 未初始化\n");
+        return -1;
+    }
+    recover_callback = on_recover;
+    recover_userdata = userdata;
+    monitoring = 1;
+    if (pthread_create(&probe_tid, NULL, probe_thread_func, curl) != 0) {
+        fprintf(stderr, "创建服务器探测线程失败\n");
+        monitoring = 0;
+        curl_easy_cleanup(curl);
+        return -1;
+    }
+    return 0;
+}
+
+void server_health_stop(void) {
+    pthread_mutex_lock(&health_lock);
+    if (!monitoring) {
+        pthread_mutex_unlock(&health_lock);
+        return;
+    }
+    monitoring = 0;
+    pthread_cond_signal(&health_cond);
+    pthread_mutex_unlock(&health_lock);
+    pthread_join(probe_tid, NULL);
+}
+
+void server_health_get_stats(struct ServerHealthStats *stats) {
+    pthread_mutex_lock(&health_lock);
+    stats->up = atomic_load(&server_up);
+    stats->failures = stat_failures;
+    stats->trips = stat_trips;
+    stats->probes = stat_probes;
+    stats->probe_failures = stat_probe_failures;
+    stats->down_ms = down_total_ms + (stats->up ? 0 : now_ms() - down_since_ms);
+    stats->next_probe_ms = stats->up ? 0 : probe_interval_ms;
+    pthread_mutex_unlock(&health_lock);
+}
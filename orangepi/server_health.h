@@ -0,0 +1,41 @@
+#ifndef SERVER_HEALTH_H
+#define SERVER_HEALTH_H
+
+#include <curl/curl.h>
+
+#define HEALTH_FAILURE_THRESHOLD 2   // 连续失败该次数后断路（不再发请求，转入本地模式）
+#define HEALTH_PROBE_MIN_MS 1000     // 断路后第一次探测的间隔
+#define HEALTH_PROBE_MAX_MS 60000    // 探测失败后间隔倍增的上限
+
+// 健康统计
+struct ServerHealthStats {
+    int up;                        // 当前是否认为服务器可用
+    unsigned long failures;        // 计为服务器故障的请求数（连接失败、超时、5xx）
+    unsigned long trips;           // 断路次数
+    unsigned long probes;          // 探测次数
+    unsigned long probe_failures;  // 探测失败次数
+    double down_ms;                // 累计不可用时长（含当前这次）
+    long next_probe_ms;            // 断路中：下一次探测的等待时长
+};
+
+// 服务器恢复（探测成功）后在探测线程中调用，可以在其中同步补发请求
+typedef void (*server_recover_fn)(void *userdata);
+
+// 启动健康监测：请求结果经 server_health_report 计入，连续失败后断路，
+// 由后台线程按指数退避探测 /health/，成功后恢复并调用 on_recover（可为 NULL）
+// 启动时先在后台探测一次，可用时也调用 on_recover；未启动时 server_health_up 始终返回 1
+int server_health_start(server_recover_fn on_recover, void *userdata);
+
+// 停止探测线程
+void server_health_stop(void);
+
+// 服务器当前是否可用（无锁读取）；不可用时调用方应直接走本地逻辑，不发请求
+int server_health_up(void);
+
+// 记录一次请求的结果：连接失败、超时、连接中断和 5xx 计为失败，其它结果计为成功，
+// 主动取消（CURLE_ABORTED_BY_CALLBACK）不计
+void server_health_report(CURL *curl, CURLcode result);
+
+void server_health_get_stats(struct ServerHealthStats *stats);
+
+#endif // SERVER_HEALTH_H
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "spool.h"
+
+#define SPOOL_NAME_SIZE 64
+
+static char spool_dir[256];
+static int spool_ready = 0;
+static unsigned long spool_seq = 0;
+static struct SpoolStats spool_stats;
+static pthread_mutex_t spool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 从文件名 <录音时间>_<序号>.wav 中取出录音时间，不是暂存文件时返回 -1
+static long long recorded_time(const char *name) {
+    char *end;
+    long long t = strtoll(name, &end, 10);
+    size_t len = strlen(name);
+    if (end == name || *end != '_' || len < 4 || strcmp(name + len - 4, ".wav") != 0) {
+        return -1;
+    }
+    return t;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp((const char *)a, (const char *)b);
+}
+
+// 列出暂存文件，按文件名（即录音时间）排序，最多 max 个
+static int list_files(char (*names)[SPOOL_NAME_SIZE], int max) {
+    DIR *d = opendir(spool_dir);
+    if (!d) {
+        return 0;
+    }
+    int n = 0;
+    struct dirent *entry;
+    while (n < max && (entry = readdir(d))) {
+        if (recorded_time(entry->d_name) >= 0 && strlen(entry->d_name) < SPOOL_NAME_SIZE) {
+            snprintf(names[n++], SPOOL_NAME_SIZE, "%s", entry->d_name);
+        }
+    }
+    closedir(d);
+    qsort(names, n, SPOOL_NAME_SIZE, compare_names);
+    return n;
+}
+
+int spool_init(const char *dir) {
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "无法创建暂存目录 %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    char names[SPOOL_MAX_FILES][SPOOL_NAME_SIZE];
+    pthread_mutex_lock(&spool_lock);
+    snprintf(spool_dir, sizeof(spool_dir), "%s", dir);
+    spool_stats.pending = list_files(names, SPOOL_MAX_FILES);
+    spool_ready = 1;
+    pthread_mutex_unlock(&spool_lock);
+    return 0;
+}
+
+int spool_save(const struct AudioBuffer *buf) {
+    pthread_mutex_lock(&spool_lock);
+    if (!spool_ready) {
+        pthread_mutex_unlock(&spool_lock);
+        return -1;
+    }
+    if (spool_stats.pending >= SPOOL_MAX_FILES) {
+        spool_stats.full++;
+        pthread_mutex_unlock(&spool_lock);
+        fprintf(stderr, "暂存已满（%d 条），丢弃本条语音\n", SPOOL_MAX_FILES);
+        return -1;
+    }
+    char path[320], tmp_path[330];
+    snprintf(path, sizeof(path), "%s/%lld_%04lu.wav", spool_dir, (long long)time(NULL), spool_seq++ % 10000);
+    // 先写临时文件再改名：补发线程只列出 .wav 文件，不会读到写了一半的语音
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int rc = save_audio_buffer(buf, tmp_path) == 0 && rename(tmp_path, path) == 0 ? 0 : -1;
+    if (rc != 0) {
+        fprintf(stderr, "暂存语音失败: %s\n", path);
+        remove(tmp_path);
+    } else {
+        spool_stats.pending++;
+        spool_stats.saved++;
+    }
+    pthread_mutex_unlock(&spool_lock);
+    return rc;
+}
+
+int spool_replay(spool_replay_fn fn, void *userdata) {
+    char names[SPOOL_MAX_FILES][SPOOL_NAME_SIZE];
+    int n = spool_ready ? list_files(names, SPOOL_MAX_FILES) : 0;
+    int replayed = 0;
+    time_t now = time(NULL);
+
+    for (int i = 0; i < n; i++) {
+        char path[320];
+        snprintf(path, sizeof(path), "%s/%s", spool_dir, names[i]);
+        time_t recorded = (time_t)recorded_time(names[i]);
+        int expired = now - recorded > SPOOL_MAX_AGE_S;
+        if (!expired && fn(path, recorded, userdata) != 0) {
+            break;  // 服务器又不可用了，剩下的留到下次恢复
+        }
+        remove(path);
+
+        pthread_mutex_lock(&spool_lock);
+        if (spool_stats.pending > 0) {
+            spool_stats.pending--;
+        }
+        if (expired) {
+            spool_stats.expired++;
+        } else {
+            spool_stats.replayed++;
+            replayed++;
+        }
+        pthread_mutex_unlock(&spool_lock);
+    }
+    return replayed;
+}
+
+void spool_get_stats(struct SpoolStats *stats) {
+    pthread_mutex_lock(&spool_lock);
+    *stats = spool_stats;
+    pthread_mutex_unlock(&spool_lock);
+}
@@ -0,0 +1,35 @@
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#include <time.h>
+#include "audio_recognition.h"
+
+#define SPOOL_DEFAULT_DIR "spool"  // 服务器不可用时暂存语音的目录，文件名为 <录音时间>_<序号>.wav
+#define SPOOL_MAX_FILES 32         // 最多暂存的语音条数，已满时不再暂存新的语音
+#define SPOOL_MAX_AGE_S 900        // 补发时丢弃超过该时长的语音
+
+// 补发一条暂存的语音：成功返回 0（删除文件），失败返回 -1（保留文件并停止本轮补发）
+typedef int (*spool_replay_fn)(const char *path, time_t recorded, void *userdata);
+
+// 暂存统计
+struct SpoolStats {
+    unsigned long pending;   // 当前暂存的条数
+    unsigned long saved;     // 累计暂存
+    unsigned long replayed;  // 累计补发成功
+    unsigned long expired;   // 累计因过期丢弃
+    unsigned long full;      // 累计因暂存已满而丢弃
+};
+
+// 创建（或沿用）暂存目录，上次运行留下的语音在下次补发时一起处理
+int spool_init(const char *dir);
+
+// 把录音保存到暂存目录（可在任意线程调用），成功返回 0
+int spool_save(const struct AudioBuffer *buf);
+
+// 按录音时间从早到晚逐条补发，过期的直接删除；返回补发成功的条数
+// 同一时间只能有一个线程调用，补发期间其它线程仍可暂存新的语音（留到下一轮）
+int spool_replay(spool_replay_fn fn, void *userdata);
+
+void spool_get_stats(struct SpoolStats *stats);
+
+#endif // SPOOL_H
@@ -0,0 +1,91 @@
+#include <ctype.h>
+#include <string.h>
+#include "text_normalize.h"
+
+// 解码一个 UTF-8 字符，返回占用字节数；非法序列按单字节处理
+static size_t utf8_decode(const unsigned char *p, unsigned int *cp) {
+    if (p[0] < 0x80) {
+        *cp = p[0];
+        return 1;
+    }
+    if ((p[0] & 0xE0) == 0xC0 && (p[1] & 0xC0) == 0x80) {
+        *cp = ((p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+        return 2;
+    }
+    if ((p[0] & 0xF0) == 0xE0 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80) {
+        *cp = ((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+        return 3;
+    }
+    if ((p[0] & 0xF8) == 0xF0 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80 && (p[3] & 0xC0) == 0x80) {
+        *cp = ((p[0] & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+        return 4;
+    }
+    *cp = p[0];
+    return 1;
+}
+
+// 中文标点和各类空白（全角 ASCII 已在此之前折叠为半角）
+static int is_wide_punct(unsigned int cp) {
+    return (cp >= 0x2000 && cp <= 0x206F) ||  // 通用标点：— … “ ” ‘ ’ 及各种空格
+           (cp >= 0x3000 && cp <= 0x303F) ||  // CJK 标点：、。《》「」【】 及全角空格
+           (cp >= 0xFE30 && cp <= 0xFE4F) ||  // CJK 兼容形式
+           (cp >= 0xFF5F && cp <= 0xFF65) ||  // 半角 CJK 标点
+           cp == 0x00A0 || cp == 0x00B7;      // 不换行空格、间隔号
+}
+
+// 输出放不下时截断，*truncated（可为 NULL）置 1
+static size_t normalize(const char *in, char *out, size_t out_size, int *truncated) {
+    const unsigned char *p = (const unsigned char *)in;
+    size_t n = 0;
+
+    if (out_size == 0) {
+        return 0;
+    }
+    while (*p) {
+        unsigned int cp;
+        size_t len = utf8_decode(p, &cp);
+
+        // 全角 ASCII（U+FF01-U+FF5E）折叠为半角
+        if (cp >= 0xFF01 && cp <= 0xFF5E) {
+            cp -= 0xFEE0;
+        }
+
+        if (cp < 0x80) {
+            if (!isspace(cp) && !ispunct(cp)) {
+                if (n + 1 >= out_size) {
+                    if (truncated) {
+                        *truncated = 1;
+                    }
+                    break;
+                }
+                out[n++] = (char)tolower(cp);
+            }
+        } else if (!is_wide_punct(cp)) {
+            if (n + len >= out_size) {
+                if (truncated) {
+                    *truncated = 1;
+                }
+                break;
+            }
+            memcpy(out + n, p, len);
+            n += len;
+        }
+        p += len;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+size_t normalize_text(const char *in, char *out, size_t out_size) {
+    return normalize(in, out, out_size, NULL);
+}
+
+size_t normalize_text_exact(const char *in, char *out, size_t out_size) {
+    int truncated = 0;
+    size_t n = normalize(in, out, out_size, &truncated);
+    if (truncated) {
+        out[0] = '\0';
+        return 0;
+    }
+    return n;
+}
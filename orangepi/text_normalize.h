@@ -0,0 +1,14 @@
+#ifndef TEXT_NORMALIZE_H
+#define TEXT_NORMALIZE_H
+
+#include <stddef.h>
+
+// 规范化识别文本（UTF-8）：全角字符折叠为半角，去掉标点和空白，ASCII 字母转小写
+// 例如 "  开灯！" 和 "开灯。" 都得到 "开灯"；输出总以 '\0' 结尾，返回输出字节数
+size_t normalize_text(const char *in, char *out, size_t out_size);
+
+// 同 normalize_text，但输出缓冲区放不下时返回 0，不给出截断的结果
+// 用作缓存键时使用：截断后前缀相同的两个不同问题会得到同一个键
+size_t normalize_text_exact(const char *in, char *out, size_t out_size);
+
+#endif // TEXT_NORMALIZE_H
@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "trace.h"
+#include "histogram.h"
+
+#define TRACE_REPORT_SIZE 4096
+
+struct span_def {
+    const char *name;
+    enum TraceMark from;
+    enum TraceMark to;
+};
+
+static const struct span_def span_defs[SPAN_COUNT] = {
+    [SPAN_SPEECH]      = { "说话时长", TRACE_SPEECH_ONSET, TRACE_SPEECH_END },
+    [SPAN_UPLOAD_TAIL] = { "上传收尾", TRACE_SPEECH_END, TRACE_UPLOAD_END },
+    [SPAN_STT]         = { "语音识别", TRACE_UPLOAD_END, TRACE_STT_REPLY },
+    [SPAN_QUEUE]       = { "排队匹配", TRACE_STT_REPLY, TRACE_CHAT_REQUEST },
+    [SPAN_CHAT]        = { "大模型", TRACE_CHAT_REQUEST, TRACE_CHAT_REPLY },
+    [SPAN_ACTION]      = { "说完到动作", TRACE_SPEECH_END, TRACE_ACTION },
+    [SPAN_TOTAL]       = { "说完到回答", TRACE_SPEECH_END, TRACE_DONE },
+    [SPAN_GPIO]        = { "执行器", TRACE_MARK_COUNT, TRACE_MARK_COUNT },
+};
+
+static struct Histogram histograms[SPAN_COUNT];
+static atomic_uint trace_counter = 0;
+static uint32_t trace_prefix = 0;  // 每次启动随机生成，避免重启后 ID 重复
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void trace_begin(struct Trace *trace) {
+    unsigned int n = atomic_fetch_add(&trace_counter, 1);
+    if (n == 0) {
+        // 只有录音线程调用，首次调用时初始化前缀
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        trace_prefix = (uint32_t)(ts.tv_sec ^ ts.tv_nsec ^ ((uint32_t)getpid() << 16)) | 1;
+    }
+    snprintf(trace->id, sizeof(trace->id), "%08x%08x", trace_prefix, n + 1);
+    memset(trace->marks, 0, sizeof(trace->marks));
+    trace->marks[TRACE_LISTEN] = now_ns();
+}
+
+void trace_mark(struct Trace *trace, enum TraceMark mark) {
+    if (trace && trace->marks[mark] == 0) {
+        trace->marks[mark] = now_ns();
+    }
+}
+
+void trace_record_span(enum TraceSpan span, uint64_t ns) {
+    hist_record(&histograms[span], ns / 1000);
+}
+
+void trace_finish(struct Trace *trace, FILE *out) {
+    trace_mark(trace, TRACE_DONE);
+    if (out) {
+        fprintf(out, "[trace %s]", trace->id);
+    }
+    for (int i = 0; i < SPAN_COUNT; i++) {
+        const struct span_def *def = &span_defs[i];
+        if (def->from == TRACE_MARK_COUNT) {
+            continue;
+        }
+        uint64_t from = trace->marks[def->from], to = trace->marks[def->to];
+        if (from == 0 || to == 0 || to < from) {
+            continue;
+        }
+        trace_record_span(i, to - from);
+        if (out) {
+            fprintf(out, " %s %.0fms", def->name, (to - from) / 1e6);
+        }
+    }
+    if (out) {
+        fprintf(out, "\n");
+    }
+}
+
+void trace_report(FILE *out) {
+    fprintf(out, "%-12s %8s %9s %9s %9s %9s %9s\n", "区间", "次数", "平均ms", "p50", "p95", "p99", "最大");
+    for (int i = 0; i < SPAN_COUNT; i++) {
+        const struct Histogram *h = &histograms[i];
+        unsigned long total = atomic_load(&h->total);
+        if (total == 0) {
+            continue;
+        }
+        fprintf(out, "%-12s %8lu %9.1f %9.1f %9.1f %9.1f %9.1f\n", span_defs[i].name, total,
+                atomic_load(&h->sum_us) / 1e3 / total,
+                hist_percentile(h, 0.50) / 1e3, hist_percentile(h, 0.95) / 1e3,
+                hist_percentile(h, 0.99) / 1e3, atomic_load(&h->max_us) / 1e3);
+    }
+}
+
+// 发送到 Unix 数据报套接字，接收方例如：socat UNIX-RECVFROM:/tmp/qyai-trace.sock,fork -
+static int dump_to_socket(const char *path, const char *data, size_t len) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "套接字路径过长: %s\n", path);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t sent = sendto(fd, data, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+    close(fd);
+    return sent == (ssize_t)len ? 0 : -1;
+}
+
+static int dump_to_file(const char *path, const char *data, size_t len) {
+    char tmp[512];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) {
+        fprintf(stderr, "无法写入延迟统计文件: %s\n", tmp);
+        return -1;
+    }
+    size_t written = fwrite(data, 1, len, fp);
+    fclose(fp);
+    if (written != len || rename(tmp, path) != 0) {
+        fprintf(stderr, "写入延迟统计文件失败: %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int trace_dump(const char *target) {
+    char buf[TRACE_REPORT_SIZE];
+    FILE *mem = fmemopen(buf, sizeof(buf), "w");
+    if (!mem) {
+        return -1;
+    }
+    time_t now = time(NULL);
+    char when[32];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    fprintf(mem, "# 延迟统计 %s（启动以来累计）\n", when);
+    trace_report(mem);
+    long len = ftell(mem);
+    fclose(mem);
+    if (len <= 0) {
+        return -1;
+    }
+
+    if (strncmp(target, "unix:", 5) == 0) {
+        return dump_to_socket(target + 5, buf, len);
+    }
+    return dump_to_file(target, buf, len);
+}
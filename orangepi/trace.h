@@ -0,0 +1,64 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define TRACE_ID_LEN 17               // 16 位十六进制 + '\0'
+#define TRACE_HEADER "X-Trace-Id"     // 随 /stt/ 和 /chat/ 请求发给服务端，用于关联两端的日志
+#define TRACE_DEFAULT_OUTPUT "trace_stats.txt"
+
+// 每条语音经过的时间点（CLOCK_MONOTONIC），未经过的为 0
+enum TraceMark {
+    TRACE_LISTEN = 0,       // 开始等待人声
+    TRACE_SPEECH_ONSET,     // 端点检测确认开始说话
+    TRACE_SPEECH_END,       // 端点检测判定说话结束
+    TRACE_UPLOAD_START,     // 开始上传音频
+    TRACE_UPLOAD_END,       // 音频全部交给 cURL
+    TRACE_STT_REPLY,        // 收到识别结果
+    TRACE_CHAT_REQUEST,     // 发出对话请求（本地命中命令或缓存时没有）
+    TRACE_CHAT_REPLY,       // 对话回答接收完毕
+    TRACE_ACTION,           // 动作提交给执行器
+    TRACE_DONE,             // 回答已输出
+    TRACE_MARK_COUNT
+};
+
+// 统计的区间，每个区间一个直方图
+enum TraceSpan {
+    SPAN_SPEECH = 0,        // 说话时长（起点 -> 终点）
+    SPAN_UPLOAD_TAIL,       // 说完后上传剩余音频（终点 -> 上传结束）
+    SPAN_STT,               // 服务端识别及往返（上传结束 -> 识别结果）
+    SPAN_QUEUE,             // 流水线排队和本地匹配（识别结果 -> 对话请求）
+    SPAN_CHAT,              // 大模型对话（对话请求 -> 回答完毕）
+    SPAN_ACTION,            // 说完到动作提交（终点 -> 动作）
+    SPAN_TOTAL,             // 说完到回答输出（终点 -> 完成），即用户感受到的延迟
+    SPAN_GPIO,              // 执行器排队加执行，由执行线程直接记录
+    SPAN_COUNT
+};
+
+// 单条语音的追踪记录，随语音在流水线中传递
+struct Trace {
+    char id[TRACE_ID_LEN];
+    uint64_t marks[TRACE_MARK_COUNT];
+};
+
+// 开始新的追踪：生成追踪 ID，清空时间点，并记录 TRACE_LISTEN
+void trace_begin(struct Trace *trace);
+
+// 记录时间点（只记录第一次），trace 为 NULL 时不做任何事
+void trace_mark(struct Trace *trace, enum TraceMark mark);
+
+// 语音处理完毕：把各区间计入直方图，并输出一行本条语音的耗时
+void trace_finish(struct Trace *trace, FILE *out);
+
+// 直接记录一个区间的耗时（纳秒）
+void trace_record_span(enum TraceSpan span, uint64_t ns);
+
+// 输出各区间的 p50/p95/p99/最大值
+void trace_report(FILE *out);
+
+// 把 trace_report 的内容写到 target：形如 unix:/路径 时发送到该 Unix 数据报套接字
+// （没有进程监听时直接丢弃），否则先写临时文件再改名覆盖 target
+int trace_dump(const char *target);
+
+#endif // TRACE_H
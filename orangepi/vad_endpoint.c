@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vad_endpoint.h"
+
+void vad_config_default(struct VadConfig *config, int frame_ms) {
+    config->frame_ms = frame_ms;
+    config->pre_roll_ms = VAD_DEFAULT_PRE_ROLL_MS;
+    config->onset_ms = VAD_DEFAULT_ONSET_MS;
+    config->hangover_ms = VAD_DEFAULT_HANGOVER_MS;
+    config->max_utterance_ms = VAD_DEFAULT_MAX_UTTERANCE_MS;
+}
+
+// 毫秒换算为帧数，至少 1 帧
+static int ms_to_frames(const struct VadConfig *config, int ms) {
+    int frames = (ms + config->frame_ms - 1) / config->frame_ms;
+    return frames > 0 ? frames : 1;
+}
+
+int vad_endpoint_init(struct VadEndpoint *ep, Fvad *fvad, const struct VadConfig *config, size_t frame_samples) {
+    memset(ep, 0, sizeof(*ep));
+    if (config->frame_ms <= 0) {
+        fprintf(stderr, "无效的 VAD 帧长: %d ms\n", config->frame_ms);
+        return -1;
+    }
+    ep->config = *config;
+    ep->fvad = fvad;
+    ep->frame_samples = frame_samples;
+
+    // 确认人声之前的帧（包括起始阶段的人声帧）都先存放在预录缓冲区中
+    ep->pre_roll_frames = ms_to_frames(config, config->pre_roll_ms) + ms_to_frames(config, config->onset_ms);
+    ep->pre_roll = malloc(ep->pre_roll_frames * frame_samples * sizeof(short));
+    if (!ep->pre_roll) {
+        fprintf(stderr, "预录缓冲区分配失败\n");
+        return -1;
+    }
+    vad_endpoint_reset(ep);
+    return 0;
+}
+
+void vad_endpoint_free(struct VadEndpoint *ep) {
+    free(ep->pre_roll);
+    ep->pre_roll = NULL;
+}
+
+void vad_endpoint_reset(struct VadEndpoint *ep) {
+    ep->state = VAD_STATE_SILENCE;
+    ep->pre_roll_head = 0;
+    ep->pre_roll_count = 0;
+    ep->speech_run = 0;
+    ep->silence_run = 0;
+    ep->utterance_frames = 0;
+}
+
+static void pre_roll_push(struct VadEndpoint *ep, const short *frame) {
+    memcpy(ep->pre_roll + ep->pre_roll_head * ep->frame_samples, frame, ep->frame_samples * sizeof(short));
+    ep->pre_roll_head = (ep->pre_roll_head + 1) % ep->pre_roll_frames;
+    if (ep->pre_roll_count < ep->pre_roll_frames) {
+        ep->pre_roll_count++;
+    }
+}
+
+// 按时间顺序输出预录缓冲区中的全部帧
+static int pre_roll_flush(struct VadEndpoint *ep, vad_emit_fn emit, void *ctx) {
+    size_t start = (ep->pre_roll_head + ep->pre_roll_frames - ep->pre_roll_count) % ep->pre_roll_frames;
+    for (size_t i = 0; i < ep->pre_roll_count; i++) {
+        size_t idx = (start + i) % ep->pre_roll_frames;
+        if (emit(ep->pre_roll + idx * ep->frame_samples, ep->frame_samples, ctx) != 0) {
+            return -1;
+        }
+    }
+    ep->utterance_frames = ep->pre_roll_count;
+    ep->pre_roll_count = 0;
+    return 0;
+}
+
+int vad_endpoint_process(struct VadEndpoint *ep, const short *frame, vad_emit_fn emit, void *ctx) {
+    return vad_endpoint_process_gated(ep, frame, 0, emit, ctx);
+}
+
+int vad_endpoint_process_gated(struct VadEndpoint *ep, const short *frame, int silent,
+                               vad_emit_fn emit, void *ctx) {
+    // 前端已判定为静音的帧不再调用 fvad
+    int is_speech = !silent && fvad_process(ep->fvad, frame, ep->frame_samples) == 1;
+
+    if (ep->state == VAD_STATE_SILENCE) {
+        pre_roll_push(ep, frame);
+        ep->speech_run = is_speech ? ep->speech_run + 1 : 0;
+        if (ep->speech_run < ms_to_frames(&ep->config, ep->config.onset_ms)) {
+            return VAD_EVENT_NONE;
+        }
+
+        // 连续人声达到 onset，确认开始说话
+        ep->state = VAD_STATE_SPEECH;
+        ep->silence_run = 0;
+        if (pre_roll_flush(ep, emit, ctx) != 0) {
+            return -1;
+        }
+        return VAD_EVENT_START;
+    }
+
+    if (emit(frame, ep->frame_samples, ctx) != 0) {
+        return -1;
+    }
+    ep->utterance_frames++;
+    ep->silence_run = is_speech ? 0 : ep->silence_run + 1;
+
+    if (ep->silence_run >= ms_to_frames(&ep->config, ep->config.hangover_ms) ||
+        ep->utterance_frames >= ms_to_frames(&ep->config, ep->config.max_utterance_ms)) {
+        vad_endpoint_reset(ep);
+        return VAD_EVENT_END;
+    }
+    return VAD_EVENT_CONTINUE;
+}
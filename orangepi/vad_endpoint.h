@@ -0,0 +1,75 @@
+#ifndef VAD_ENDPOINT_H
+#define VAD_ENDPOINT_H
+
+#include <stddef.h>
+#include <fvad.h>
+
+// 默认端点检测参数（毫秒）
+#define VAD_DEFAULT_PRE_ROLL_MS      300    // 语音起点之前保留的音频，避免吞掉首字
+#define VAD_DEFAULT_ONSET_MS         60     // 连续多长的人声才确认开始说话
+#define VAD_DEFAULT_HANGOVER_MS      400    // 连续多长的无声才确认说话结束
+#define VAD_DEFAULT_MAX_UTTERANCE_MS 15000  // 单条语音最长时长，超过后强制结束
+
+// 端点检测参数
+struct VadConfig {
+    int frame_ms;          // 每帧时长，需与送入的 period 一致（fvad 支持 10/20/30ms）
+    int pre_roll_ms;
+    int onset_ms;
+    int hangover_ms;
+    int max_utterance_ms;
+};
+
+// 逐帧状态
+enum VadState {
+    VAD_STATE_SILENCE = 0,  // 等待人声，帧进入预录环形缓冲区
+    VAD_STATE_SPEECH,       // 说话中，帧直接输出
+};
+
+// 每帧处理后的事件
+enum VadEvent {
+    VAD_EVENT_NONE = 0,     // 仍在等待人声
+    VAD_EVENT_START,        // 确认开始说话，预录音频和当前帧已输出
+    VAD_EVENT_CONTINUE,     // 说话中，当前帧已输出
+    VAD_EVENT_END,          // 说话结束（无声超过 hangover 或达到最大时长），当前帧已输出
+};
+
+// 输出回调：按时间顺序收到属于本条语音的音频
+typedef int (*vad_emit_fn)(const short *pcm, size_t samples, void *ctx);
+
+// 基于 fvad_process() 的流式端点检测状态机
+struct VadEndpoint {
+    struct VadConfig config;
+    Fvad *fvad;
+    size_t frame_samples;
+    enum VadState state;
+
+    short *pre_roll;         // 预录环形缓冲区（预分配，覆盖 pre_roll + onset）
+    size_t pre_roll_frames;  // 环形缓冲区容量（帧）
+    size_t pre_roll_head;    // 下一个写入位置
+    size_t pre_roll_count;   // 当前缓存帧数
+
+    int speech_run;          // 连续人声帧数
+    int silence_run;         // 连续无声帧数
+    int utterance_frames;    // 本条语音已输出的帧数
+};
+
+// 默认参数
+void vad_config_default(struct VadConfig *config, int frame_ms);
+
+// 初始化状态机，预录缓冲区在此一次性分配
+int vad_endpoint_init(struct VadEndpoint *ep, Fvad *fvad, const struct VadConfig *config, size_t frame_samples);
+
+// 释放资源
+void vad_endpoint_free(struct VadEndpoint *ep);
+
+// 回到等待人声状态，丢弃预录音频
+void vad_endpoint_reset(struct VadEndpoint *ep);
+
+// 处理一帧音频，属于语音的音频通过 emit 输出；emit 返回非 0 时本函数返回 -1
+int vad_endpoint_process(struct VadEndpoint *ep, const short *frame, vad_emit_fn emit, void *ctx);
+
+// 同上，silent 为 1 时直接按无声处理，跳过 fvad（由前端能量门限判定）
+int vad_endpoint_process_gated(struct VadEndpoint *ep, const short *frame, int silent,
+                               vad_emit_fn emit, void *ctx);
+
+#endif // VAD_ENDPOINT_H
@@ -0,0 +1,61 @@
+"""
+IMA-ADPCM 解码，与香橙派端 orangepi/adpcm.c 对应（内容类型 audio/x-ima-adpcm）
+
+格式：单声道、无文件头，初始状态为 (0, 0)，每字节高 4 位是前一个采样；
+与 audioop.lin2adpcm / adpcm2lin 完全一致，有 audioop 时直接用它（C 实现），
+Python 3.13 起 audioop 被移除，可安装 audioop-lts，否则使用下面的纯 Python 实现。
+"""
+import sys
+
+try:
+    import audioop
+except ImportError:
+    audioop = None
+
+CONTENT_TYPE = "audio/x-ima-adpcm"
+
+_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8] * 2
+
+_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+
+
+def _decode_python(data, state):
+    predictor, index = state if state else (0, 0)
+    out = bytearray(len(data) * 4)
+    pos = 0
+    for byte in data:
+        for code in (byte >> 4, byte & 0x0F):
+            step = _STEP_TABLE[index]
+            vpdiff = step >> 3
+            if code & 4:
+                vpdiff += step
+            if code & 2:
+                vpdiff += step >> 1
+            if code & 1:
+                vpdiff += step >> 2
+            predictor = predictor - vpdiff if code & 8 else predictor + vpdiff
+            predictor = max(-32768, min(32767, predictor))
+            index = max(0, min(88, index + _INDEX_TABLE[code]))
+            out[pos:pos + 2] = (predictor & 0xFFFF).to_bytes(2, "little")
+            pos += 2
+    return bytes(out), (predictor, index)
+
+
+def decode(data, state=None):
+    """解码一段 ADPCM，返回 (小端 int16 PCM 字节, 新状态)；把返回的状态传给下一块即可分块连续解码"""
+    if audioop is not None:
+        pcm, state = audioop.adpcm2lin(bytes(data), 2, state)
+        if sys.byteorder == "big":
+            pcm = audioop.byteswap(pcm, 2)
+        return pcm, state
+    return _decode_python(data, state)
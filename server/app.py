@@ -1,25 +1,74 @@
-from fastapi import FastAPI, File, UploadFile
+from fastapi import FastAPI, File, UploadFile, Request, HTTPException
+from fastapi.concurrency import run_in_threadpool
+from fastapi.responses import StreamingResponse
 from pydantic import BaseModel
-from transformers import AutoTokenizer, AutoModelForCausalLM
+from transformers import AutoTokenizer, AutoModelForCausalLM, DynamicCache, TextIteratorStreamer
 import torch
+import numpy as np
+import json
+import os
+import re
+import time
+import unicodedata
+import contextvars
+import copy
+from collections import OrderedDict
+from threading import Lock, Thread
 
 import whisper
 from io import BytesIO
 
+import adpcm
+from batcher import MicroBatcher
+import whisper_trim
+from gen_intent_table import load_intents
+
 app = FastAPI(title="秋原管家对话 API")
 
+# 香橙派每条语音带一个 X-Trace-Id 请求头，服务端日志按同一 ID 输出各段耗时，便于与客户端的时间点对齐
+# 日志格式：trace=<ID> span=<名称> ms=<耗时>
+trace_id_var = contextvars.ContextVar("trace_id", default="-")
+
+
+def log_span(name, start, trace_id=None):
+    elapsed = (time.perf_counter() - start) * 1000
+    print(f"trace={trace_id or trace_id_var.get()} span={name} ms={elapsed:.1f}", flush=True)
+
+
+@app.middleware("http")
+async def trace_requests(request: Request, call_next):
+    trace_id = request.headers.get("x-trace-id", "-")
+    token = trace_id_var.set(trace_id)
+    start = time.perf_counter()
+    try:
+        response = await call_next(request)
+    finally:
+        trace_id_var.reset(token)
+    response.headers["X-Trace-Id"] = trace_id
+    # 流式接口在这里只统计到响应头发出（首字节），整段回答的耗时见客户端
+    log_span(request.url.path, start, trace_id)
+    return response
+
 # 1. 加载模型与 tokenizer
 MODEL_PATH = "./qyAI/output_full"
 device = "cuda" if torch.cuda.is_available() else "cpu"
 
 model = AutoModelForCausalLM.from_pretrained(MODEL_PATH)
 tokenizer = AutoTokenizer.from_pretrained(MODEL_PATH, trust_remote_code=True)
+tokenizer.padding_side = "left"  # 批量生成时在左侧补齐，新生成的 token 从同一位置开始
 model.to(device)
 
 
 # 加载 Whisper 模型
 whisper_model = whisper.load_model("small")  # 选择模型（tiny, base，small，medium，large）
 
+# 识别方式：trim 按实际时长计算 mel 和编码器（默认），full 为原来补齐到 30 秒的 whisper.transcribe
+WHISPER_MODE = os.environ.get("QYAI_WHISPER_MODE", "trim")
+# 可选的小模型（如 base），不超过 WHISPER_SHORT_SECONDS 的语音（大多是家电命令）用它识别
+WHISPER_SHORT_MODEL = os.environ.get("QYAI_WHISPER_SHORT_MODEL", "")
+WHISPER_SHORT_SECONDS = float(os.environ.get("QYAI_WHISPER_SHORT_SECONDS", "3"))
+whisper_short_model = whisper.load_model(WHISPER_SHORT_MODEL) if WHISPER_SHORT_MODEL else None
+
 
 # 2. 系统提示
 SYSTEM_PROMPT = (
@@ -33,6 +82,84 @@ SYSTEM_PROMPT = (
     "  请用自然语言直接回答，不要输出任何 <|…|> 标记。"
 )
 
+# 回答缓存：规范化后的问题 -> 回答，重复问题不再重新生成（QYAI_REPLY_CACHE=0 关闭）
+REPLY_CACHE_ENABLED = os.environ.get("QYAI_REPLY_CACHE", "1") != "0"
+REPLY_CACHE_CAPACITY = 1024
+REPLY_CACHE_TTL = 24 * 60 * 60  # 秒
+
+# 微批处理：并发的 /chat/ 和语音识别请求在 QYAI_BATCH_WAIT_MS 内凑成一批（最多 QYAI_BATCH_MAX_SIZE 个）
+# 一起推理（QYAI_BATCH=0 关闭，逐个处理）；流式生成（/chat/stream/、/converse/ 的回答）仍逐个处理
+BATCH_ENABLED = os.environ.get("QYAI_BATCH", "1") != "0"
+BATCH_MAX_SIZE = int(os.environ.get("QYAI_BATCH_MAX_SIZE", "8"))
+BATCH_WAIT_MS = float(os.environ.get("QYAI_BATCH_WAIT_MS", "15"))
+
+# 系统提示前缀缓存：SYSTEM_PROMPT 部分的 token 和 KV 缓存启动时算好，逐个生成的请求只 prefill 用户这一轮
+# （QYAI_PREFIX_CACHE=0 关闭）；凑成多条的批量生成左侧补齐后前缀位置不同，不使用
+PREFIX_CACHE_ENABLED = os.environ.get("QYAI_PREFIX_CACHE", "1") != "0"
+PROMPT_MAX_TOKENS = 512
+
+
+def normalize_text(text):
+    """与香橙派端 normalize_text() 一致：全角折叠为半角，去掉标点和空白，转小写"""
+    text = unicodedata.normalize("NFKC", text)
+    return "".join(ch for ch in text.lower()
+                   if not unicodedata.category(ch).startswith(("P", "Z", "C", "S")))
+
+
+class ReplyCache:
+    """带过期时间的 LRU 缓存，uvicorn 线程池中并发访问，需加锁"""
+
+    def __init__(self, capacity, ttl):
+        self.capacity = capacity
+        self.ttl = ttl
+        self.items = OrderedDict()
+        self.lock = Lock()
+        self.hits = 0
+        self.misses = 0
+
+    def get(self, key):
+        with self.lock:
+            item = self.items.get(key)
+            if item is None or time.time() - item[1] >= self.ttl:
+                self.items.pop(key, None)
+                self.misses += 1
+                return None
+            self.items.move_to_end(key)
+            self.hits += 1
+            return item[0]
+
+    def put(self, key, value):
+        with self.lock:
+            self.items[key] = (value, time.time())
+            self.items.move_to_end(key)
+            while len(self.items) > self.capacity:
+                self.items.popitem(last=False)
+
+
+reply_cache = ReplyCache(REPLY_CACHE_CAPACITY, REPLY_CACHE_TTL)
+
+# /converse/ 的本地命令匹配：与香橙派端 intent_match() 使用同一份短语表和覆盖率规则，
+# 固定家电命令不经过大模型（客户端改用 /converse/ 后不再有机会在识别和对话之间做本地匹配）
+INTENT_MIN_COVERAGE = 0.7
+CMD_RE = re.compile(r"<\|(\w+)\|>")
+_phrases, INTENT_REPLIES = load_intents(os.path.join(os.path.dirname(os.path.abspath(__file__)), "data.json"))
+INTENT_PHRASES = [(normalize_text(q), cmd) for q, cmd in _phrases if normalize_text(q)]
+
+
+def match_intent(text):
+    """命中时返回带命令标记的固定回答，否则返回 None"""
+    key = normalize_text(text)
+    best = max(((p, cmd) for p, cmd in INTENT_PHRASES if p in key), key=lambda x: len(x[0]), default=None)
+    if best is None or len(best[0]) < len(key) * INTENT_MIN_COVERAGE:
+        return None
+    return f"{INTENT_REPLIES[best[1]]}<|{best[1]}|>"
+
+
+def split_reply(reply):
+    """把回答拆成去掉命令标记的文本和第一个命令"""
+    m = CMD_RE.search(reply)
+    return CMD_RE.sub("", reply).strip(), m.group(1) if m else ""
+
 # 3. 定义请求体，只接收一个字符串
 class ChatRequest(BaseModel):
     message: str
@@ -40,60 +167,299 @@ class ChatRequest(BaseModel):
 class ChatResponse(BaseModel):
     reply: str
 
-# 4. 聊天接口
-@app.post("/chat/", response_model=ChatResponse)
-def chat(req: ChatRequest):
-    # system + user
+def build_prompt(message):
+    """拼接 system + user 对话模板"""
     msgs = [
         {"role": "system", "content": SYSTEM_PROMPT},
-        {"role": "user",   "content": req.message}
+        {"role": "user",   "content": message}
     ]
-
-    # 拼 prompt
-    prompt = tokenizer.apply_chat_template(
+    return tokenizer.apply_chat_template(
         msgs,
         tokenize=False,
         add_generation_prompt=True
     )
+
+
+class PromptPrefix:
+    """对话模板中用户消息之前的部分（system 一轮和 user 的开头），所有请求都相同"""
+    PLACEHOLDER = "\x00"
+
+    def __init__(self):
+        template = build_prompt(self.PLACEHOLDER)
+        self.text = template[:template.index(self.PLACEHOLDER)]
+        self.ids = tokenizer(self.text, add_special_tokens=False, return_tensors="pt")["input_ids"].to(device)
+        # 分开 tokenize 要与整段 tokenize 结果一致，否则前缀缓存对应的 token 与实际输入不同
+        sample = build_prompt("今天天气怎么样")
+        whole = tokenizer(sample, add_special_tokens=False)["input_ids"]
+        if whole != self.ids[0].tolist() + self.suffix_ids(sample):
+            raise ValueError("对话模板在用户消息处分开 tokenize 的结果与整段不同")
+        with torch.no_grad():
+            self.cache = model(input_ids=self.ids, past_key_values=DynamicCache(), use_cache=True).past_key_values
+
+    def suffix_ids(self, prompt):
+        return tokenizer(prompt[len(self.text):], add_special_tokens=False,
+                         max_length=PROMPT_MAX_TOKENS - self.ids.shape[-1], truncation=True)["input_ids"]
+
+    def inputs(self, message):
+        """只 tokenize 前缀之后的部分；generate 发现缓存已覆盖前缀时只对其余 token 做 prefill"""
+        suffix = torch.tensor([self.suffix_ids(build_prompt(message))], device=device)
+        input_ids = torch.cat([self.ids, suffix], dim=-1)
+        # generate 会往缓存里追加，每个请求用一份拷贝
+        return {"input_ids": input_ids, "attention_mask": torch.ones_like(input_ids),
+                "past_key_values": copy.deepcopy(self.cache)}
+
+
+def load_prompt_prefix():
+    if not PREFIX_CACHE_ENABLED:
+        return None
+    try:
+        prefix = PromptPrefix()
+    except ValueError as e:
+        print(f"不使用系统提示前缀缓存：{e}", flush=True)
+        return None
+    print(f"系统提示前缀缓存：{prefix.ids.shape[-1]} 个 token", flush=True)
+    return prefix
+
+
+prompt_prefix = load_prompt_prefix()
+
+
+def build_inputs(messages):
+    """拼 prompt 并 tokenize；messages 为列表时按最长的补齐成一批，单条时使用系统提示前缀缓存"""
+    single = messages if isinstance(messages, str) else messages[0] if len(messages) == 1 else None
+    if prompt_prefix and single is not None:
+        return prompt_prefix.inputs(single)
+    prompts = [build_prompt(m) for m in messages] if isinstance(messages, list) else build_prompt(messages)
     inputs = tokenizer(
-        prompt,
+        prompts,
         add_special_tokens=False,
-        max_length=512,
+        max_length=PROMPT_MAX_TOKENS,
         truncation=True,
+        padding=True,
         return_tensors="pt"
     )
-    inputs = {k: v.to(device) for k, v in inputs.items()}
+    return {k: v.to(device) for k, v in inputs.items()}
+
 
-    # 推理
+def generate_batch(messages):
+    """一次 generate 生成一批回答，返回与 messages 对应的回答列表"""
+    inputs = build_inputs(messages)
     with torch.no_grad():
         gen_ids = model.generate(
-            input_ids=inputs["input_ids"],
-            attention_mask=inputs["attention_mask"],
+            **inputs,
             pad_token_id=tokenizer.pad_token_id,
             max_new_tokens=256
         )
+    # 左侧补齐，新生成部分都从 prompt 长度处开始；先结束的回答后面是 pad，解码时跳过
+    gen_ids = gen_ids[:, inputs["input_ids"].shape[-1]:]
+    return tokenizer.batch_decode(gen_ids, skip_special_tokens=True)
+
+
+chat_batcher = MicroBatcher("chat", generate_batch, BATCH_MAX_SIZE, BATCH_WAIT_MS) if BATCH_ENABLED else None
+
 
-    # 切出新生成部分并解码
-    gen_ids = gen_ids[0][ inputs["input_ids"].shape[-1] : ]
-    reply = tokenizer.decode(gen_ids, skip_special_tokens=True)
+# 4. 聊天接口
+@app.post("/chat/", response_model=ChatResponse)
+def chat(req: ChatRequest):
+    key = normalize_text(req.message)
+    if REPLY_CACHE_ENABLED and key:
+        cached = reply_cache.get(key)
+        if cached is not None:
+            return ChatResponse(reply=cached)
 
+    # 推理：与其它并发请求合成一批
+    reply = chat_batcher(req.message) if chat_batcher else generate_batch([req.message])[0]
+
+    if REPLY_CACHE_ENABLED and key:
+        reply_cache.put(key, reply)
     return ChatResponse(reply=reply)
 
+
+def ndjson(obj):
+    return json.dumps(obj, ensure_ascii=False) + "\n"
+
+
+def generate_reply(message):
+    """逐段生成回答（命中缓存时一次给出），生成完后写入缓存"""
+    key = normalize_text(message)
+    if REPLY_CACHE_ENABLED and key:
+        cached = reply_cache.get(key)
+        if cached is not None:
+            yield cached
+            return
+
+    inputs = build_inputs(message)
+    streamer = TextIteratorStreamer(tokenizer, skip_prompt=True, skip_special_tokens=True)
+    worker = Thread(target=generate_to_streamer, args=(inputs, streamer))
+    worker.start()
+    parts = []
+    for piece in streamer:
+        if piece:
+            parts.append(piece)
+            yield piece
+    worker.join()
+    if REPLY_CACHE_ENABLED and key:
+        reply_cache.put(key, "".join(parts))
+
+
+# 4.1 流式聊天接口：每生成一段文本就输出一行 JSON {"delta": "..."}，
+#     最后一行为 {"done": true, "reply": "完整回答"}；客户端收到完整的 <|…|> 标记即可执行动作
+@app.post("/chat/stream/")
+def chat_stream(req: ChatRequest):
+    def events():
+        parts = []
+        for piece in generate_reply(req.message):
+            parts.append(piece)
+            yield ndjson({"delta": piece})
+        yield ndjson({"done": True, "reply": "".join(parts)})
+
+    return StreamingResponse(events(), media_type="application/x-ndjson")
+
+
+def generate_to_streamer(inputs, streamer):
+    with torch.no_grad():
+        model.generate(
+            **inputs,
+            pad_token_id=tokenizer.pad_token_id,
+            max_new_tokens=256,
+            streamer=streamer
+        )
+
+
+# 客户端在断路后定期探测，只确认服务在运行、模型已加载，不做推理
+@app.get("/health/")
+def health():
+    return {"status": "ok"}
+
+
+@app.get("/cache/stats")
+def cache_stats():
+    return {"enabled": REPLY_CACHE_ENABLED, "size": len(reply_cache.items),
+            "hits": reply_cache.hits, "misses": reply_cache.misses}
+
+
+@app.get("/batch/stats")
+def batch_stats():
+    batchers = [b for b in (chat_batcher, whisper_batcher, whisper_short_batcher) if b]
+    return {"enabled": BATCH_ENABLED, **{b.name: b.stats() for b in batchers}}
+
 # 5. 语音识别接口
 @app.post("/stt/")
 async def stt(audio: UploadFile = File(...)):
-    # 保存音频文件
     audio_bytes = await audio.read()
+
+    # 香橙派默认上传 IMA-ADPCM（16kHz 单声道，体积为 WAV 的 1/4），直接解码为 PCM
+    if audio.content_type == adpcm.CONTENT_TYPE:
+        pcm, _ = adpcm.decode(audio_bytes)
+        return {"text": await run_in_threadpool(transcribe, pcm_to_float(pcm))}
+
+    # 保存音频文件
     audio_path = "uploaded_audio.wav"
     with open(audio_path, "wb") as f:
         f.write(audio_bytes)
 
     # 使用 Whisper 进行语音识别
     audio = whisper.load_audio(audio_path)
-    audio = whisper.pad_or_trim(audio)
-    result = whisper_model.transcribe(audio, language="zh")
+    return {"text": await run_in_threadpool(transcribe, audio)}
+
+# 6. 流式语音识别接口：客户端确认人声后以 chunked 方式边录边传（16kHz 单声道）
+#    Content-Type 为 application/octet-stream 时是原始 S16LE PCM，为 audio/x-ima-adpcm 时是 ADPCM
+#    数据在说话期间就已到达服务器并逐块解码，请求体结束后立即开始识别
+@app.post("/stt/stream/")
+async def stt_stream(request: Request):
+    rate = int(request.headers.get("x-sample-rate", whisper.audio.SAMPLE_RATE))
+    if rate != whisper.audio.SAMPLE_RATE:
+        raise HTTPException(status_code=400, detail=f"只支持 {whisper.audio.SAMPLE_RATE}Hz 采样率")
+
+    audio = pcm_to_float(await read_pcm(request))
+    # 在线程池中等待识别，不阻塞事件循环，其它请求才能同时到达并合成一批
+    return {"text": await run_in_threadpool(transcribe, audio)}
+
+
+async def read_pcm(request):
+    """逐块读取 chunked 请求体并解码为 S16LE PCM（ADPCM 边收边解码）"""
+    content_type = request.headers.get("content-type", "application/octet-stream").split(";")[0].strip()
+    pcm = bytearray()
+    if content_type == adpcm.CONTENT_TYPE:
+        state = None
+        async for chunk in request.stream():
+            decoded, state = adpcm.decode(chunk, state)
+            pcm.extend(decoded)
+    else:
+        async for chunk in request.stream():
+            pcm.extend(chunk)
+    if len(pcm) % 2:
+        pcm = pcm[:-1]
+    return bytes(pcm)
+
+
+# 7. 语音对话接口：请求与 /stt/stream/ 相同，识别后在同一进程内直接生成回答，省去客户端
+#    拿到识别结果再请求 /chat/ 的一次往返。响应为 NDJSON：
+#      {"text": "识别结果"}                 识别完成后立即发出
+#      {"delta": "..."}                     与 /chat/stream/ 相同，命令标记可边生成边执行
+#      {"done": true, "text": ..., "reply": "完整回答", "msg": "去掉标记的回答", "cmd": "命令或空"}
+#    识别结果为空时不生成回答；固定家电命令按短语表直接回答，不经过大模型
+@app.post("/converse/")
+async def converse(request: Request):
+    rate = int(request.headers.get("x-sample-rate", whisper.audio.SAMPLE_RATE))
+    if rate != whisper.audio.SAMPLE_RATE:
+        raise HTTPException(status_code=400, detail=f"只支持 {whisper.audio.SAMPLE_RATE}Hz 采样率")
+
+    text = await run_in_threadpool(transcribe, pcm_to_float(await read_pcm(request)))
+    trace_id = trace_id_var.get()  # 响应体在线程池中生成，取不到请求的上下文
+
+    def events():
+        yield ndjson({"text": text})
+        parts = []
+        start = time.perf_counter()
+        intent = match_intent(text)
+        if intent:
+            parts.append(intent)
+            yield ndjson({"delta": intent})
+        elif normalize_text(text):
+            for piece in generate_reply(text):
+                parts.append(piece)
+                yield ndjson({"delta": piece})
+            log_span("chat", start, trace_id)
+        reply = "".join(parts)
+        msg, cmd = split_reply(reply)
+        yield ndjson({"done": True, "text": text, "reply": reply, "msg": msg, "cmd": cmd})
+
+    return StreamingResponse(events(), media_type="application/x-ndjson")
+
+
+def pcm_to_float(pcm):
+    """S16LE PCM 字节转为 Whisper 使用的 [-1, 1) 浮点数组"""
+    return np.frombuffer(pcm, dtype="<i2").astype(np.float32) / 32768.0
+
+
+def whisper_batcher_for(name, target):
+    """
+    每个 Whisper 模型一个工作线程：识别依赖 install_kv_cache_hooks() 挂在共享解码器上的钩子，
+    同一模型上并发推理时各线程的钩子会互相写入对方的 kv 缓存，所以关闭批处理时也经同一线程逐个识别
+    """
+    if target is None:
+        return None
+    if WHISPER_MODE == "full":
+        def run_full(audios):
+            return [target.transcribe(whisper.pad_or_trim(audio), language="zh")['text'] for audio in audios]
+        return MicroBatcher(name, run_full, 1, 0)
+    return MicroBatcher(name, lambda audios: whisper_trim.transcribe_batch(target, audios),
+                        BATCH_MAX_SIZE if BATCH_ENABLED else 1, BATCH_WAIT_MS)
+
+
+whisper_batcher = whisper_batcher_for("whisper", whisper_model)
+whisper_short_batcher = whisper_batcher_for("whisper_short", whisper_short_model if WHISPER_MODE != "full" else None)
+
 
-    # 返回识别结果
-    return {"text": result['text']}
+def transcribe(audio):
+    """对 16kHz 浮点音频进行识别，返回文本"""
+    start = time.perf_counter()
+    audio = audio[:whisper_trim.MAX_SAMPLES]  # 与 pad_or_trim 一样只识别前 30 秒
+    short = whisper_short_batcher is not None and \
+        len(audio) <= WHISPER_SHORT_SECONDS * whisper.audio.SAMPLE_RATE
+    text = (whisper_short_batcher if short else whisper_batcher)(audio)
+    log_span("whisper", start)
+    return text
 
 # 启动命令  uvicorn app:app --reload --host 0.0.0.0 --port 8000
\ No newline at end of file
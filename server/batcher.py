@@ -0,0 +1,78 @@
+"""
+推理微批处理：把短时间内到达的多个请求合并成一批，交给模型一次计算
+
+一层楼的香橙派共用一台只有 CPU 的服务器。逐个处理时每个请求都要单独付出一次调用的固定开销
+（Python 和框架调度、逐步解码时每个 token 读一遍全部权重），并发请求只能排在后面；
+合成一批后，这些开销由同时等待的请求分摊，矩阵运算也更能发挥多核。
+MicroBatcher 由一个后台线程收集请求：取到第一个后最多再等 max_wait_ms，凑满 max_batch 个立即执行；
+每个请求得到一个 Future，结果按提交顺序对应。
+"""
+import queue
+import time
+from concurrent.futures import Future
+from threading import Lock, Thread
+
+
+class MicroBatcher:
+    def __init__(self, name, run_batch, max_batch=8, max_wait_ms=15):
+        """run_batch(items) -> 结果列表，长度与 items 相同；抛出异常时该批所有请求都得到该异常"""
+        self.name = name
+        self.run_batch = run_batch
+        self.max_batch = max_batch
+        self.max_wait = max_wait_ms / 1000
+        self.pending = queue.Queue()
+        self.lock = Lock()
+        self.batches = 0
+        self.items = 0
+        self.max_seen = 0
+        self.busy_s = 0.0
+        Thread(target=self._worker, name=f"batch-{name}", daemon=True).start()
+
+    def submit(self, item):
+        """提交一个请求，返回 concurrent.futures.Future（async 接口可用 asyncio.wrap_future 等待）"""
+        future = Future()
+        self.pending.put((item, future))
+        return future
+
+    def __call__(self, item):
+        """同步提交并等待结果"""
+        return self.submit(item).result()
+
+    def _collect(self):
+        batch = [self.pending.get()]
+        deadline = time.perf_counter() + self.max_wait
+        while len(batch) < self.max_batch:
+            remaining = deadline - time.perf_counter()
+            try:
+                batch.append(self.pending.get(timeout=remaining) if remaining > 0 else self.pending.get_nowait())
+            except queue.Empty:
+                break
+        return batch
+
+    def _worker(self):
+        while True:
+            batch = self._collect()
+            items = [item for item, _ in batch]
+            start = time.perf_counter()
+            try:
+                results = self.run_batch(items)
+            except Exception as e:
+                for _, future in batch:
+                    future.set_exception(e)
+                results = None
+            elapsed = time.perf_counter() - start
+            if results is not None:
+                for (_, future), result in zip(batch, results):
+                    future.set_result(result)
+            with self.lock:
+                self.batches += 1
+                self.items += len(batch)
+                self.max_seen = max(self.max_seen, len(batch))
+                self.busy_s += elapsed
+
+    def stats(self):
+        with self.lock:
+            return {"max_batch": self.max_batch, "max_wait_ms": self.max_wait * 1000,
+                    "batches": self.batches, "items": self.items,
+                    "avg_batch": round(self.items / self.batches, 2) if self.batches else 0,
+                    "max_seen": self.max_seen, "busy_s": round(self.busy_s, 3)}
@@ -0,0 +1,91 @@
+"""
+根据 app.py 中 SYSTEM_PROMPT 列出的 <|…|> 命令生成香橙派端动作分发使用的完美哈希表 orangepi/action_hash.h
+
+用法：python gen_action_hash.py [app.py] [输出路径]
+槽位 = ((FNV-1a(命令) ^ seed) * 0x9E3779B1) 的高 ACTION_HASH_BITS 位（乘法哈希取高位扩散最好），
+脚本从 0 开始搜索第一个使所有命令落在不同槽位的 seed，与 actuator.c 中的 action_hash() 必须保持一致。
+"""
+import re
+import sys
+from pathlib import Path
+
+CMD_RE = re.compile(r"<\|(\w+)\|>")
+FNV_PRIME = 16777619
+FNV_BASIS = 2166136261
+GOLDEN = 0x9E3779B1
+
+
+def fnv1a(text):
+    h = FNV_BASIS
+    for b in text.encode("utf-8"):
+        h ^= b
+        h = (h * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def slot_of(text, seed, bits):
+    return (((fnv1a(text) ^ seed) * GOLDEN) & 0xFFFFFFFF) >> (32 - bits)
+
+
+def find_seed(cmds, bits):
+    for seed in range(1 << 24):
+        if len({slot_of(cmd, seed, bits) for cmd in cmds}) == len(cmds):
+            return seed
+    raise RuntimeError(f"{1 << bits} 个槽位内找不到完美哈希")
+
+
+def main():
+    here = Path(__file__).resolve().parent
+    app_path = Path(sys.argv[1]) if len(sys.argv) > 1 else here / "app.py"
+    out_path = Path(sys.argv[2]) if len(sys.argv) > 2 else here.parent / "orangepi" / "action_hash.h"
+
+    source = app_path.read_text(encoding="utf-8")
+    prompt = re.search(r"SYSTEM_PROMPT = \((.*?)\n\)", source, re.S).group(1)
+    cmds = list(dict.fromkeys(CMD_RE.findall(prompt)))
+
+    # 槽位数取不小于命令数两倍的 2 的幂，seed 搜索很快就能结束
+    bits = 1
+    while (1 << bits) < 2 * len(cmds):
+        bits += 1
+    size = 1 << bits
+    seed = find_seed(cmds, bits)
+    slots = [-1] * size
+    for i, cmd in enumerate(cmds):
+        slots[slot_of(cmd, seed, bits)] = i
+
+    lines = [
+        "// 由 server/gen_action_hash.py 根据 SYSTEM_PROMPT 自动生成，请勿手动修改",
+        "#ifndef ACTION_HASH_H",
+        "#define ACTION_HASH_H",
+        "",
+        "// 大模型可能输出的全部命令",
+        "enum ActionId {",
+    ]
+    lines += [f"    ACTION_{cmd.upper()}," for cmd in cmds]
+    lines += [
+        "    ACTION_COUNT",
+        "};",
+        "",
+        "static const char *const action_names[ACTION_COUNT] = {",
+    ]
+    lines += [f'    "{cmd}",' for cmd in cmds]
+    lines += [
+        "};",
+        "",
+        f"#define ACTION_HASH_SEED {seed}u",
+        f"#define ACTION_HASH_BITS {bits}",
+        "#define ACTION_HASH_SIZE (1 << ACTION_HASH_BITS)",
+        "",
+        "// 槽位 -> 命令编号，-1 表示空槽",
+        "static const signed char action_hash_slots[ACTION_HASH_SIZE] = {",
+    ]
+    lines += ["    " + ", ".join(f"{s:2d}" for s in slots[i:i + 8]) + ","
+              for i in range(0, size, 8)]
+    lines += ["};", "", "#endif // ACTION_HASH_H", ""]
+
+    out_path.write_text("\n".join(lines), encoding="utf-8")
+    print(f"已生成 {out_path}：{len(cmds)} 个命令，{size} 个槽位，seed={seed}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,89 @@
+"""
+根据 data.json 生成香橙派端本地意图匹配使用的短语表 orangepi/intent_table.h
+
+用法：python gen_intent_table.py [data.json] [输出路径]
+只收录带 <|…|> 命令标记、且没有歧义（同一句话只对应一个命令）的问句；
+每个命令的固定回答取训练数据中最短的一条回答。
+EXTRA_PHRASES 中补充了训练数据里没有的常用短句。
+"""
+import json
+import re
+import sys
+from collections import defaultdict
+from pathlib import Path
+
+CMD_RE = re.compile(r"<\|(\w+)\|>")
+
+# 训练数据中没有、但日常最常说的简短命令
+EXTRA_PHRASES = {
+    "开灯": "light_on",
+    "打开风扇": "fan_on",
+    "关空调": "ac_off",
+    "开窗户": "window_open",
+    "温度多少": "get_temperature",
+    "湿度多少": "get_humidity",
+}
+
+
+def c_string(text):
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def load_intents(data_path):
+    """返回 (短语表 [(问句, 命令)], 固定回答 {命令: 回答})，app.py 的 /converse/ 也使用同一份短语表"""
+    phrase_cmds = defaultdict(set)
+    replies = defaultdict(set)
+    with open(data_path, encoding="utf-8") as f:
+        for line in f:
+            if not line.strip():
+                continue
+            row = json.loads(line)
+            m = CMD_RE.search(row["answer"])
+            cmd = m.group(1) if m else None
+            phrase_cmds[row["question"].strip()].add(cmd)
+            if cmd:
+                replies[cmd].add(CMD_RE.sub("", row["answer"]).strip())
+
+    for q, cmd in EXTRA_PHRASES.items():
+        phrase_cmds[q].add(cmd)
+
+    # 同一问句对应多个命令、或者出现过不带命令的回答时交给大模型处理
+    phrases = sorted((q, next(iter(c))) for q, c in phrase_cmds.items()
+                     if len(c) == 1 and None not in c)
+    cmds = {cmd for _, cmd in phrases}
+    # 每个命令的固定回答取最短的一条
+    return phrases, {cmd: min(replies[cmd], key=lambda r: (len(r), r)) for cmd in cmds}
+
+
+def main():
+    here = Path(__file__).resolve().parent
+    data_path = Path(sys.argv[1]) if len(sys.argv) > 1 else here / "data.json"
+    out_path = Path(sys.argv[2]) if len(sys.argv) > 2 else here.parent / "orangepi" / "intent_table.h"
+
+    phrases, replies = load_intents(data_path)
+    cmds = sorted(replies)
+
+    lines = [
+        "// 由 server/gen_intent_table.py 根据 data.json 自动生成，请勿手动修改",
+        "#ifndef INTENT_TABLE_H",
+        "#define INTENT_TABLE_H",
+        "",
+        "// 本地意图短语：问句 -> 命令",
+        "static const struct IntentPhrase intent_phrases[] = {",
+    ]
+    lines += [f"    {{ {c_string(q)}, {c_string(cmd)} }}," for q, cmd in phrases]
+    lines += [
+        "};",
+        "",
+        "// 命中本地意图时使用的固定回答",
+        "static const struct IntentReply intent_replies[] = {",
+    ]
+    lines += [f"    {{ {c_string(cmd)}, {c_string(replies[cmd])} }}," for cmd in cmds]
+    lines += ["};", "", "#endif // INTENT_TABLE_H", ""]
+
+    out_path.write_text("\n".join(lines), encoding="utf-8")
+    print(f"已生成 {out_path}：{len(phrases)} 条短语，{len(cmds)} 个命令")
+
+
+if __name__ == "__main__":
+    main()
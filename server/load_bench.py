@@ -0,0 +1,120 @@
+"""
+服务器负载基准：模拟多台香橙派同时请求 /chat/ 或 /stt/stream/，输出吞吐和延迟分位数
+
+用法：python load_bench.py [--server http://127.0.0.1:8000] [--endpoint chat|stt]
+      [--clients 16] [--requests 200] [--wav 录音.wav] [--label batch]
+对比微批处理与逐个处理：分别以 QYAI_BATCH=1 和 QYAI_BATCH=0 启动 app.py，用同样的参数各跑一次。
+测 /chat/ 时服务器应以 QYAI_REPLY_CACHE=0 启动，否则重复的问题直接命中缓存，测不到推理。
+每个客户端一个线程、一条 keep-alive 连接，收到响应后立即发下一个请求（闭环负载）。
+"""
+import argparse
+import http.client
+import json
+import statistics
+import threading
+import time
+import wave
+from urllib.parse import urlparse
+
+QUESTIONS = [
+    "今天天气怎么样", "帮我打开客厅的灯", "给我讲个笑话", "空调调到二十六度",
+    "明天要带伞吗", "推荐一本适合睡前看的书", "现在室内湿度多少", "怎么煮出好吃的米饭",
+]
+
+
+def load_pcm(path):
+    with wave.open(path, "rb") as w:
+        if w.getframerate() != 16000 or w.getnchannels() != 1 or w.getsampwidth() != 2:
+            raise SystemExit("录音必须是 16kHz 单声道 16 位 WAV")
+        return w.readframes(w.getnframes())
+
+
+def make_request(args, pcm, n):
+    if args.endpoint == "chat":
+        body = json.dumps({"message": QUESTIONS[n % len(QUESTIONS)]}, ensure_ascii=False).encode("utf-8")
+        return "/chat/", body, {"Content-Type": "application/json"}
+    return "/stt/stream/", pcm, {"Content-Type": "application/octet-stream", "X-Sample-Rate": "16000"}
+
+
+def client(args, pcm, counter, lock, latencies, errors):
+    url = urlparse(args.server)
+    conn = http.client.HTTPConnection(url.hostname, url.port or 80, timeout=args.timeout)
+    while True:
+        with lock:
+            n = counter[0]
+            if n >= args.requests:
+                break
+            counter[0] += 1
+        path, body, headers = make_request(args, pcm, n)
+        headers["X-Trace-Id"] = f"load-{n}"
+        start = time.perf_counter()
+        try:
+            conn.request("POST", path, body=body, headers=headers)
+            response = conn.getresponse()
+            response.read()
+            ok = response.status == 200
+        except (OSError, http.client.HTTPException):
+            ok = False
+            conn.close()  # 下一个请求重新连接
+        elapsed = time.perf_counter() - start
+        with lock:
+            if ok:
+                latencies.append(elapsed)
+            else:
+                errors[0] += 1
+    conn.close()
+
+
+def percentile(values, p):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(p / 100 * len(ordered)))]
+
+
+def batch_stats(server):
+    url = urlparse(server)
+    try:
+        conn = http.client.HTTPConnection(url.hostname, url.port or 80, timeout=5)
+        conn.request("GET", "/batch/stats")
+        response = conn.getresponse()
+        return json.loads(response.read()) if response.status == 200 else None
+    except (OSError, ValueError, http.client.HTTPException):
+        return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="多客户端并发请求的吞吐和延迟基准")
+    parser.add_argument("--server", default="http://127.0.0.1:8000")
+    parser.add_argument("--endpoint", choices=["chat", "stt"], default="chat")
+    parser.add_argument("--clients", type=int, default=16, help="并发客户端数")
+    parser.add_argument("--requests", type=int, default=200, help="请求总数")
+    parser.add_argument("--wav", help="/stt/stream/ 上传的录音（16kHz 单声道 WAV），默认 2 秒静音")
+    parser.add_argument("--timeout", type=float, default=120, help="单个请求的超时（秒）")
+    parser.add_argument("--label", default="", help="输出中标注本次运行（如 batch / serial）")
+    args = parser.parse_args()
+
+    pcm = load_pcm(args.wav) if args.wav else bytes(2 * 16000 * 2)
+    counter, errors, latencies = [0], [0], []
+    lock = threading.Lock()
+    threads = [threading.Thread(target=client, args=(args, pcm, counter, lock, latencies, errors))
+               for _ in range(args.clients)]
+    start = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    wall = time.perf_counter() - start
+
+    label = f"[{args.label}] " if args.label else ""
+    print(f"{label}{args.endpoint}：{args.clients} 个客户端，成功 {len(latencies)}，失败 {errors[0]}，"
+          f"耗时 {wall:.2f} s，吞吐 {len(latencies) / wall:.2f} 请求/s")
+    if latencies:
+        ms = [x * 1000 for x in latencies]
+        print(f"{label}延迟 ms：平均 {statistics.mean(ms):.1f}  p50 {percentile(ms, 50):.1f}  "
+              f"p90 {percentile(ms, 90):.1f}  p99 {percentile(ms, 99):.1f}  最大 {max(ms):.1f}")
+    stats = batch_stats(args.server)
+    if stats is not None:
+        print(f"{label}服务器批处理统计：{json.dumps(stats, ensure_ascii=False)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,157 @@
+"""
+本地替身服务器：实现 /stt/、/stt/stream/、/chat/、/chat/stream/、/converse/，返回固定的识别结果和回答
+不加载 Whisper 和大模型，只依赖标准库，用于在开发机上对香橙派客户端做端到端的性能分析
+
+用法：python stub_server.py [--port 8765] [--text 打开灯] [--reply "好的<|light_on|>"]
+      [--stt-delay-ms 150] [--first-token-ms 200] [--token-ms 30]
+客户端：QYAI_SERVER=http://127.0.0.1:8765 ./output/loop_bench 录音.wav
+请求体会完整读完（/stt/stream/ 按 chunked 逐块读取），延迟从请求体结束开始计算，
+与真实服务器一样：说话期间上传的音频不计入识别耗时。
+"""
+import argparse
+import json
+import re
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+import adpcm
+
+REPLY_PIECE_CHARS = 4  # 流式回答每行的字数，模拟逐 token 生成
+CMD_RE = re.compile(r"<\|(\w+)\|>")
+
+
+def ndjson(obj):
+    return (json.dumps(obj, ensure_ascii=False) + "\n").encode("utf-8")
+
+
+class StubHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # 支持 keep-alive，与客户端的长连接复用一致
+    args = None
+
+    def log_message(self, fmt, *params):
+        if not self.args.quiet:
+            super().log_message(fmt, *params)
+
+    def read_body(self):
+        """读取完整的请求体，chunked 时逐块读取"""
+        if "chunked" in self.headers.get("Transfer-Encoding", "").lower():
+            body = bytearray()
+            while True:
+                size = int(self.rfile.readline().split(b";")[0].strip(), 16)
+                if size == 0:
+                    # 跳过可能的 trailer，直到空行
+                    while self.rfile.readline() not in (b"\r\n", b"\n", b""):
+                        pass
+                    return body
+                body.extend(self.rfile.read(size))
+                self.rfile.readline()  # 块末尾的 CRLF
+        length = int(self.headers.get("Content-Length", 0))
+        return self.rfile.read(length) if length else b""
+
+    def send_json(self, obj):
+        data = json.dumps(obj, ensure_ascii=False).encode("utf-8")
+        self.send_response(200)
+        self.send_header("X-Trace-Id", self.trace_id)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def send_chunk(self, data):
+        self.wfile.write(b"%x\r\n%s\r\n" % (len(data), data))
+        self.wfile.flush()
+
+    def do_GET(self):
+        if self.path.split("?")[0] != "/health/":
+            self.send_error(404)
+            return
+        self.trace_id = self.headers.get("X-Trace-Id", "-")
+        self.send_json({"status": "ok"})
+
+    def do_POST(self):
+        path = self.path.split("?")[0]
+        start = time.perf_counter()
+        body = self.read_body()
+        args = self.args
+        self.trace_id = self.headers.get("X-Trace-Id", "-")
+
+        if path in ("/stt/", "/stt/stream/", "/converse/"):
+            samples = self.count_samples(path, body)
+            time.sleep(args.stt_delay_ms / 1000)
+            if not args.quiet:
+                print(f"识别：收到 {len(body)} 字节（{samples / 16000:.2f} 秒音频）")
+            if path == "/converse/":
+                # 识别和对话在同一个请求中完成：先发识别结果，再按 /chat/stream/ 的节奏发回答
+                self.start_ndjson()
+                self.send_chunk(ndjson({"text": args.text}))
+                self.stream_reply()
+                m = CMD_RE.search(args.reply)
+                self.send_chunk(ndjson({"done": True, "text": args.text, "reply": args.reply,
+                                        "msg": CMD_RE.sub("", args.reply).strip(), "cmd": m.group(1) if m else ""}))
+                self.send_chunk(b"")
+            else:
+                self.send_json({"text": args.text})
+        elif path == "/chat/":
+            time.sleep((args.first_token_ms + args.token_ms * len(self.pieces())) / 1000)
+            self.send_json({"reply": args.reply})
+        elif path == "/chat/stream/":
+            self.start_ndjson()
+            self.stream_reply()
+            self.send_chunk(ndjson({"done": True, "reply": args.reply}))
+            self.send_chunk(b"")
+        else:
+            self.send_error(404)
+            return
+        if not args.quiet:
+            # 与 app.py 相同的格式，便于按追踪 ID 与客户端日志对齐
+            print(f"trace={self.trace_id} span={path} ms={(time.perf_counter() - start) * 1000:.1f}", flush=True)
+
+    def start_ndjson(self):
+        self.send_response(200)
+        self.send_header("X-Trace-Id", self.trace_id)
+        self.send_header("Content-Type", "application/x-ndjson")
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+
+    def stream_reply(self):
+        time.sleep(self.args.first_token_ms / 1000)
+        for piece in self.pieces():
+            self.send_chunk(ndjson({"delta": piece}))
+            time.sleep(self.args.token_ms / 1000)
+
+    def count_samples(self, path, body):
+        """估算音频时长：ADPCM 每字节 2 个采样，PCM 每采样 2 字节（multipart 时包含表单开销，仅供参考）"""
+        content_type = self.headers.get("Content-Type", "")
+        if path in ("/stt/stream/", "/converse/") and content_type.startswith(adpcm.CONTENT_TYPE):
+            return len(body) * 2
+        if adpcm.CONTENT_TYPE.encode() in body[:1024]:
+            return len(body) * 2
+        return len(body) // 2
+
+    def pieces(self):
+        reply = self.args.reply
+        return [reply[i:i + REPLY_PIECE_CHARS] for i in range(0, len(reply), REPLY_PIECE_CHARS)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="香橙派客户端的本地替身服务器")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8765)
+    parser.add_argument("--text", default="今天天气怎么样", help="/stt/ 返回的识别结果")
+    parser.add_argument("--reply", default="好的，已为您打开灯<|light_on|>", help="/chat/ 返回的回答")
+    parser.add_argument("--stt-delay-ms", type=float, default=150, help="请求体结束到返回识别结果的延迟")
+    parser.add_argument("--first-token-ms", type=float, default=200, help="对话首个 token 的延迟")
+    parser.add_argument("--token-ms", type=float, default=30, help="之后每行回答的间隔")
+    parser.add_argument("--quiet", action="store_true", help="不输出请求日志")
+    StubHandler.args = parser.parse_args()
+
+    server = ThreadingHTTPServer((StubHandler.args.host, StubHandler.args.port), StubHandler)
+    print(f"替身服务器监听 http://{StubHandler.args.host}:{StubHandler.args.port}")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,61 @@
+"""
+首 token 延迟基准：逐个请求 /chat/stream/，统计从发出请求到收到第一行 {"delta"} 的时间（TTFT）
+
+用法：python ttft_bench.py [--server http://127.0.0.1:8000] [--rounds 5] [--label prefix]
+对比系统提示前缀缓存：分别以 QYAI_PREFIX_CACHE=1 和 QYAI_PREFIX_CACHE=0 启动 app.py，各跑一次。
+服务器应以 QYAI_REPLY_CACHE=0 启动（否则重复的问题直接命中回答缓存）；请求逐个发出，不受微批处理影响。
+"""
+import argparse
+import http.client
+import json
+import statistics
+import time
+from urllib.parse import urlparse
+
+from load_bench import QUESTIONS, percentile
+
+
+def ask(conn, message):
+    """返回 (首 token 延迟, 整段回答耗时)，单位秒"""
+    body = json.dumps({"message": message}, ensure_ascii=False).encode("utf-8")
+    start = time.perf_counter()
+    conn.request("POST", "/chat/stream/", body=body, headers={"Content-Type": "application/json"})
+    response = conn.getresponse()
+    if response.status != 200:
+        response.read()
+        raise http.client.HTTPException(f"HTTP {response.status}")
+    ttft = None
+    for line in response:
+        if ttft is None and b'"delta"' in line:
+            ttft = time.perf_counter() - start
+    total = time.perf_counter() - start
+    return (ttft if ttft is not None else total), total
+
+
+def main():
+    parser = argparse.ArgumentParser(description="/chat/stream/ 首 token 延迟基准")
+    parser.add_argument("--server", default="http://127.0.0.1:8000")
+    parser.add_argument("--rounds", type=int, default=5, help="问题列表重复的轮数")
+    parser.add_argument("--label", default="", help="输出中标注本次运行（如 prefix / no-prefix）")
+    args = parser.parse_args()
+
+    url = urlparse(args.server)
+    conn = http.client.HTTPConnection(url.hostname, url.port or 80, timeout=120)
+    ask(conn, QUESTIONS[0])  # 预热
+    ttfts, totals = [], []
+    for _ in range(args.rounds):
+        for message in QUESTIONS:
+            ttft, total = ask(conn, message)
+            ttfts.append(ttft * 1000)
+            totals.append(total * 1000)
+    conn.close()
+
+    label = f"[{args.label}] " if args.label else ""
+    print(f"{label}{len(ttfts)} 个请求")
+    print(f"{label}首 token ms：平均 {statistics.mean(ttfts):.1f}  p50 {percentile(ttfts, 50):.1f}  "
+          f"p90 {percentile(ttfts, 90):.1f}  最小 {min(ttfts):.1f}")
+    print(f"{label}整段回答 ms：平均 {statistics.mean(totals):.1f}  p50 {percentile(totals, 50):.1f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,93 @@
+"""
+Whisper 识别耗时基准：对比补齐到 30 秒的 whisper.transcribe（full）和按时长裁剪的 whisper_trim（trim）
+对每个模型、每种语音时长输出耗时、实时率 RTF（识别耗时 / 语音时长）和加速比
+
+用法：python whisper_bench.py [--models small base] [--lengths 1 2 3 5 10 20] [--wav 录音.wav]
+      [--repeat 3] [--threads 4]
+--wav 给出的录音按各时长截取（不足时循环拼接）；不给时用合成的调频音，只能比较耗时，识别结果无意义。
+默认在 CPU 上运行（--device cuda 可改用 GPU），每种组合先预热一次，取 --repeat 次的中位数。
+"""
+import argparse
+import statistics
+import time
+
+import numpy as np
+import torch
+import whisper
+from whisper.audio import SAMPLE_RATE
+
+import whisper_trim
+
+
+def synthetic_audio(seconds):
+    """类似语音的合成信号：100~300Hz 调频基音加谐波，每 0.25 秒一个音节包络"""
+    t = np.arange(int(seconds * SAMPLE_RATE)) / SAMPLE_RATE
+    f0 = 200 + 100 * np.sin(2 * np.pi * 0.7 * t)
+    phase = 2 * np.pi * np.cumsum(f0) / SAMPLE_RATE
+    voice = sum(np.sin(k * phase) / k for k in range(1, 6))
+    envelope = np.clip(np.sin(2 * np.pi * 2 * t), 0, None)
+    return (0.1 * voice * envelope).astype(np.float32)
+
+
+def clip(source, seconds):
+    n = int(seconds * SAMPLE_RATE)
+    if source is None:
+        return synthetic_audio(seconds)
+    return np.resize(source, n)  # 不足时循环拼接
+
+
+def run_full(model, audio):
+    return model.transcribe(whisper.pad_or_trim(audio), language="zh")["text"]
+
+
+def run_trim(model, audio):
+    return whisper_trim.transcribe(model, audio)
+
+
+def measure(fn, model, audio, repeat):
+    text = fn(model, audio)  # 预热
+    times = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        fn(model, audio)
+        times.append(time.perf_counter() - start)
+    return statistics.median(times), text
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Whisper 按时长裁剪识别的耗时基准")
+    parser.add_argument("--models", nargs="+", default=["small"], help="要比较的模型（tiny、base、small ...）")
+    parser.add_argument("--lengths", nargs="+", type=float, default=[1, 2, 3, 5, 10, 20], help="语音时长（秒）")
+    parser.add_argument("--wav", help="用于截取的录音，不给时使用合成音频")
+    parser.add_argument("--repeat", type=int, default=3, help="每种组合计时的次数")
+    parser.add_argument("--threads", type=int, default=0, help="torch 线程数，0 为默认")
+    parser.add_argument("--device", default="cpu")
+    parser.add_argument("--no-full", action="store_true", help="只测 trim（full 在 CPU 上较慢）")
+    args = parser.parse_args()
+
+    if args.threads > 0:
+        torch.set_num_threads(args.threads)
+    source = whisper.load_audio(args.wav) if args.wav else None
+    if source is None:
+        print("未指定 --wav，使用合成音频：只比较耗时，识别结果没有意义")
+    print(f"设备 {args.device}，torch 线程 {torch.get_num_threads()}，每项取 {args.repeat} 次中位数\n")
+
+    print(f"{'模型':<8}{'时长s':>6}{'full s':>9}{'full RTF':>10}{'trim s':>9}{'trim RTF':>10}{'加速':>7}  trim 结果")
+    for name in args.models:
+        model = whisper.load_model(name, device=args.device)
+        for seconds in args.lengths:
+            audio = clip(source, seconds)
+            trim_s, text = measure(run_trim, model, audio, args.repeat)
+            if args.no_full:
+                full_col = f"{'-':>9}{'-':>10}"
+                speedup = "-"
+            else:
+                full_s, _ = measure(run_full, model, audio, args.repeat)
+                full_col = f"{full_s:>9.3f}{full_s / seconds:>10.3f}"
+                speedup = f"{full_s / trim_s:.1f}x"
+            print(f"{name:<8}{seconds:>6.1f}{full_col}{trim_s:>9.3f}{trim_s / seconds:>10.3f}{speedup:>7}  {text}")
+        del model
+
+
+if __name__ == "__main__":
+    main()
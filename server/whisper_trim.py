@@ -0,0 +1,132 @@
+"""
+按语音实际时长计算的 Whisper 识别（app.py 的 /stt/、/stt/stream/、/converse/ 使用）
+
+whisper.transcribe 总是把音频补齐到 30 秒，1 秒的“开灯”也要让编码器算满 1500 帧。
+这里只取实际时长（补一小段静音）的 mel，编码器只截取对应长度的位置编码，
+解码用贪心搜索，输出 token 数按时长设上限；不做温度回退和束搜索。
+编码器的代价与帧数成正比（自注意力部分为平方），短语音的识别耗时大幅缩短。
+
+与 whisper.transcribe 一样，no_speech 概率高且平均对数概率低时视为没有人声，返回空文本。
+与原来的 pad_or_trim 一样，超过 30 秒的音频只识别前 30 秒（MAX_SAMPLES）。
+"""
+import numpy as np
+import torch
+import torch.nn.functional as F
+import whisper
+from whisper.audio import HOP_LENGTH, N_SAMPLES, SAMPLE_RATE
+from whisper.tokenizer import get_tokenizer
+
+MAX_SAMPLES = N_SAMPLES          # 30 秒，窗口和位置编码的上限
+TAIL_PAD_SECONDS = 0.5           # 末尾补的静音，模型更容易在句末输出结束符
+MIN_SECONDS = 1.0                # 补静音后的最短时长，过短的窗口识别不稳定
+TOKENS_PER_SECOND = 12           # 输出 token 上限按时长估算（中文约每秒 4~6 字，每字 1~2 个 token）
+MIN_TOKENS = 16
+MAX_TOKENS = 224                 # 与 Whisper 解码器的 n_text_ctx / 2 相同
+NO_SPEECH_THRESHOLD = 0.6        # 与 whisper.transcribe 的默认值相同
+LOGPROB_THRESHOLD = -1.0
+
+_tokenizers = {}
+_suppress = {}
+
+
+def _tokenizer(model, language):
+    key = (id(model), language)
+    if key not in _tokenizers:
+        tokenizer = get_tokenizer(model.is_multilingual, num_languages=model.num_languages,
+                                  language=language, task="transcribe")
+        # 解码时屏蔽全部特殊 token（时间戳、语言等，结束符除外）和非语音符号
+        suppress = torch.zeros(model.dims.n_vocab, dtype=torch.bool)
+        suppress[tokenizer.eot + 1:] = True
+        suppress[list(tokenizer.non_speech_tokens)] = True
+        _tokenizers[key] = tokenizer
+        _suppress[key] = suppress.to(model.device)
+    return _tokenizers[key], _suppress[key]
+
+
+def padded_samples(samples):
+    """识别窗口的采样数：实际时长加末尾静音，不短于 MIN_SECONDS，取 2 帧（20ms）的整数倍"""
+    target = max(samples + int(TAIL_PAD_SECONDS * SAMPLE_RATE), int(MIN_SECONDS * SAMPLE_RATE))
+    step = 2 * HOP_LENGTH  # 编码器第二个卷积步长为 2
+    return min((target + step - 1) // step * step, MAX_SAMPLES)
+
+
+def token_limit(samples):
+    seconds = samples / SAMPLE_RATE
+    return min(MAX_TOKENS, max(MIN_TOKENS, int(seconds * TOKENS_PER_SECOND)))
+
+
+def encode(model, mel):
+    """与 AudioEncoder.forward 相同，但位置编码只取前 n 帧（原实现要求正好 1500 帧）"""
+    encoder = model.encoder
+    x = F.gelu(encoder.conv1(mel))
+    x = F.gelu(encoder.conv2(x))
+    x = x.permute(0, 2, 1)
+    x = (x + encoder.positional_embedding[: x.shape[1]]).to(x.dtype)
+    for block in encoder.blocks:
+        x = block(x)
+    return encoder.ln_post(x)
+
+
+def transcribe(model, audio, language="zh"):
+    """识别 16kHz 浮点音频（不超过 30 秒），返回文本"""
+    return transcribe_batch(model, [audio], language)[0]
+
+
+@torch.no_grad()
+def transcribe_batch(model, audios, language="zh"):
+    """
+    一次识别多段音频，返回与之对应的文本列表
+    各段补静音到其中最长的窗口后一起编码，解码时每步为所有未结束的语音各生成一个 token；
+    已输出结束符（或达到自身 token 上限）的语音之后只送入结束符，结果不再变化
+    """
+    audios = [np.asarray(audio, dtype=np.float32)[:MAX_SAMPLES] for audio in audios]
+    texts = [""] * len(audios)
+    live = [i for i, audio in enumerate(audios) if len(audio) > 0]
+    if not live:
+        return texts
+    window = padded_samples(max(len(audios[i]) for i in live))
+    mel = torch.stack([whisper.log_mel_spectrogram(whisper.pad_or_trim(audios[i], window), model.dims.n_mels)
+                       for i in live]).to(model.device)
+    audio_features = encode(model, mel)
+
+    tokenizer, suppress = _tokenizer(model, language)
+    n = len(live)
+    limits = [token_limit(len(audios[i])) for i in live]
+    tokens = [[] for _ in range(n)]
+    logprob_sums = [0.0] * n
+    no_speech_probs = [0.0] * n
+    done = [False] * n
+    kv_cache, hooks = model.install_kv_cache_hooks()
+    try:
+        x = torch.tensor([list(tokenizer.sot_sequence_including_notimestamps)] * n, device=model.device)
+        for step in range(max(limits)):
+            logits = model.decoder(x, audio_features, kv_cache=kv_cache)
+            if step == 0:
+                no_speech_probs = logits[:, 0].softmax(-1)[:, tokenizer.no_speech].tolist()
+            logits = logits[:, -1]
+            logits[:, suppress] = -np.inf
+            if step == 0:
+                logits[:, tokenizer.eot] = -np.inf  # 第一个 token 不允许直接结束
+            logprobs = F.log_softmax(logits, dim=-1)
+            next_tokens = logits.argmax(dim=-1).tolist()
+            for j, token in enumerate(next_tokens):
+                if done[j] or token == tokenizer.eot:
+                    done[j] = True
+                    next_tokens[j] = tokenizer.eot
+                    continue
+                tokens[j].append(token)
+                logprob_sums[j] += logprobs[j, token].item()
+                done[j] = len(tokens[j]) >= limits[j]
+            if all(done):
+                break
+            x = torch.tensor(next_tokens, device=model.device).unsqueeze(1)  # 之后只送入新 token，其余来自 kv 缓存
+    finally:
+        for hook in hooks:
+            hook.remove()
+
+    for j, i in enumerate(live):
+        avg_logprob = logprob_sums[j] / max(len(tokens[j]), 1)
+        if no_speech_probs[j] > NO_SPEECH_THRESHOLD and avg_logprob < LOGPROB_THRESHOLD:
+            continue
+        texts[i] = tokenizer.decode(tokens[j]).strip()
+    return texts